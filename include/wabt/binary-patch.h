@@ -0,0 +1,68 @@
+/*
+ * Copyright 2026 WebAssembly Community Group participants
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef WABT_BINARY_PATCH_H_
+#define WABT_BINARY_PATCH_H_
+
+#include <cstdint>
+#include <vector>
+
+#include "wabt/common.h"
+#include "wabt/error.h"
+
+namespace wabt {
+
+struct ReadBinaryOptions;
+
+// A patch rebuilds a new version of a module from the old one. It starts
+// with the SHA-256 digests of both versions, the size of the new one and a
+// table that maps old function indices to new ones, stored as runs of
+// indices that moved by the same amount. The rest is a list of commands,
+// each appending to the new module:
+//
+//   literal SIZE BYTES       SIZE bytes stored in the patch
+//   copy OFFSET SIZE         SIZE bytes of the old module at OFFSET
+//   funcs INDEX COUNT        the bodies of COUNT old functions from INDEX on,
+//                            with the function index of each call,
+//                            return_call and ref.func mapped to the new one
+//   section INDEX            the contents of the old section with the
+//                            section index INDEX, with the function indices
+//                            of its exports, start function, elem segments
+//                            and ref.func init expressions mapped
+//
+// Unchanged sections and data segments are copied, as are the start and end
+// that a changed one has in common with its old version. Unchanged function
+// bodies, and sections that only differ by their function indices, are
+// rebuilt from the old module. Everything else is a literal. The patch is
+// only used for an item when rebuilding it gives exactly the bytes of the
+// new module, so applying a patch always gives the new module bit for bit;
+// a patch that would write past the size of the new module is rejected.
+
+Result CreateBinaryPatch(const std::vector<uint8_t>& old_data,
+                         const std::vector<uint8_t>& new_data,
+                         const ReadBinaryOptions& options,
+                         std::vector<uint8_t>* patch,
+                         Errors* errors);
+
+Result ApplyBinaryPatch(const std::vector<uint8_t>& old_data,
+                        const std::vector<uint8_t>& patch,
+                        const ReadBinaryOptions& options,
+                        std::vector<uint8_t>* new_data,
+                        Errors* errors);
+
+}  // namespace wabt
+
+#endif /* WABT_BINARY_PATCH_H_ */
@@ -0,0 +1,79 @@
+/*
+ * Copyright 2026 WebAssembly Community Group participants
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef WABT_BINARY_READER_HASH_H_
+#define WABT_BINARY_READER_HASH_H_
+
+#include <string>
+#include <vector>
+
+#include "wabt/common.h"
+
+namespace wabt {
+
+struct ReadBinaryOptions;
+
+// A function index: an immediate of call, return_call or ref.func, an elem
+// segment entry, an export or the start function.
+struct BinaryFuncRef {
+  Offset offset;
+  Offset end;
+  Index func_index;
+};
+
+// A part of a binary module that is hashed separately: a function body, a
+// data segment, a custom section, or one of the other known sections as a
+// whole.
+struct BinaryItemHash {
+  enum class Kind {
+    Section,
+    Function,
+    DataSegment,
+    CustomSection,
+  };
+
+  Kind kind;
+  // Identifies the item across two versions of a module. For functions and
+  // data segments this is the debug name ("$name"), else for functions the
+  // export ("export:name") or import ("import:module.field") name, else the
+  // index ("#index"). For sections it is the section name; repeated custom
+  // section names get "#N" appended.
+  std::string key;
+  Index index;         // Function, data segment or section index.
+  Offset offset;       // Start of the item's bytes in the module.
+  Offset size;         // Size of the item's bytes.
+  std::string digest;  // Raw SHA-256 digest of the normalized bytes.
+  // The function indices in a function body, or in the export, start, elem,
+  // global or table section.
+  std::vector<BinaryFuncRef> func_refs;
+};
+
+const char* GetBinaryItemKindName(BinaryItemHash::Kind);
+
+// Function bodies are hashed with the immediates of call, return_call and
+// ref.func replaced by the callee's key, so a body that only changed because
+// other functions were renumbered keeps its hash. Other indices are hashed
+// as they are. If |func_keys| is given, it is set to the keys of all
+// functions, including the imported ones.
+Result ReadBinaryHashes(const void* data,
+                        size_t size,
+                        const ReadBinaryOptions& options,
+                        std::vector<BinaryItemHash>* items,
+                        std::vector<std::string>* func_keys = nullptr);
+
+}  // namespace wabt
+
+#endif /* WABT_BINARY_READER_HASH_H_ */
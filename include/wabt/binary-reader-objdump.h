@@ -19,7 +19,9 @@
 
 #include <map>
 #include <string>
+#include <vector>
 
+#include "wabt/binary.h"
 #include "wabt/common.h"
 #include "wabt/feature.h"
 #include "wabt/stream.h"
@@ -49,6 +51,10 @@ struct ObjdumpOptions {
   ObjdumpMode mode;
   const char* filename;
   const char* section_name;
+  // Names or indices of the functions to disassemble; all if empty.
+  std::vector<std::string> functions;
+  // Number of threads to disassemble function bodies with.
+  int jobs;
 };
 
 struct ObjdumpSymbol {
@@ -71,6 +77,24 @@ struct ObjdumpLocalNames {
   std::map<std::pair<Index, Index>, std::string> names;
 };
 
+// The location of a section, recorded by the prepass so that later passes can
+// go straight to it.
+struct ObjdumpSection {
+  BinarySection code;
+  std::string name;  // Only set for custom sections.
+  Offset offset;     // Start of the section contents.
+  Offset size;
+  // Entry count of a known section, or the function index for the Start
+  // section.
+  Index count;
+};
+
+struct ObjdumpFunctionBody {
+  Index func_index;
+  Offset offset;  // Start of the body, just after its size.
+  Offset size;
+};
+
 // read_binary_objdump uses this state to store information from previous runs
 // and use it to display more useful information.
 struct ObjdumpState {
@@ -87,6 +111,11 @@ struct ObjdumpState {
   std::vector<ObjdumpSymbol> symtab;
   std::map<Index, Index> function_param_counts;
   std::map<Index, Index> function_types;
+  std::vector<ObjdumpSection> sections;
+  std::vector<ObjdumpFunctionBody> function_bodies;
+  // True if the prepass read the whole module, so |sections| and
+  // |function_bodies| can be used instead of reading it again.
+  bool index_complete = false;
 };
 
 Result ReadBinaryObjdump(const uint8_t* data,
@@ -18,6 +18,9 @@
 #define WABT_BINARY_READER_OPCNT_H_
 
 #include <map>
+#include <string>
+#include <unordered_map>
+#include <utility>
 #include <vector>
 
 #include "wabt/common.h"
@@ -53,8 +56,11 @@ class OpcodeInfo {
   OpcodeInfo(Opcode, Kind, T* data, size_t count, T extra);
 
   Opcode opcode() const { return opcode_; }
+  size_t Hash() const;
 
   void Write(Stream&);
+  // Writes just the immediates, each preceded by a space.
+  void WriteImmediates(Stream&);
 
  private:
   template <typename T>
@@ -84,12 +90,55 @@ bool operator<=(const OpcodeInfo&, const OpcodeInfo&);
 bool operator>(const OpcodeInfo&, const OpcodeInfo&);
 bool operator>=(const OpcodeInfo&, const OpcodeInfo&);
 
-using OpcodeInfoCounts = std::map<OpcodeInfo, size_t>;
+struct OpcodeInfoHash {
+  size_t operator()(const OpcodeInfo& info) const { return info.Hash(); }
+};
+
+using OpcodeInfoCounts =
+    std::unordered_map<OpcodeInfo, uint64_t, OpcodeInfoHash>;
+
+constexpr size_t kOpcodeCount = Opcode::Invalid;
+
+// Opcode counts, summed over every module read. Each count is weighted by the
+// execution count of the function it is in, if given.
+struct OpcodeStats {
+  OpcodeStats();
+
+  uint64_t total = 0;
+  // Indexed by Opcode::Enum.
+  std::vector<uint64_t> counts;
+  // The counts of opcodes without immediates; the others are counted in
+  // |counts_with_immediates| instead, once for each value of the immediates.
+  std::vector<uint64_t> bare_counts;
+  OpcodeInfoCounts counts_with_immediates;
+  // Counts of each opcode followed by another in the same function, indexed
+  // by first * kOpcodeCount + second. Empty unless requested.
+  std::vector<uint64_t> pair_counts;
+};
+
+struct FunctionOpcodeCounts {
+  Index func_index;
+  std::string name;
+  Offset size;
+  uint64_t weight;
+  // The unweighted count of each opcode in the body, in opcode order.
+  std::vector<std::pair<Opcode, uint64_t>> counts;
+};
+
+struct ReadOpcntOptions {
+  bool count_pairs = false;
+  // The execution count of each function, by function index. Functions that
+  // aren't listed are weighted 0. If null, each function is weighted 1.
+  const std::map<Index, uint64_t>* function_weights = nullptr;
+  // If not null, the counts of each function body are appended to this.
+  std::vector<FunctionOpcodeCounts>* functions = nullptr;
+};
 
 Result ReadBinaryOpcnt(const void* data,
                        size_t size,
                        const ReadBinaryOptions& options,
-                       OpcodeInfoCounts* opcode_counts);
+                       const ReadOpcntOptions& opcnt_options,
+                       OpcodeStats* stats);
 
 }  // namespace wabt
 
@@ -19,6 +19,7 @@
 
 #include <cstddef>
 #include <cstdint>
+#include <functional>
 #include <string_view>
 
 #include "wabt/binary.h"
@@ -50,6 +51,10 @@ struct ReadBinaryOptions {
   bool stop_on_first_error = true;
   bool fail_on_custom_section_error = true;
   bool skip_function_bodies = false;
+  // If set, only the function bodies for which this returns true are read;
+  // the others are skipped without calling any of the delegate's function body
+  // callbacks.
+  std::function<bool(Index func_index)> read_function_body;
 };
 
 // TODO: Move somewhere else?
@@ -44,7 +44,23 @@ struct WriteBinaryOptions {
   bool write_debug_names = false;
 };
 
-Result WriteBinaryModule(Stream*, const Module*, const WriteBinaryOptions&);
+// Supplies function bodies while a module is being written, so that they
+// needn't all be in the Module at once; see wat2wasm --stream.
+class FuncBodySource {
+ public:
+  virtual ~FuncBodySource() = default;
+
+  // Called just before the body of defined function `func_index` is written.
+  // Writing stops if this fails.
+  virtual Result BeginFuncBody(Index func_index) = 0;
+  // Called once the body has been written, so it can be released.
+  virtual void EndFuncBody(Index func_index) = 0;
+};
+
+Result WriteBinaryModule(Stream*,
+                         const Module*,
+                         const WriteBinaryOptions&,
+                         FuncBodySource* func_bodies = nullptr);
 
 void WriteType(Stream* stream, Type type, const char* desc = nullptr);
 
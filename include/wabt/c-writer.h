@@ -27,9 +27,34 @@ namespace wabt {
 struct Module;
 class Stream;
 
+enum class ExceptionLowering {
+  // Each try block saves an unwind target with setjmp, and a throw that isn't
+  // caught in the same function longjmps to it.
+  Setjmp,
+  // A throw that isn't caught in the same function sets the runtime's
+  // pending-exception flag and returns; callers test the flag after each
+  // call. Try blocks cost nothing unless an exception is thrown.
+  Checked,
+};
+
+struct BoundsCheckStats {
+  // Number of plain loads and stores written.
+  size_t accesses = 0;
+  // How many of them were proven in bounds, and skip the bounds check.
+  size_t unchecked = 0;
+};
+
 struct WriteCOptions {
   std::string_view module_name;
   Features features;
+  /*
+   * Write float constants as the shortest decimal that round-trips exactly,
+   * rather than with a fixed 9 (f32) or 17 (f64) significant digits.
+   */
+  bool shortest_floats = false;
+  ExceptionLowering exception_lowering = ExceptionLowering::Setjmp;
+  /* If set, incremented with the bounds checks done and eliminated. */
+  BoundsCheckStats* bounds_check_stats = nullptr;
   /*
    * name_to_output_file_index takes const iterators to begin and end of a list
    * of all functions in the module, number of imported functions, and number of
@@ -45,6 +70,10 @@ struct WriteCOptions {
       name_to_output_file_index;
 };
 
+// Whether WriteC supports every feature in |features| that is enabled but
+// isn't by default. Modules using other features may abort in WriteC.
+bool AreCWriterFeaturesSupported(const Features& features);
+
 Result WriteC(std::vector<Stream*>&& c_streams,
               Stream* h_stream,
               Stream* h_impl_stream,
@@ -29,6 +29,7 @@ struct DecompileOptions {};
 void RenameAll(Module&);
 
 std::string Decompile(const Module&, const DecompileOptions&);
+Result Decompile(const Module&, const DecompileOptions&, Stream*);
 
 }  // namespace wabt
 
@@ -47,6 +47,11 @@ enum class ParseIntType {
 #define WABT_MAX_FLOAT_HEX 20
 #define WABT_MAX_DOUBLE_HEX 40
 
+/* Size of char buffer required to hold the shortest round-trip decimal
+ * representation of a float/double */
+#define WABT_MAX_FLOAT_DECIMAL 24
+#define WABT_MAX_DOUBLE_DECIMAL 40
+
 Result ParseHexdigit(char c, uint32_t* out);
 Result ParseInt8(const char* s,
                  const char* end,
@@ -122,6 +127,10 @@ inline Result ParseDouble(LiteralType literal_type,
 
 void WriteFloatHex(char* buffer, size_t size, uint32_t bits);
 void WriteDoubleHex(char* buffer, size_t size, uint64_t bits);
+// Write the shortest decimal string that parses back to exactly |bits|.
+// Infinity and nan are written as in WriteFloatHex/WriteDoubleHex.
+void WriteFloatDecimal(char* buffer, size_t size, uint32_t bits);
+void WriteDoubleDecimal(char* buffer, size_t size, uint64_t bits);
 void WriteUint128(char* buffer, size_t size, v128 bits);
 
 }  // namespace wabt
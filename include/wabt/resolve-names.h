@@ -22,10 +22,14 @@
 
 namespace wabt {
 
+struct Func;
 struct Module;
 struct Script;
 
 Result ResolveNamesModule(Module*, Errors*);
+// Resolves the names used in the body of `func` only; its declaration is
+// resolved along with the rest of the module.
+Result ResolveNamesFuncBody(Module*, Func*, Errors*);
 Result ResolveNamesScript(Script*, Errors*);
 
 }  // namespace wabt
@@ -159,6 +159,9 @@ class Stream {
 
 struct OutputBuffer {
   Result WriteToFile(std::string_view filename) const;
+  // Like WriteToFile, but leaves the file alone (and its modification time
+  // unchanged) if it already has these contents.
+  Result WriteToFileIfChanged(std::string_view filename) const;
   Result WriteToStdout() const;
 
   void clear() { data.clear(); }
@@ -211,6 +214,12 @@ class FileStream : public Stream {
 
   void Flush() override;
 
+  // Writes out the buffered data and closes the file (or flushes a caller's
+  // FILE*). Fails if this or any earlier write failed. The destructor does
+  // the same, but can't report errors, so tools call this before reporting
+  // success.
+  Result Close();
+
  protected:
   Result WriteDataImpl(size_t offset, const void* data, size_t size) override;
   Result MoveDataImpl(size_t dst_offset,
@@ -219,9 +228,19 @@ class FileStream : public Stream {
   Result TruncateImpl(size_t size) override;
 
  private:
+  // Files opened by name are written through a large user-space buffer, so
+  // the many small writes made by the writers turn into a few big syscalls.
+  // Streams wrapping an existing FILE* (e.g. stdout) are unbuffered here,
+  // since callers may interleave them with printf.
+  static constexpr size_t kBufferSize = 256 * 1024;
+
+  Result FlushBuffer();
+  Result WriteFile(const void* data, size_t size);
+
   FILE* file_;
   size_t offset_;
   bool should_close_;
+  std::vector<uint8_t> buffer_;
 };
 
 }  // namespace wabt
@@ -17,12 +17,15 @@
 #ifndef WABT_VALIDATOR_H_
 #define WABT_VALIDATOR_H_
 
+#include <memory>
+
 #include "wabt/error.h"
 #include "wabt/feature.h"
 #include "wabt/shared-validator.h"
 
 namespace wabt {
 
+struct Func;
 struct Module;
 struct Script;
 
@@ -31,6 +34,25 @@ struct Script;
 Result ValidateScript(const Script*, Errors*, const ValidateOptions&);
 Result ValidateModule(const Module*, Errors*, const ValidateOptions&);
 
+// Performs the same checks as ValidateModule, but takes the function bodies one
+// at a time, for callers that never have all of them in the Module at once.
+// Call BeginModule, then CheckFuncBody for each defined function in order,
+// then EndModule. The result of each call includes all earlier errors.
+class StreamingModuleValidator {
+ public:
+  StreamingModuleValidator(Errors*, const Module*, const ValidateOptions&);
+  ~StreamingModuleValidator();
+
+  Result BeginModule();
+  Result CheckFuncBody(const Func*);
+  Result EndModule();
+
+ private:
+  struct Impl;
+  std::unique_ptr<Impl> impl_;
+  Index func_index_;
+};
+
 }  // namespace wabt
 
 #endif  // WABT_VALIDATOR_H_
@@ -49,6 +49,18 @@ class WastLexer {
 
   Token GetToken();
 
+  // A point in the source that lexing can be restarted from.
+  struct Position {
+    size_t offset = 0;
+    size_t line_start = 0;
+    int line = 1;
+  };
+
+  // The position just past the last token returned by GetToken; the next
+  // token starts here, after any whitespace and comments.
+  Position GetPosition() const;
+  void Seek(const Position&);
+
   // TODO(binji): Move this out of the lexer.
   std::unique_ptr<LexerSourceLineFinder> MakeLineFinder() {
     return std::make_unique<LexerSourceLineFinder>(source_->Clone());
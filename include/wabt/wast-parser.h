@@ -21,6 +21,8 @@
 #include <memory>
 #include <optional>
 #include <unordered_map>
+#include <utility>
+#include <vector>
 
 #include "wabt/error.h"
 #include "wabt/feature.h"
@@ -30,11 +32,27 @@
 
 namespace wabt {
 
+// A function body that was skipped by ParseWatModule; see
+// WastParseOptions::deferred_func_bodies.
+struct WastFuncBody {
+  WastLexer::Position position;
+  // Block types and call_indirect signatures used by the body that may need
+  // an implicitly defined function type. Only kept until the module's types
+  // are resolved.
+  std::vector<std::pair<Location, FuncDeclaration>> type_uses;
+};
+
 struct WastParseOptions {
   WastParseOptions(const Features& features) : features(features) {}
 
   Features features;
   bool debug_parsing = false;
+
+  // If set, ParseWatModule checks each function body and then discards it,
+  // appending a WastFuncBody here instead (in the order of Module::funcs,
+  // skipping imports). The bodies can then be parsed one at a time with
+  // ParseWatFuncBody, so they are never all in memory at once.
+  std::vector<WastFuncBody>* deferred_func_bodies = nullptr;
 };
 
 using TokenTypePair = std::array<TokenType, 2>;
@@ -46,6 +64,7 @@ class WastParser {
   void WABT_PRINTF_FORMAT(3, 4) Error(Location, const char* format, ...);
   Result ParseModule(std::unique_ptr<Module>* out_module);
   Result ParseScript(std::unique_ptr<Script>* out_script);
+  Result ParseFuncBody(const WastFuncBody&, Module*, Func*);
 
   std::unique_ptr<Script> ReleaseScript();
 
@@ -264,16 +283,19 @@ class WastParser {
   Errors* errors_;
   WastParseOptions* options_;
 
-  // two-element queue of upcoming tokens
+  // two-element queue of upcoming tokens, along with the lexer position that
+  // each one was read from
   class TokenQueue {
     std::array<std::optional<Token>, 2> tokens{};
+    std::array<WastLexer::Position, 2> positions{};
     bool i{};
 
    public:
-    void push_back(Token t);
+    void push_back(Token t, const WastLexer::Position& pos);
     void pop_front();
     const Token& at(size_t n) const;
     const Token& front() const;
+    const WastLexer::Position& front_position() const;
     bool empty() const;
     size_t size() const;
   };
@@ -291,6 +313,15 @@ Result ParseWastScript(WastLexer* lexer,
                        Errors*,
                        WastParseOptions* options);
 
+// Parses a function body deferred by ParseWatModule into func->exprs, and
+// resolves its types and names. `lexer` must be reading the same source.
+Result ParseWatFuncBody(WastLexer* lexer,
+                        const WastFuncBody& body,
+                        Module* module,
+                        Func* func,
+                        Errors*,
+                        WastParseOptions* options);
+
 }  // namespace wabt
 
 #endif /* WABT_WAST_PARSER_H_ */
@@ -32,6 +32,7 @@ struct WriteWatOptions {
   bool fold_exprs = false;  // Write folded expressions.
   bool inline_export = false;
   bool inline_import = false;
+  bool decimal_floats = false;  // Write floats as shortest decimals, not hex.
 };
 
 Result WriteWat(Stream*, const Module*, const WriteWatOptions&);
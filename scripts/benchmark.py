@@ -0,0 +1,507 @@
+#!/usr/bin/env python3
+#
+# Copyright 2026 WebAssembly Community Group participants
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+
+"""Time the wabt tools on synthetic modules.
+
+Each benchmark generates an input module of the requested size, then runs a
+set of tool invocations on it and reports the best wall time of --repeat runs,
+the peak memory use (where the platform can report it), and the size of each
+invocation's output.
+
+  $ scripts/benchmark.py --bindir bin floats
+"""
+
+import argparse
+import os
+import random
+import shutil
+import struct
+import subprocess
+import sys
+import tempfile
+import time
+
+SCRIPT_DIR = os.path.dirname(os.path.abspath(__file__))
+REPO_ROOT_DIR = os.path.dirname(SCRIPT_DIR)
+IS_WINDOWS = sys.platform == 'win32'
+
+
+class Error(Exception):
+    pass
+
+
+class Context(object):
+    def __init__(self, bindir, out_dir, size, seed):
+        self.bindir = bindir
+        self.out_dir = out_dir
+        self.size = size
+        self.random = random.Random(seed)
+
+    def Exe(self, name, required=True):
+        exe = os.path.join(self.bindir, name)
+        if IS_WINDOWS:
+            exe += '.exe'
+        if not os.path.exists(exe):
+            if not required:
+                return None
+            raise Error('executable not found: %s' % exe)
+        return exe
+
+    def Path(self, name):
+        return os.path.join(self.out_dir, name)
+
+    def Run(self, *cmd):
+        try:
+            subprocess.check_call(cmd, stdout=subprocess.DEVNULL)
+        except subprocess.CalledProcessError as e:
+            raise Error('command failed: %s' % ' '.join(e.cmd))
+
+    def Wat2Wasm(self, wat, *args):
+        wasm = os.path.splitext(wat)[0] + '.wasm'
+        self.Run(self.Exe('wat2wasm'), wat, '-o', wasm, *args)
+        return wasm
+
+
+def RandomF32Bits(rng):
+    # Mix "nice" decimal values, which have short representations, with
+    # arbitrary bit patterns, which need the most digits.
+    if rng.random() < 0.5:
+        value = rng.randint(-100000, 100000) / rng.choice([1, 10, 100, 1000])
+        return struct.unpack('<I', struct.pack('<f', value))[0]
+    while True:
+        bits = rng.getrandbits(32)
+        if (bits >> 23) & 0xff != 0xff:
+            return bits
+
+
+def RandomF64Bits(rng):
+    if rng.random() < 0.5:
+        value = rng.randint(-10**9, 10**9) / rng.choice([1, 10, 100, 1000])
+        return struct.unpack('<Q', struct.pack('<d', value))[0]
+    while True:
+        bits = rng.getrandbits(64)
+        if (bits >> 52) & 0x7ff != 0x7ff:
+            return bits
+
+
+def F32Hex(bits):
+    return float.hex(struct.unpack('<f', struct.pack('<I', bits))[0])
+
+
+def F64Hex(bits):
+    return float.hex(struct.unpack('<d', struct.pack('<Q', bits))[0])
+
+
+def GenerateFloats(ctx):
+    """A module whose function bodies are dominated by float constants."""
+    wat = ctx.Path('floats.wat')
+    rng = ctx.random
+    with open(wat, 'w') as f:
+        f.write('(module\n')
+        for i in range(ctx.size):
+            f.write('  (func (export "f%d") (result f64)\n' % i)
+            f.write('    f64.const 0\n')
+            for _ in range(50):
+                f.write('    f32.const %s\n' % F32Hex(RandomF32Bits(rng)))
+                f.write('    f64.promote_f32\n')
+                f.write('    f64.add\n')
+                f.write('    f64.const %s\n' % F64Hex(RandomF64Bits(rng)))
+                f.write('    f64.mul\n')
+            f.write('  )\n')
+        f.write(')\n')
+    wasm = ctx.Wat2Wasm(wat)
+    wasm2wat = ctx.Exe('wasm2wat')
+    wasm2c = ctx.Exe('wasm2c')
+    out_wat = ctx.Path('out.wat')
+    out_c = ctx.Path('out.c')
+    return [
+        ('wasm2wat', [wasm2wat, wasm, '-o', out_wat], out_wat),
+        ('wasm2wat --decimal-floats',
+         [wasm2wat, '--decimal-floats', wasm, '-o', out_wat], out_wat),
+        ('wasm2c', [wasm2c, wasm, '-o', out_c], out_c),
+        ('wasm2c --shortest-floats',
+         [wasm2c, '--shortest-floats', wasm, '-o', out_c], out_c),
+    ]
+
+
+def GenerateLexer(ctx):
+    """Text dominated by what the lexer skips over, rather than by syntax."""
+    rng = ctx.random
+    funcs_wat = ctx.Path('lexer-funcs.wat')
+    with open(funcs_wat, 'w') as f:
+        f.write('(module\n')
+        for i in range(ctx.size):
+            f.write('  ;; function %d: %s\n' % (i, 'x' * rng.randint(20, 100)))
+            f.write('  (func $function_with_a_fairly_long_name_%d\n' % i)
+            f.write('    (param $first_parameter i32) (result i32)\n')
+            f.write('    (local $accumulator_for_the_result i32)\n')
+            for j in range(20):
+                indent = ' ' * rng.randint(4, 40)
+                f.write('%s(; step %d ;) local.get $first_parameter\n' %
+                        (indent, j))
+                f.write('%slocal.get $accumulator_for_the_result\n' % indent)
+                f.write('%si32.add\n' % indent)
+                f.write('%slocal.set $accumulator_for_the_result\n' % indent)
+            f.write('    local.get $accumulator_for_the_result)\n')
+        f.write(')\n')
+    data_wat = ctx.Path('lexer-data.wat')
+    with open(data_wat, 'w') as f:
+        f.write('(module\n  (memory 1)\n')
+        chars = 'abcdefghijklmnopqrstuvwxyz0123456789 '
+        for i in range(ctx.size):
+            text = ''.join(rng.choice(chars) for _ in range(1000))
+            f.write('  (data (i32.const 0) "%s\\00\\ff")\n' % text)
+        f.write(')\n')
+    wat2wasm = ctx.Exe('wat2wasm')
+    out_wasm = ctx.Path('out.wasm')
+    runs = [
+        ('wat2wasm (functions)', [wat2wasm, funcs_wat, '-o', out_wasm],
+         out_wasm),
+        ('wat2wasm (data strings)', [wat2wasm, data_wat, '-o', out_wasm],
+         out_wasm),
+    ]
+    # Only built with -DBUILD_BENCHMARKS=ON; use the build directory as
+    # --bindir to find it.
+    lexer_bench = ctx.Exe('wast-lexer-bench', required=False)
+    if lexer_bench:
+        runs += [
+            ('wast-lexer-bench (functions)', [lexer_bench, funcs_wat], None),
+            ('wast-lexer-bench (data strings)', [lexer_bench, data_wat], None),
+        ]
+    return runs
+
+
+def GenerateWat2Wasm(ctx):
+    """Many functions with calls, blocks and named locals, for wat2wasm."""
+    rng = ctx.random
+    wat = ctx.Path('wat2wasm.wat')
+    with open(wat, 'w') as f:
+        f.write('(module\n')
+        f.write('  (type $t (func (param i32) (result i32)))\n')
+        f.write('  (table 1 funcref)\n  (memory 1)\n')
+        for i in range(ctx.size):
+            f.write('  (func $f%d (export "f%d") (param $x i32) (result i32)\n' %
+                    (i, i))
+            f.write('    (local $y i32)\n')
+            for j in range(20):
+                f.write('    (local.set $y (i32.add (local.get $y)\n')
+                f.write('      (i32.load offset=%d (local.get $x))))\n' % (j * 4))
+                f.write('    (if (i32.eqz (local.get $y)) (then\n')
+                f.write('      (local.set $y (call $f%d (local.get $x)))))\n' %
+                        rng.randrange(ctx.size))
+            f.write('    (call_indirect (type $t) (local.get $y) '
+                    '(i32.const 0)))\n')
+        f.write(')\n')
+    wat2wasm = ctx.Exe('wat2wasm')
+    out_wasm = ctx.Path('out.wasm')
+    runs = [
+        ('wat2wasm', [wat2wasm, wat, '-o', out_wasm], out_wasm),
+        ('wat2wasm --stream', [wat2wasm, '--stream', wat, '-o', out_wasm],
+         out_wasm),
+    ]
+    writer_bench = ctx.Exe('binary-writer-bench', required=False)
+    if writer_bench:
+        runs += [
+            ('binary-writer-bench', [writer_bench, wat], None),
+            ('binary-writer-bench --relocatable',
+             [writer_bench, '--relocatable', wat], None),
+        ]
+    return runs
+
+
+def GenerateDecompile(ctx):
+    """Deeply nested expressions and blocks, for wasm-decompile."""
+    rng = ctx.random
+    wat = ctx.Path('decompile.wat')
+    with open(wat, 'w') as f:
+        f.write('(module\n  (memory 1)\n')
+        for i in range(ctx.size):
+            f.write('  (func $f%d (export "f%d") (param $x i32) (result i32)\n' %
+                    (i, i))
+            # Blocks nest their bodies, and each level of nesting used to
+            # re-indent all of the lines inside it.
+            depth = 40
+            for j in range(depth):
+                f.write('    (block $b%d\n' % j)
+                f.write('      (br_if $b%d (i32.eqz (local.get $x)))\n' % j)
+                f.write('      (i32.store offset=%d (local.get $x)\n' %
+                        (j * 4))
+                f.write('        (i32.add (i32.load (local.get $x))'
+                        ' (i32.const %d)))\n' % rng.randrange(1000))
+            f.write('    ' + ')' * depth + '\n')
+            # A long expression tree, which doesn't fit on one line.
+            expr = '(local.get $x)'
+            for j in range(100):
+                expr = '(i32.%s %s (i32.const %d))' % (
+                    rng.choice(['add', 'mul', 'xor', 'sub']), expr,
+                    rng.randrange(1 << 20))
+            f.write('    %s)\n' % expr)
+        f.write(')\n')
+    wasm = ctx.Wat2Wasm(wat)
+    out = ctx.Path('out.dcmp')
+    return [
+        ('wasm-decompile', [ctx.Exe('wasm-decompile'), wasm, '-o', out], out),
+    ]
+
+
+# Calls the module's exported `run` function with the iteration count given on
+# the command line.
+WASM2C_MAIN_C = r'''
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "%(name)s.h"
+
+int main(int argc, char** argv) {
+  w2c_%(name)s instance;
+  wasm_rt_init();
+  wasm2c_%(name)s_instantiate(&instance);
+  printf("%%u\n", w2c_%(name)s_run(&instance, atoi(argv[1])));
+  wasm2c_%(name)s_free(&instance);
+  wasm_rt_free();
+  return 0;
+}
+'''
+
+
+def BuildWasm2C(ctx, wasm, name, *wasm2c_args):
+    """Translates wasm with wasm2c and compiles it into a runnable program."""
+    main_c = ctx.Path(name + '-main.c')
+    with open(main_c, 'w') as f:
+        f.write(WASM2C_MAIN_C % {'name': name})
+    out_c = ctx.Path(name + '.c')
+    ctx.Run(ctx.Exe('wasm2c'), '-n', name, wasm, '-o', out_c, *wasm2c_args)
+    wasm2c_dir = os.path.join(REPO_ROOT_DIR, 'wasm2c')
+    runtime = [os.path.join(wasm2c_dir, filename) for filename in
+               ('wasm-rt-impl.c', 'wasm-rt-exceptions-impl.c',
+                'wasm-rt-mem-impl.c')]
+    exe = ctx.Path(name)
+    ctx.Run(os.environ.get('CC', 'cc'), '-O2', '-I' + wasm2c_dir,
+            '-I' + ctx.out_dir, '-o', exe, main_c, out_c, *runtime, '-lm')
+    return exe
+
+
+def GenerateWasm2CExceptions(ctx):
+    """Run a try-heavy module built with each wasm2c exception lowering."""
+    wat = ctx.Path('exceptions.wat')
+    with open(wat, 'w') as f:
+        f.write('''(module
+  (tag $e (param i32))
+  (func $leaf (param i32) (result i32)
+    (if (i32.eqz (i32.rem_u (local.get 0) (i32.const 997)))
+      (then (throw $e (local.get 0))))
+    (i32.add (local.get 0) (i32.const 1)))
+  ;; A try around a loop that keeps its state in locals.
+  (func $sum (param $x i32) (result i32)
+    (local $i i32) (local $acc i32)
+    (block $h (result i32)
+      (try_table (result i32) (catch $e $h)
+        (loop $l
+          (local.set $acc
+            (i32.add (local.get $acc)
+                     (call $leaf (i32.add (local.get $x) (local.get $i)))))
+          (local.set $i (i32.add (local.get $i) (i32.const 1)))
+          (br_if $l (i32.lt_u (local.get $i) (i32.const 4))))
+        (local.get $acc))))
+  ;; Nested tries that rarely catch anything.
+  (func $outer (param $x i32) (result i32)
+    (local $r i32)
+    (block $h
+      (try_table (catch_all $h)
+        (block $h2 (result i32)
+          (try_table (result i32) (catch $e $h2)
+            (call $sum (local.get $x))))
+        (local.set $r)))
+    (i32.add (local.get $r) (i32.const 1)))
+  (func (export "run") (param $n i32) (result i32)
+    (local $i i32) (local $acc i32)
+    (loop $l
+      (local.set $acc (i32.add (local.get $acc) (call $outer (local.get $i))))
+      (local.set $i (i32.add (local.get $i) (i32.const 1)))
+      (br_if $l (i32.lt_u (local.get $i) (local.get $n))))
+    (local.get $acc)))
+''')
+    wasm = ctx.Wat2Wasm(wat, '--enable-exceptions')
+    iterations = str(ctx.size * 1000)
+    runs = []
+    for lowering in ('setjmp', 'checked'):
+        exe = BuildWasm2C(ctx, wasm, 'exceptions' + lowering,
+                          '--enable-exceptions',
+                          '--exception-lowering=' + lowering)
+        runs.append(('wasm2c --exception-lowering=' + lowering,
+                     [exe, iterations], None))
+    return runs
+
+
+def GenerateWasm2CCallIndirect(ctx):
+    """Virtual calls through vtables in a table, as C++ compiles them."""
+    classes = 4
+    methods = 3
+    runs = []
+    for variant in ('exported', 'private'):
+        wat = ctx.Path('vtables_%s.wat' % variant)
+        with open(wat, 'w') as f:
+            f.write('(module\n')
+            f.write('  (type $method (func (param i32 i32) (result i32)))\n')
+            # An exported table could be changed by the host, so only calls
+            # through the private one can be devirtualized.
+            export = ' (export "vtables")' if variant == 'exported' else ''
+            f.write('  (table $vtables%s %d funcref)\n' %
+                    (export, classes * methods))
+            f.write('  (elem (table $vtables) (i32.const 0) func')
+            for c in range(classes):
+                for m in range(methods):
+                    f.write(' $c%d_m%d' % (c, m))
+            f.write(')\n')
+            for c in range(classes):
+                for m in range(methods):
+                    f.write('  (func $c%d_m%d (type $method)\n' % (c, m))
+                    f.write('    (i32.add (i32.mul (local.get 1) (i32.const %d))'
+                            ' (i32.xor (local.get 0) (i32.const %d))))\n' %
+                            (c * methods + m + 3, c + m))
+            # Each object's class comes from a pseudo-random sequence, so the
+            # C compiler can't predict the callee.
+            f.write('''  (func (export "run") (param $n i32) (result i32)
+    (local $i i32) (local $acc i32) (local $vtable i32) (local $seed i32)
+    (loop $l
+      (local.set $seed (i32.add (i32.mul (local.get $seed)
+                                         (i32.const 1103515245))
+                                (i32.const 12345)))
+      (local.set $vtable (i32.mul (i32.rem_u (i32.shr_u (local.get $seed)
+                                                        (i32.const 16))
+                                             (i32.const %d))
+                                  (i32.const %d)))
+''' % (classes, methods))
+            for m in range(methods):
+                f.write('      (local.set $acc (call_indirect $vtables '
+                        '(type $method) (local.get $i) (local.get $acc)\n'
+                        '        (i32.add (local.get $vtable) (i32.const %d))))'
+                        '\n' % m)
+            f.write('''      (local.set $i (i32.add (local.get $i) (i32.const 1)))
+      (br_if $l (i32.lt_u (local.get $i) (local.get $n))))
+    (local.get $acc)))
+''')
+        wasm = ctx.Wat2Wasm(wat)
+        exe = BuildWasm2C(ctx, wasm, 'vtables' + variant)
+        runs.append(('wasm2c (%s table)' % variant,
+                     [exe, str(ctx.size * 10000)], None))
+    return runs
+
+
+BENCHMARKS = {
+    'decompile': GenerateDecompile,
+    'floats': GenerateFloats,
+    'lexer': GenerateLexer,
+    'wasm2c-call-indirect': GenerateWasm2CCallIndirect,
+    'wasm2c-exceptions': GenerateWasm2CExceptions,
+    'wat2wasm': GenerateWat2Wasm,
+}
+
+
+def RunCommand(cmd):
+    """Runs cmd, returning its peak resident set size in KiB, or None."""
+    if not hasattr(os, 'wait4'):
+        subprocess.check_call(cmd, stdout=subprocess.DEVNULL)
+        return None
+    proc = subprocess.Popen(cmd, stdout=subprocess.DEVNULL)
+    _, status, rusage = os.wait4(proc.pid, 0)
+    proc.returncode = os.waitstatus_to_exitcode(status)
+    if proc.returncode != 0:
+        raise subprocess.CalledProcessError(proc.returncode, cmd)
+    # ru_maxrss is in bytes on macOS, and KiB elsewhere.
+    if sys.platform == 'darwin':
+        return rusage.ru_maxrss // 1024
+    return rusage.ru_maxrss
+
+
+def TimeCommand(cmd, repeat):
+    best = None
+    max_rss = None
+    for _ in range(repeat):
+        start = time.perf_counter()
+        try:
+            max_rss = RunCommand(cmd)
+        except subprocess.CalledProcessError as e:
+            raise Error('command failed: %s' % ' '.join(e.cmd))
+        elapsed = time.perf_counter() - start
+        if best is None or elapsed < best:
+            best = elapsed
+    return best, max_rss
+
+
+def RunBenchmark(name, ctx, repeat):
+    runs = BENCHMARKS[name](ctx)
+    print('%s (size=%d)' % (name, ctx.size))
+    for label, cmd, output in runs:
+        elapsed, max_rss = TimeCommand(cmd, repeat)
+        line = '  %-40s %9.3fs' % (label, elapsed)
+        if max_rss is not None:
+            line += ' %9.1f MiB' % (max_rss / 1024)
+        if output:
+            line += ' %12d bytes' % os.path.getsize(output)
+        print(line)
+        sys.stdout.flush()
+
+
+def main(args):
+    parser = argparse.ArgumentParser(description=__doc__,
+        formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument('--bindir', metavar='PATH',
+                        default=os.path.join(REPO_ROOT_DIR, 'bin'),
+                        help='directory to search for all executables.')
+    parser.add_argument('-o', '--out-dir', metavar='PATH',
+                        help='directory for generated files; a temporary '
+                             'directory is used by default.')
+    parser.add_argument('-n', '--size', type=int, default=2000,
+                        help='size of the generated module (benchmark '
+                             'specific, usually a number of functions).')
+    parser.add_argument('-r', '--repeat', type=int, default=3,
+                        help='number of times to run each command.')
+    parser.add_argument('--seed', type=int, default=0)
+    parser.add_argument('-l', '--list', action='store_true',
+                        help='list all benchmarks.')
+    parser.add_argument('benchmarks', metavar='benchmark', nargs='*',
+                        help='benchmarks to run; all by default.')
+    options = parser.parse_args(args)
+
+    if options.list:
+        for name in sorted(BENCHMARKS):
+            print('%-12s %s' % (name, BENCHMARKS[name].__doc__))
+        return 0
+
+    names = options.benchmarks or sorted(BENCHMARKS)
+    for name in names:
+        if name not in BENCHMARKS:
+            parser.error('unknown benchmark: %s' % name)
+
+    out_dir = options.out_dir or tempfile.mkdtemp(prefix='wabt-bench-')
+    try:
+        os.makedirs(out_dir, exist_ok=True)
+        for name in names:
+            ctx = Context(options.bindir, out_dir, options.size, options.seed)
+            RunBenchmark(name, ctx, options.repeat)
+    finally:
+        if not options.out_dir:
+            shutil.rmtree(out_dir)
+    return 0
+
+
+if __name__ == '__main__':
+    try:
+        sys.exit(main(sys.argv[1:]))
+    except Error as e:
+        sys.stderr.write(str(e) + '\n')
+        sys.exit(1)
@@ -0,0 +1,121 @@
+/*
+ * Copyright 2026 WebAssembly Community Group participants
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cinttypes>
+#include <cstdio>
+#include <cstdlib>
+
+#include "wabt/binary-writer.h"
+#include "wabt/common.h"
+#include "wabt/error-formatter.h"
+#include "wabt/ir.h"
+#include "wabt/option-parser.h"
+#include "wabt/stream.h"
+#include "wabt/wast-lexer.h"
+#include "wabt/wast-parser.h"
+
+// Measures BinaryWriter throughput in isolation from parsing, which otherwise
+// dominates the time taken by wat2wasm.
+
+using namespace wabt;
+
+static std::string s_infile;
+static int s_repeat = 5;
+static WriteBinaryOptions s_write_binary_options;
+static Features s_features;
+
+static const char s_description[] =
+    R"(  Parse a file in the WebAssembly text format once, then write it to the
+  binary format several times, and report the best time.
+
+examples:
+  $ binary-writer-bench --repeat 10 test.wat
+)";
+
+static void ParseOptions(int argc, char** argv) {
+  OptionParser parser("binary-writer-bench", s_description);
+
+  s_features.AddOptions(&parser);
+  parser.AddOption('r', "repeat", "N", "Number of times to write the module",
+                   [](const char* argument) {
+                     s_repeat = std::max(1, atoi(argument));
+                   });
+  parser.AddOption("relocatable", "Write a relocatable wasm binary",
+                   []() { s_write_binary_options.relocatable = true; });
+  parser.AddOption(
+      "no-canonicalize-leb128s",
+      "Write all LEB128 sizes as 5-bytes instead of their minimal size",
+      []() { s_write_binary_options.canonicalize_lebs = false; });
+  parser.AddArgument("filename", OptionParser::ArgumentCount::One,
+                     [](const char* argument) {
+                       s_infile = argument;
+                       ConvertBackslashToSlash(&s_infile);
+                     });
+  parser.Parse(argc, argv);
+}
+
+int ProgramMain(int argc, char** argv) {
+  InitStdio();
+  ParseOptions(argc, argv);
+
+  std::vector<uint8_t> file_data;
+  if (Failed(ReadFile(s_infile.c_str(), &file_data))) {
+    return 1;
+  }
+
+  Errors errors;
+  auto lexer = WastLexer::CreateBufferLexer(s_infile, file_data.data(),
+                                            file_data.size(), &errors);
+  std::unique_ptr<Module> module;
+  WastParseOptions parse_wast_options(s_features);
+  if (Failed(ParseWatModule(lexer.get(), &module, &errors,
+                            &parse_wast_options))) {
+    auto line_finder = lexer->MakeLineFinder();
+    FormatErrorsToFile(errors, Location::Type::Text, line_finder.get());
+    return 1;
+  }
+
+  s_write_binary_options.features = s_features;
+  double best_seconds = 0;
+  size_t size = 0;
+  for (int i = 0; i < s_repeat; ++i) {
+    auto start = std::chrono::steady_clock::now();
+    MemoryStream stream;
+    if (Failed(WriteBinaryModule(&stream, module.get(),
+                                 s_write_binary_options))) {
+      fprintf(stderr, "unable to write module\n");
+      return 1;
+    }
+    std::chrono::duration<double> elapsed =
+        std::chrono::steady_clock::now() - start;
+    if (i == 0 || elapsed.count() < best_seconds) {
+      best_seconds = elapsed.count();
+    }
+    size = stream.output_buffer().size();
+  }
+
+  printf("%" PRIzd " bytes, %.3fs, %.1f MB/s\n", size, best_seconds,
+         size / best_seconds / 1e6);
+  return 0;
+}
+
+int main(int argc, char** argv) {
+  WABT_TRY
+  return ProgramMain(argc, argv);
+  WABT_CATCH_BAD_ALLOC_AND_EXIT
+}
@@ -0,0 +1,99 @@
+/*
+ * Copyright 2026 WebAssembly Community Group participants
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cinttypes>
+#include <cstdio>
+#include <cstdlib>
+
+#include "wabt/common.h"
+#include "wabt/error-formatter.h"
+#include "wabt/option-parser.h"
+#include "wabt/wast-lexer.h"
+
+// Measures WastLexer throughput in isolation from parsing, so lexer
+// regressions aren't hidden by the cost of building and writing the module.
+
+using namespace wabt;
+
+static std::string s_infile;
+static int s_repeat = 5;
+
+static const char s_description[] =
+    R"(  Tokenize a file in the WebAssembly text format, and report the
+  best time of several runs.
+
+examples:
+  $ wast-lexer-bench --repeat 10 test.wat
+)";
+
+static void ParseOptions(int argc, char** argv) {
+  OptionParser parser("wast-lexer-bench", s_description);
+
+  parser.AddOption('r', "repeat", "N", "Number of times to tokenize the input",
+                   [](const char* argument) {
+                     s_repeat = std::max(1, atoi(argument));
+                   });
+  parser.AddArgument("filename", OptionParser::ArgumentCount::One,
+                     [](const char* argument) {
+                       s_infile = argument;
+                       ConvertBackslashToSlash(&s_infile);
+                     });
+  parser.Parse(argc, argv);
+}
+
+int ProgramMain(int argc, char** argv) {
+  InitStdio();
+  ParseOptions(argc, argv);
+
+  std::vector<uint8_t> file_data;
+  if (Failed(ReadFile(s_infile.c_str(), &file_data))) {
+    return 1;
+  }
+
+  double best_seconds = 0;
+  size_t num_tokens = 0;
+  for (int i = 0; i < s_repeat; ++i) {
+    Errors errors;
+    auto start = std::chrono::steady_clock::now();
+    auto lexer = WastLexer::CreateBufferLexer(s_infile, file_data.data(),
+                                              file_data.size(), &errors);
+    num_tokens = 0;
+    while (lexer->GetToken().token_type() != TokenType::Eof) {
+      num_tokens++;
+    }
+    std::chrono::duration<double> elapsed =
+        std::chrono::steady_clock::now() - start;
+    if (i == 0 || elapsed.count() < best_seconds) {
+      best_seconds = elapsed.count();
+    }
+    if (i == 0 && !errors.empty()) {
+      FormatErrorsToFile(errors, Location::Type::Text);
+    }
+  }
+
+  printf("%" PRIzd " bytes, %" PRIzd " tokens, %.3fs, %.1f MB/s\n",
+         file_data.size(), num_tokens, best_seconds,
+         file_data.size() / best_seconds / 1e6);
+  return 0;
+}
+
+int main(int argc, char** argv) {
+  WABT_TRY
+  return ProgramMain(argc, argv);
+  WABT_CATCH_BAD_ALLOC_AND_EXIT
+}
@@ -0,0 +1,638 @@
+/*
+ * Copyright 2026 WebAssembly Community Group participants
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "wabt/binary-patch.h"
+
+#include <algorithm>
+#include <cinttypes>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+#include "wabt/binary-reader-hash.h"
+#include "wabt/binary-reader.h"
+#include "wabt/leb128.h"
+#include "wabt/sha256.h"
+#include "wabt/stream.h"
+
+namespace wabt {
+
+namespace {
+
+const char kPatchMagic[] = {0, 'w', 'd', 'p'};
+const uint32_t kPatchVersion = 1;
+const size_t kDigestSize = 32;
+
+enum class PatchCommand : uint8_t {
+  Literal = 0,
+  Copy = 1,
+  Funcs = 2,
+  Section = 3,
+};
+
+std::string GetDigest(const std::vector<uint8_t>& data) {
+  std::string digest;
+  sha256({reinterpret_cast<const char*>(data.data()), data.size()}, digest);
+  return digest;
+}
+
+// The items of a module, as read by ReadBinaryHashes.
+struct ModuleItems {
+  explicit ModuleItems(const std::vector<uint8_t>& data) : data(data) {}
+
+  Result Read(const ReadBinaryOptions& options, const char* desc, Errors*);
+
+  const std::vector<uint8_t>& data;
+  std::vector<BinaryItemHash> items;
+  std::vector<std::string> func_keys;
+  // The function body items by function index; null for imported functions.
+  std::vector<const BinaryItemHash*> funcs;
+  // The items of the sections that are hashed as a whole, by section index.
+  std::unordered_map<Index, const BinaryItemHash*> sections;
+};
+
+Result ModuleItems::Read(const ReadBinaryOptions& options,
+                         const char* desc,
+                         Errors* errors) {
+  if (Failed(ReadBinaryHashes(data.data(), data.size(), options, &items,
+                              &func_keys))) {
+    errors->emplace_back(ErrorLevel::Error, Location(),
+                         std::string("unable to read ") + desc);
+    return Result::Error;
+  }
+  funcs.resize(func_keys.size());
+  for (const BinaryItemHash& item : items) {
+    if (item.kind == BinaryItemHash::Kind::Function &&
+        item.index < funcs.size()) {
+      funcs[item.index] = &item;
+    } else if (item.kind == BinaryItemHash::Kind::Section) {
+      sections.emplace(item.index, &item);
+    }
+  }
+  return Result::Ok;
+}
+
+// Returns the digest of a function body without the function indices it
+// uses, which doesn't depend on the keys of other functions.
+std::string GetShapeDigest(const std::vector<uint8_t>& data,
+                           const BinaryItemHash& func) {
+  std::string shape;
+  Offset offset = func.offset;
+  for (const BinaryFuncRef& ref : func.func_refs) {
+    shape.append(reinterpret_cast<const char*>(data.data()) + offset,
+                 ref.offset - offset);
+    shape += '\0';
+    offset = ref.end;
+  }
+  shape.append(reinterpret_cast<const char*>(data.data()) + offset,
+               func.offset + func.size - offset);
+  std::string digest;
+  sha256(shape, digest);
+  return digest;
+}
+
+// Writes the bytes of the old function body or section |item| preceded by
+// their size, with the function indices in them mapped through |func_map|.
+Result RebuildItem(const std::vector<uint8_t>& old_data,
+                   const BinaryItemHash& item,
+                   const std::vector<Index>& func_map,
+                   Stream* stream) {
+  Offset size = item.size;
+  for (const BinaryFuncRef& ref : item.func_refs) {
+    if (ref.func_index >= func_map.size()) {
+      return Result::Error;
+    }
+    size = size - (ref.end - ref.offset) +
+           U32Leb128Length(func_map[ref.func_index]);
+  }
+
+  WriteU32Leb128(stream, size, "size");
+  Offset offset = item.offset;
+  for (const BinaryFuncRef& ref : item.func_refs) {
+    stream->WriteData(old_data.data() + offset, ref.offset - offset);
+    WriteU32Leb128(stream, func_map[ref.func_index], "function index");
+    offset = ref.end;
+  }
+  stream->WriteData(old_data.data() + offset, item.offset + item.size - offset);
+  return stream->result();
+}
+
+// Maps each old function to the new function with the same name, or else
+// to the one with the same body apart from the functions it calls, if no other
+// function has that body. A function that wasn't matched is mapped as if it
+// moved with the function before it, so that it doesn't start a new run in
+// the patch.
+std::vector<Index> MapFunctions(const ModuleItems& old_module,
+                                const ModuleItems& new_module) {
+  const std::vector<std::string>& old_keys = old_module.func_keys;
+  const std::vector<std::string>& new_keys = new_module.func_keys;
+  std::vector<Index> matches(old_keys.size(), kInvalidIndex);
+  std::vector<bool> new_matched(new_keys.size());
+
+  // Keys that start with '#' are indices rather than names.
+  std::unordered_map<std::string_view, Index> new_by_key;
+  for (Index i = 0; i < new_keys.size(); ++i) {
+    if (new_keys[i][0] != '#') {
+      new_by_key.emplace(new_keys[i], i);
+    }
+  }
+  for (Index i = 0; i < old_keys.size(); ++i) {
+    auto iter = new_by_key.find(old_keys[i]);
+    if (iter != new_by_key.end()) {
+      matches[i] = iter->second;
+      new_matched[iter->second] = true;
+    }
+  }
+
+  // Bodies that occur more than once in either module are mapped to
+  // kInvalidIndex, and aren't matched.
+  auto add_shapes = [](const ModuleItems& module,
+                       auto&& is_matched) {
+    std::unordered_map<std::string, Index> by_shape;
+    for (Index i = 0; i < module.funcs.size(); ++i) {
+      if (module.funcs[i] && !is_matched(i)) {
+        auto [iter, inserted] =
+            by_shape.emplace(GetShapeDigest(module.data, *module.funcs[i]), i);
+        if (!inserted) {
+          iter->second = kInvalidIndex;
+        }
+      }
+    }
+    return by_shape;
+  };
+  auto old_by_shape = add_shapes(
+      old_module, [&](Index i) { return matches[i] != kInvalidIndex; });
+  auto new_by_shape =
+      add_shapes(new_module, [&](Index i) { return bool(new_matched[i]); });
+  for (auto& [shape, old_index] : old_by_shape) {
+    auto iter = new_by_shape.find(shape);
+    if (old_index != kInvalidIndex && iter != new_by_shape.end() &&
+        iter->second != kInvalidIndex) {
+      matches[old_index] = iter->second;
+    }
+  }
+
+  std::vector<Index> func_map(old_keys.size());
+  int64_t delta = 0;
+  for (Index i = 0; i < old_keys.size(); ++i) {
+    if (matches[i] != kInvalidIndex) {
+      delta = static_cast<int64_t>(matches[i]) - i;
+    }
+    func_map[i] = static_cast<Index>(i + delta);
+  }
+  return func_map;
+}
+
+// Writes the commands of a patch, merging each command into the one before it
+// where possible.
+class PatchWriter {
+ public:
+  PatchWriter(const std::vector<uint8_t>& new_data, Stream* stream)
+      : new_data_(new_data), stream_(stream) {}
+
+  // Bytes [offset, end) of the new module.
+  void Literal(Offset offset, Offset end) {
+    if (end > offset) {
+      Add(PatchCommand::Literal, offset, end - offset);
+    }
+  }
+
+  void Copy(Offset old_offset, Offset size) {
+    if (size > 0) {
+      Add(PatchCommand::Copy, old_offset, size);
+    }
+  }
+
+  void Funcs(Index old_func_index) {
+    Add(PatchCommand::Funcs, old_func_index, 1);
+  }
+
+  void Section(Index old_section_index) {
+    Add(PatchCommand::Section, old_section_index, 1);
+  }
+
+  void Flush() {
+    if (!pending_size_) {
+      return;
+    }
+    stream_->WriteU8Enum(pending_, "command");
+    switch (pending_) {
+      case PatchCommand::Literal:
+        WriteU32Leb128(stream_, pending_size_, "size");
+        stream_->WriteData(new_data_.data() + pending_offset_, pending_size_);
+        break;
+
+      case PatchCommand::Copy:
+        WriteU32Leb128(stream_, pending_offset_, "offset");
+        WriteU32Leb128(stream_, pending_size_, "size");
+        break;
+
+      case PatchCommand::Funcs:
+        WriteU32Leb128(stream_, pending_offset_, "function index");
+        WriteU32Leb128(stream_, pending_size_, "function count");
+        break;
+
+      case PatchCommand::Section:
+        WriteU32Leb128(stream_, pending_offset_, "section index");
+        break;
+    }
+    pending_size_ = 0;
+  }
+
+ private:
+  void Add(PatchCommand command, Offset offset, Offset size) {
+    // Sections are never next to each other: each starts with its code.
+    if (pending_size_ && command == pending_ &&
+        command != PatchCommand::Section &&
+        offset == pending_offset_ + pending_size_) {
+      pending_size_ += size;
+      return;
+    }
+    Flush();
+    pending_ = command;
+    pending_offset_ = offset;
+    pending_size_ = size;
+  }
+
+  const std::vector<uint8_t>& new_data_;
+  Stream* stream_;
+  PatchCommand pending_ = PatchCommand::Literal;
+  Offset pending_offset_ = 0;
+  Offset pending_size_ = 0;
+};
+
+class PatchReader {
+ public:
+  PatchReader(const std::vector<uint8_t>& patch, Errors* errors)
+      : patch_(patch), errors_(errors) {}
+
+  bool AtEnd() const { return offset_ == patch_.size(); }
+
+  Result ReadU8(uint8_t* out_value, const char* desc) {
+    if (AtEnd()) {
+      return Error("unable to read %s", desc);
+    }
+    *out_value = patch_[offset_++];
+    return Result::Ok;
+  }
+
+  Result ReadU32Leb128(uint32_t* out_value, const char* desc) {
+    size_t length = wabt::ReadU32Leb128(
+        patch_.data() + offset_, patch_.data() + patch_.size(), out_value);
+    if (length == 0) {
+      return Error("unable to read %s", desc);
+    }
+    offset_ += length;
+    return Result::Ok;
+  }
+
+  Result ReadS64Leb128(int64_t* out_value, const char* desc) {
+    uint64_t value;
+    size_t length = wabt::ReadS64Leb128(
+        patch_.data() + offset_, patch_.data() + patch_.size(), &value);
+    if (length == 0) {
+      return Error("unable to read %s", desc);
+    }
+    *out_value = static_cast<int64_t>(value);
+    offset_ += length;
+    return Result::Ok;
+  }
+
+  Result ReadBytes(size_t size, std::string_view* out_bytes, const char* desc) {
+    if (size > patch_.size() - offset_) {
+      return Error("unable to read %s", desc);
+    }
+    *out_bytes = std::string_view(
+        reinterpret_cast<const char*>(patch_.data() + offset_), size);
+    offset_ += size;
+    return Result::Ok;
+  }
+
+  Result WABT_PRINTF_FORMAT(2, 3) Error(const char* format, ...) {
+    WABT_SNPRINTF_ALLOCA(buffer, length, format);
+    errors_->emplace_back(ErrorLevel::Error, Location(offset_), buffer);
+    return Result::Error;
+  }
+
+ private:
+  const std::vector<uint8_t>& patch_;
+  Errors* errors_;
+  size_t offset_ = 0;
+};
+
+}  // end anonymous namespace
+
+Result CreateBinaryPatch(const std::vector<uint8_t>& old_data,
+                         const std::vector<uint8_t>& new_data,
+                         const ReadBinaryOptions& options,
+                         std::vector<uint8_t>* patch,
+                         Errors* errors) {
+  ModuleItems old_module(old_data);
+  ModuleItems new_module(new_data);
+  CHECK_RESULT(old_module.Read(options, "old module", errors));
+  CHECK_RESULT(new_module.Read(options, "new module", errors));
+  if (new_data.size() > UINT32_MAX) {
+    errors->emplace_back(ErrorLevel::Error, Location(),
+                         "new module is too large");
+    return Result::Error;
+  }
+  std::vector<Index> func_map = MapFunctions(old_module, new_module);
+
+  MemoryStream stream;
+  stream.WriteData(kPatchMagic, sizeof(kPatchMagic), "magic");
+  WriteU32Leb128(&stream, kPatchVersion, "version");
+  stream.WriteData(GetDigest(old_data).data(), kDigestSize, "old digest");
+  stream.WriteData(GetDigest(new_data).data(), kDigestSize, "new digest");
+  WriteU32Leb128(&stream, new_data.size(), "new size");
+
+  std::vector<std::pair<Index, int64_t>> runs;
+  for (Index i = 0; i < func_map.size(); ++i) {
+    int64_t delta = static_cast<int64_t>(func_map[i]) - i;
+    if (runs.empty() || runs.back().second != delta) {
+      runs.emplace_back(0, delta);
+    }
+    runs.back().first++;
+  }
+  WriteU32Leb128(&stream, runs.size(), "run count");
+  for (auto [count, delta] : runs) {
+    WriteU32Leb128(&stream, count, "function count");
+    WriteS64Leb128(&stream, static_cast<uint64_t>(delta), "index delta");
+  }
+
+  // An old item can be used for a new one with the same key and digest, or
+  // else for one with the same digest, e.g. a function that was renamed. A
+  // function can also be rebuilt from the old function that is mapped to it,
+  // and a section from the old section, with the function indices in them
+  // mapped.
+  std::unordered_map<std::string, const BinaryItemHash*> old_by_key;
+  std::unordered_map<std::string, const BinaryItemHash*> old_by_digest;
+  for (const BinaryItemHash& item : old_module.items) {
+    std::string kind = GetBinaryItemKindName(item.kind);
+    old_by_key.emplace(kind + " " + item.key, &item);
+    old_by_digest.emplace(kind + " " + item.digest, &item);
+  }
+  std::vector<const BinaryItemHash*> mapped_funcs(new_module.funcs.size());
+  for (Index i = 0; i < func_map.size(); ++i) {
+    if (old_module.funcs[i] && func_map[i] < mapped_funcs.size() &&
+        !mapped_funcs[func_map[i]]) {
+      mapped_funcs[func_map[i]] = old_module.funcs[i];
+    }
+  }
+
+  PatchWriter writer(new_data, &stream);
+  MemoryStream rebuilt;
+  Offset offset = 0;
+  // Adds the commands for |item| if |old_item| gives exactly its bytes.
+  auto add_item = [&](const BinaryItemHash& item,
+                      const BinaryItemHash* old_item) {
+    Offset end = item.offset + item.size;
+    if (item.kind != BinaryItemHash::Kind::Function &&
+        old_item->size == item.size &&
+        memcmp(old_data.data() + old_item->offset,
+               new_data.data() + item.offset, item.size) == 0) {
+      writer.Literal(offset, item.offset);
+      writer.Copy(old_item->offset, item.size);
+      offset = end;
+      return true;
+    }
+    if (item.kind != BinaryItemHash::Kind::Function &&
+        old_item->func_refs.empty()) {
+      return false;
+    }
+
+    // The rebuilt item includes its size, which comes before the item's
+    // bytes.
+    rebuilt.Truncate(0);
+    if (Failed(RebuildItem(old_data, *old_item, func_map, &rebuilt))) {
+      return false;
+    }
+    const std::vector<uint8_t>& bytes = rebuilt.output_buffer().data;
+    if (bytes.size() > end - offset ||
+        memcmp(bytes.data(), new_data.data() + end - bytes.size(),
+               bytes.size()) != 0) {
+      return false;
+    }
+    writer.Literal(offset, end - bytes.size());
+    if (item.kind == BinaryItemHash::Kind::Function) {
+      writer.Funcs(old_item->index);
+    } else {
+      writer.Section(old_item->index);
+    }
+    offset = end;
+    return true;
+  };
+
+  for (const BinaryItemHash& item : new_module.items) {
+    std::string kind = GetBinaryItemKindName(item.kind);
+    const BinaryItemHash* candidates[3] = {};
+    const BinaryItemHash* same_key = nullptr;
+    auto iter = old_by_key.find(kind + " " + item.key);
+    if (iter != old_by_key.end()) {
+      same_key = iter->second;
+      if (same_key->digest == item.digest) {
+        candidates[0] = same_key;
+      }
+    }
+    iter = old_by_digest.find(kind + " " + item.digest);
+    if (iter != old_by_digest.end()) {
+      candidates[1] = iter->second;
+    }
+    if (item.kind == BinaryItemHash::Kind::Function) {
+      if (item.index < mapped_funcs.size()) {
+        candidates[2] = mapped_funcs[item.index];
+      }
+    } else if (item.kind == BinaryItemHash::Kind::Section) {
+      candidates[2] = same_key;
+    }
+    bool added = false;
+    for (const BinaryItemHash* old_item : candidates) {
+      if (old_item && add_item(item, old_item)) {
+        added = true;
+        break;
+      }
+    }
+
+    // A changed section or data segment often only has bytes inserted,
+    // removed or changed in one place, so its start and end can still be
+    // copied from the old version.
+    if (!added && same_key && item.kind != BinaryItemHash::Kind::Function) {
+      const uint8_t* old_bytes = old_data.data() + same_key->offset;
+      const uint8_t* new_bytes = new_data.data() + item.offset;
+      Offset max_size = std::min(same_key->size, item.size);
+      Offset prefix = 0;
+      while (prefix < max_size && old_bytes[prefix] == new_bytes[prefix]) {
+        prefix++;
+      }
+      Offset suffix = 0;
+      while (suffix < max_size - prefix &&
+             old_bytes[same_key->size - suffix - 1] ==
+                 new_bytes[item.size - suffix - 1]) {
+        suffix++;
+      }
+      Offset end = item.offset + item.size;
+      writer.Literal(offset, item.offset);
+      writer.Copy(same_key->offset, prefix);
+      writer.Literal(item.offset + prefix, end - suffix);
+      writer.Copy(same_key->offset + same_key->size - suffix, suffix);
+      offset = end;
+    }
+  }
+  writer.Literal(offset, new_data.size());
+  writer.Flush();
+
+  *patch = std::move(stream.output_buffer().data);
+  return stream.result();
+}
+
+Result ApplyBinaryPatch(const std::vector<uint8_t>& old_data,
+                        const std::vector<uint8_t>& patch,
+                        const ReadBinaryOptions& options,
+                        std::vector<uint8_t>* new_data,
+                        Errors* errors) {
+  PatchReader reader(patch, errors);
+  std::string_view magic;
+  uint32_t version;
+  CHECK_RESULT(reader.ReadBytes(sizeof(kPatchMagic), &magic, "magic"));
+  if (magic != std::string_view(kPatchMagic, sizeof(kPatchMagic))) {
+    return reader.Error("bad magic value");
+  }
+  CHECK_RESULT(reader.ReadU32Leb128(&version, "version"));
+  if (version != kPatchVersion) {
+    return reader.Error("bad patch version: %u", version);
+  }
+  std::string_view old_digest;
+  std::string_view new_digest;
+  uint32_t new_size;
+  CHECK_RESULT(reader.ReadBytes(kDigestSize, &old_digest, "old digest"));
+  CHECK_RESULT(reader.ReadBytes(kDigestSize, &new_digest, "new digest"));
+  CHECK_RESULT(reader.ReadU32Leb128(&new_size, "new size"));
+  if (GetDigest(old_data) != old_digest) {
+    return reader.Error("patch is for a different module");
+  }
+
+  uint32_t num_runs;
+  std::vector<Index> func_map;
+  CHECK_RESULT(reader.ReadU32Leb128(&num_runs, "run count"));
+  for (uint32_t i = 0; i < num_runs; ++i) {
+    uint32_t count;
+    int64_t delta;
+    CHECK_RESULT(reader.ReadU32Leb128(&count, "function count"));
+    CHECK_RESULT(reader.ReadS64Leb128(&delta, "index delta"));
+    // Every function takes at least one byte of the old module.
+    if (count > old_data.size() - func_map.size()) {
+      return reader.Error("invalid function count: %u", count);
+    }
+    for (uint32_t j = 0; j < count; ++j) {
+      int64_t new_index = static_cast<int64_t>(func_map.size()) + delta;
+      if (new_index < 0 || new_index >= kInvalidIndex) {
+        return reader.Error("invalid index delta: %" PRId64, delta);
+      }
+      func_map.push_back(static_cast<Index>(new_index));
+    }
+  }
+
+  // The old module only has to be read for the function bodies and sections
+  // that are rebuilt.
+  ModuleItems old_module(old_data);
+  bool read_old_module = false;
+  auto read_old_module_once = [&]() -> Result {
+    if (!read_old_module) {
+      CHECK_RESULT(old_module.Read(options, "old module", errors));
+      read_old_module = true;
+    }
+    return Result::Ok;
+  };
+
+  // No command may write past the size of the new module.
+  MemoryStream stream;
+  auto check_size = [&](Offset size) -> Result {
+    if (stream.output_buffer().size() + size > new_size) {
+      return reader.Error("patched module is larger than the new module");
+    }
+    return Result::Ok;
+  };
+  while (!reader.AtEnd()) {
+    uint8_t command;
+    CHECK_RESULT(reader.ReadU8(&command, "command"));
+    switch (static_cast<PatchCommand>(command)) {
+      case PatchCommand::Literal: {
+        uint32_t size;
+        std::string_view bytes;
+        CHECK_RESULT(reader.ReadU32Leb128(&size, "size"));
+        CHECK_RESULT(reader.ReadBytes(size, &bytes, "literal bytes"));
+        CHECK_RESULT(check_size(size));
+        stream.WriteData(bytes.data(), bytes.size());
+        break;
+      }
+
+      case PatchCommand::Copy: {
+        uint32_t offset;
+        uint32_t size;
+        CHECK_RESULT(reader.ReadU32Leb128(&offset, "offset"));
+        CHECK_RESULT(reader.ReadU32Leb128(&size, "size"));
+        if (offset > old_data.size() || size > old_data.size() - offset) {
+          return reader.Error("copy out of range of the old module");
+        }
+        CHECK_RESULT(check_size(size));
+        stream.WriteData(old_data.data() + offset, size);
+        break;
+      }
+
+      case PatchCommand::Funcs: {
+        uint32_t index;
+        uint32_t count;
+        CHECK_RESULT(reader.ReadU32Leb128(&index, "function index"));
+        CHECK_RESULT(reader.ReadU32Leb128(&count, "function count"));
+        CHECK_RESULT(read_old_module_once());
+        for (uint64_t i = index; i < uint64_t(index) + count; ++i) {
+          if (i >= old_module.funcs.size() || !old_module.funcs[i] ||
+              Failed(RebuildItem(old_data, *old_module.funcs[i], func_map,
+                                 &stream))) {
+            return reader.Error("invalid function index: %" PRIu64, i);
+          }
+          CHECK_RESULT(check_size(0));
+        }
+        break;
+      }
+
+      case PatchCommand::Section: {
+        uint32_t index;
+        CHECK_RESULT(reader.ReadU32Leb128(&index, "section index"));
+        CHECK_RESULT(read_old_module_once());
+        auto iter = old_module.sections.find(index);
+        if (iter == old_module.sections.end() ||
+            Failed(RebuildItem(old_data, *iter->second, func_map, &stream))) {
+          return reader.Error("invalid section index: %u", index);
+        }
+        CHECK_RESULT(check_size(0));
+        break;
+      }
+
+      default:
+        return reader.Error("unknown command: %u", command);
+    }
+  }
+
+  CHECK_RESULT(stream.result());
+  *new_data = std::move(stream.output_buffer().data);
+  if (GetDigest(*new_data) != new_digest) {
+    return reader.Error("patched module does not match the new module");
+  }
+  return Result::Ok;
+}
+
+}  // namespace wabt
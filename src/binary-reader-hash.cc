@@ -0,0 +1,382 @@
+/*
+ * Copyright 2026 WebAssembly Community Group participants
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "wabt/binary-reader-hash.h"
+
+#include <string_view>
+#include <unordered_map>
+#include <unordered_set>
+
+#include "wabt/binary-reader-nop.h"
+#include "wabt/binary-reader.h"
+#include "wabt/binary.h"
+#include "wabt/sha256.h"
+
+namespace wabt {
+
+namespace {
+
+class BinaryReaderHash : public BinaryReaderNop {
+ public:
+  BinaryReaderHash(const void* data,
+                   std::vector<BinaryItemHash>* items,
+                   std::vector<std::string>* func_keys);
+
+  Result EndModule() override;
+
+  Result BeginSection(Index section_index,
+                      BinarySection section_type,
+                      Offset size) override;
+  Result BeginCustomSection(Index section_index,
+                            Offset size,
+                            std::string_view section_name) override;
+
+  Result OnImportFunc(Index import_index,
+                      std::string_view module_name,
+                      std::string_view field_name,
+                      Index func_index,
+                      Index sig_index) override;
+  Result OnExport(Index index,
+                  ExternalKind kind,
+                  Index item_index,
+                  std::string_view name) override;
+  Result OnStartFunction(Index func_index) override;
+
+  Result BeginElemSegment(Index index,
+                          Index table_index,
+                          uint8_t flags) override;
+  Result BeginElemExpr(Index elem_index, Index expr_index) override;
+  Result EndElemExpr(Index elem_index, Index expr_index) override;
+
+  Result BeginFunctionBody(Index index, Offset size) override;
+  Result OnOpcode(Opcode opcode) override;
+  Result OnCallExpr(Index func_index) override;
+  Result OnReturnCallExpr(Index func_index) override;
+  Result OnRefFuncExpr(Index func_index) override;
+  Result EndFunctionBody(Index index) override;
+
+  Result OnDataSegmentCount(Index count) override;
+  Result EndDataSegment(Index index) override;
+
+  Result OnFunctionName(Index function_index,
+                        std::string_view function_name) override;
+  Result OnNameEntry(NameSectionSubsection type,
+                     Index index,
+                     std::string_view name) override;
+
+ private:
+  std::string_view GetBytes(Offset offset, Offset size) const;
+  Result OnFuncRef(Offset offset, Index func_index);
+  std::vector<std::string> GetFunctionKeys() const;
+
+  const char* data_;
+  std::vector<BinaryItemHash>* items_;
+  std::vector<std::string>* func_keys_;
+
+  Offset section_offset_ = 0;
+  Offset section_size_ = 0;
+  // The item of the current section, if it is hashed as a whole.
+  Index section_item_ = kInvalidIndex;
+  std::unordered_map<std::string, Index> custom_section_counts_;
+
+  Index num_func_imports_ = 0;
+  std::unordered_map<Index, std::string> import_names_;
+  std::unordered_map<Index, std::string> export_names_;
+  std::unordered_map<Index, std::string> func_names_;
+  std::unordered_map<Index, std::string> data_segment_names_;
+
+  std::vector<size_t> functions_;
+  BinaryItemHash* current_function_ = nullptr;
+  Offset opcode_end_ = 0;
+  uint8_t elem_segment_flags_ = 0;
+  // Elem segments without elem exprs only hold function indices, and report
+  // each as a ref.func opcode after reading it.
+  bool in_func_index_elem_expr_ = false;
+
+  std::vector<size_t> data_segments_;
+  Offset data_segment_offset_ = 0;
+};
+
+BinaryReaderHash::BinaryReaderHash(const void* data,
+                                   std::vector<BinaryItemHash>* items,
+                                   std::vector<std::string>* func_keys)
+    : data_(static_cast<const char*>(data)),
+      items_(items),
+      func_keys_(func_keys) {}
+
+std::string_view BinaryReaderHash::GetBytes(Offset offset, Offset size) const {
+  return std::string_view(data_ + offset, size);
+}
+
+Result BinaryReaderHash::BeginSection(Index section_index,
+                                      BinarySection section_type,
+                                      Offset size) {
+  section_offset_ = state->offset;
+  section_size_ = size;
+  section_item_ = kInvalidIndex;
+  // The code and data sections are hashed per function body and per
+  // segment instead, and custom sections once their name is known.
+  if (section_type != BinarySection::Custom &&
+      section_type != BinarySection::Code &&
+      section_type != BinarySection::Data) {
+    BinaryItemHash item;
+    item.kind = BinaryItemHash::Kind::Section;
+    item.key = GetSectionName(section_type);
+    item.index = section_index;
+    item.offset = state->offset;
+    item.size = size;
+    sha256(GetBytes(item.offset, item.size), item.digest);
+    section_item_ = static_cast<Index>(items_->size());
+    items_->push_back(std::move(item));
+  }
+  return Result::Ok;
+}
+
+Result BinaryReaderHash::BeginCustomSection(Index section_index,
+                                            Offset size,
+                                            std::string_view section_name) {
+  std::string name(section_name);
+  Index count = custom_section_counts_[name]++;
+  BinaryItemHash item;
+  item.kind = BinaryItemHash::Kind::CustomSection;
+  item.key = count == 0 ? name : name + "#" + std::to_string(count + 1);
+  item.index = section_index;
+  item.offset = section_offset_;
+  item.size = section_size_;
+  sha256(GetBytes(item.offset, item.size), item.digest);
+  items_->push_back(std::move(item));
+  return Result::Ok;
+}
+
+Result BinaryReaderHash::OnImportFunc(Index import_index,
+                                      std::string_view module_name,
+                                      std::string_view field_name,
+                                      Index func_index,
+                                      Index sig_index) {
+  num_func_imports_++;
+  import_names_[func_index] =
+      "import:" + std::string(module_name) + "." + std::string(field_name);
+  return Result::Ok;
+}
+
+Result BinaryReaderHash::OnExport(Index index,
+                                  ExternalKind kind,
+                                  Index item_index,
+                                  std::string_view name) {
+  if (kind == ExternalKind::Func) {
+    // A function exported more than once is known by its first export.
+    export_names_.emplace(item_index, "export:" + std::string(name));
+    // The index follows the name and the kind.
+    return OnFuncRef(name.data() + name.size() + 1 - data_, item_index);
+  }
+  return Result::Ok;
+}
+
+Result BinaryReaderHash::OnStartFunction(Index func_index) {
+  return OnFuncRef(section_offset_, func_index);
+}
+
+Result BinaryReaderHash::BeginElemSegment(Index index,
+                                          Index table_index,
+                                          uint8_t flags) {
+  elem_segment_flags_ = flags;
+  return Result::Ok;
+}
+
+Result BinaryReaderHash::BeginElemExpr(Index elem_index, Index expr_index) {
+  if (!(elem_segment_flags_ & SegUseElemExprs)) {
+    in_func_index_elem_expr_ = true;
+    opcode_end_ = state->offset;
+  }
+  return Result::Ok;
+}
+
+Result BinaryReaderHash::EndElemExpr(Index elem_index, Index expr_index) {
+  in_func_index_elem_expr_ = false;
+  return Result::Ok;
+}
+
+Result BinaryReaderHash::BeginFunctionBody(Index index, Offset size) {
+  BinaryItemHash item;
+  item.kind = BinaryItemHash::Kind::Function;
+  item.index = index;
+  item.offset = state->offset;
+  item.size = size;
+  functions_.push_back(items_->size());
+  items_->push_back(std::move(item));
+  current_function_ = &items_->back();
+  return Result::Ok;
+}
+
+Result BinaryReaderHash::OnOpcode(Opcode opcode) {
+  if (!in_func_index_elem_expr_) {
+    opcode_end_ = state->offset;
+  }
+  return Result::Ok;
+}
+
+// Records the function index in [offset, state->offset).
+Result BinaryReaderHash::OnFuncRef(Offset offset, Index func_index) {
+  if (current_function_) {
+    current_function_->func_refs.push_back({offset, state->offset, func_index});
+  } else if (section_item_ != kInvalidIndex) {
+    (*items_)[section_item_].func_refs.push_back(
+        {offset, state->offset, func_index});
+  }
+  return Result::Ok;
+}
+
+Result BinaryReaderHash::OnCallExpr(Index func_index) {
+  return OnFuncRef(opcode_end_, func_index);
+}
+
+Result BinaryReaderHash::OnReturnCallExpr(Index func_index) {
+  return OnFuncRef(opcode_end_, func_index);
+}
+
+Result BinaryReaderHash::OnRefFuncExpr(Index func_index) {
+  return OnFuncRef(opcode_end_, func_index);
+}
+
+Result BinaryReaderHash::EndFunctionBody(Index index) {
+  current_function_ = nullptr;
+  return Result::Ok;
+}
+
+Result BinaryReaderHash::OnDataSegmentCount(Index count) {
+  data_segment_offset_ = state->offset;
+  return Result::Ok;
+}
+
+Result BinaryReaderHash::EndDataSegment(Index index) {
+  BinaryItemHash item;
+  item.kind = BinaryItemHash::Kind::DataSegment;
+  item.index = index;
+  item.offset = data_segment_offset_;
+  item.size = state->offset - data_segment_offset_;
+  sha256(GetBytes(item.offset, item.size), item.digest);
+  data_segments_.push_back(items_->size());
+  items_->push_back(std::move(item));
+  data_segment_offset_ = state->offset;
+  return Result::Ok;
+}
+
+Result BinaryReaderHash::OnFunctionName(Index function_index,
+                                        std::string_view function_name) {
+  func_names_[function_index] = "$" + std::string(function_name);
+  return Result::Ok;
+}
+
+Result BinaryReaderHash::OnNameEntry(NameSectionSubsection type,
+                                     Index index,
+                                     std::string_view name) {
+  if (type == NameSectionSubsection::DataSegment) {
+    data_segment_names_[index] = "$" + std::string(name);
+  }
+  return Result::Ok;
+}
+
+std::vector<std::string> BinaryReaderHash::GetFunctionKeys() const {
+  std::vector<std::string> keys(num_func_imports_ + functions_.size());
+  std::unordered_set<std::string> used;
+  for (Index i = 0; i < keys.size(); ++i) {
+    std::string key = "#" + std::to_string(i);
+    for (auto* names : {&func_names_, &export_names_, &import_names_}) {
+      auto iter = names->find(i);
+      if (iter != names->end()) {
+        key = iter->second;
+        break;
+      }
+    }
+    // Keys must identify a function uniquely, but names don't have to be
+    // unique.
+    if (!used.insert(key).second) {
+      key += "#" + std::to_string(i);
+      used.insert(key);
+    }
+    keys[i] = std::move(key);
+  }
+  return keys;
+}
+
+Result BinaryReaderHash::EndModule() {
+  // Function and data segment names are only known once the name section has
+  // been read, so keys and function hashes are filled in last.
+  std::vector<std::string> keys = GetFunctionKeys();
+  std::string normalized;
+  for (size_t item_index : functions_) {
+    BinaryItemHash& item = (*items_)[item_index];
+    item.key = keys[item.index];
+
+    normalized.clear();
+    Offset offset = item.offset;
+    for (const BinaryFuncRef& ref : item.func_refs) {
+      normalized += GetBytes(offset, ref.offset - offset);
+      std::string callee = ref.func_index < keys.size()
+                               ? keys[ref.func_index]
+                               : "#" + std::to_string(ref.func_index);
+      normalized += std::to_string(callee.size()) + ":" + callee;
+      offset = ref.end;
+    }
+    normalized += GetBytes(offset, item.offset + item.size - offset);
+    sha256(normalized, item.digest);
+  }
+
+  std::unordered_set<std::string> used;
+  for (size_t item_index : data_segments_) {
+    BinaryItemHash& item = (*items_)[item_index];
+    auto iter = data_segment_names_.find(item.index);
+    item.key = iter != data_segment_names_.end()
+                   ? iter->second
+                   : "#" + std::to_string(item.index);
+    if (!used.insert(item.key).second) {
+      item.key += "#" + std::to_string(item.index);
+      used.insert(item.key);
+    }
+  }
+
+  if (func_keys_) {
+    *func_keys_ = std::move(keys);
+  }
+  return Result::Ok;
+}
+
+}  // end anonymous namespace
+
+const char* GetBinaryItemKindName(BinaryItemHash::Kind kind) {
+  switch (kind) {
+    case BinaryItemHash::Kind::Section:
+      return "section";
+    case BinaryItemHash::Kind::Function:
+      return "func";
+    case BinaryItemHash::Kind::DataSegment:
+      return "data";
+    case BinaryItemHash::Kind::CustomSection:
+      return "custom";
+  }
+  WABT_UNREACHABLE;
+}
+
+Result ReadBinaryHashes(const void* data,
+                        size_t size,
+                        const ReadBinaryOptions& options,
+                        std::vector<BinaryItemHash>* items,
+                        std::vector<std::string>* func_keys) {
+  BinaryReaderHash reader(data, items, func_keys);
+  return ReadBinary(data, size, &reader, options);
+}
+
+}  // namespace wabt
@@ -21,6 +21,8 @@
 #include <cinttypes>
 #include <cstdio>
 #include <cstring>
+#include <set>
+#include <thread>
 #include <vector>
 
 #if HAVE_STRCASECMP
@@ -30,6 +32,7 @@
 #include "wabt/binary-reader-nop.h"
 #include "wabt/filenames.h"
 #include "wabt/literal.h"
+#include "wabt/string-format.h"
 #include "wabt/string-util.h"
 
 namespace wabt {
@@ -63,7 +66,7 @@ class BinaryReaderObjdumpBase : public BinaryReaderNop {
   std::string_view GetSymbolName(Index index) const;
   std::string_view GetSegmentName(Index index) const;
   std::string_view GetTableName(Index index) const;
-  void PrintRelocation(const Reloc& reloc, Offset offset) const;
+  void PrintRelocation(Stream* out, const Reloc& reloc, Offset offset) const;
   Offset GetPrintOffset(Offset offset) const;
   Offset GetSectionStart(BinarySection section_code) const {
     return section_starts_[static_cast<size_t>(section_code)];
@@ -198,18 +201,19 @@ std::string_view BinaryReaderObjdumpBase::GetSymbolName(
   WABT_UNREACHABLE;
 }
 
-void BinaryReaderObjdumpBase::PrintRelocation(const Reloc& reloc,
+void BinaryReaderObjdumpBase::PrintRelocation(Stream* out,
+                                              const Reloc& reloc,
                                               Offset offset) const {
-  printf("           %06" PRIzx ": %-18s %" PRIindex, offset,
-         GetRelocTypeName(reloc.type), reloc.index);
+  out->Writef("           %06" PRIzx ": %-18s %" PRIindex, offset,
+              GetRelocTypeName(reloc.type), reloc.index);
   if (reloc.addend) {
-    printf(" + %d", reloc.addend);
+    out->Writef(" + %d", reloc.addend);
   }
   if (reloc.type != RelocType::TypeIndexLEB) {
-    printf(" <" PRIstringview ">",
-           WABT_PRINTF_STRING_VIEW_ARG(GetSymbolName(reloc.index)));
+    out->Writef(" <" PRIstringview ">",
+                WABT_PRINTF_STRING_VIEW_ARG(GetSymbolName(reloc.index)));
   }
-  printf("\n");
+  out->Writef("\n");
 }
 
 Offset BinaryReaderObjdumpBase::GetPrintOffset(Offset offset) const {
@@ -246,6 +250,8 @@ class BinaryReaderObjdumpPrepass : public BinaryReaderObjdumpBase {
       objdump_state_->section_names.Set(section_index,
                                         wabt::GetSectionName(section_code));
     }
+    objdump_state_->sections.push_back(
+        {section_code, std::string(), state->offset, size, kInvalidIndex});
     return Result::Ok;
   }
 
@@ -253,6 +259,36 @@ class BinaryReaderObjdumpPrepass : public BinaryReaderObjdumpBase {
                             Offset size,
                             std::string_view section_name) override {
     objdump_state_->section_names.Set(section_index, section_name);
+    objdump_state_->sections.back().name = section_name;
+    return Result::Ok;
+  }
+
+  Result OnTypeCount(Index count) override { return SetSectionCount(count); }
+  Result OnImportCount(Index count) override { return SetSectionCount(count); }
+  Result OnFunctionCount(Index count) override {
+    return SetSectionCount(count);
+  }
+  Result OnTableCount(Index count) override { return SetSectionCount(count); }
+  Result OnMemoryCount(Index count) override { return SetSectionCount(count); }
+  Result OnGlobalCount(Index count) override { return SetSectionCount(count); }
+  Result OnExportCount(Index count) override { return SetSectionCount(count); }
+  Result OnStartFunction(Index func_index) override {
+    return SetSectionCount(func_index);
+  }
+  Result OnElemSegmentCount(Index count) override {
+    return SetSectionCount(count);
+  }
+  Result OnFunctionBodyCount(Index count) override {
+    return SetSectionCount(count);
+  }
+  Result OnDataSegmentCount(Index count) override {
+    return SetSectionCount(count);
+  }
+  Result OnDataCount(Index count) override { return SetSectionCount(count); }
+  Result OnTagCount(Index count) override { return SetSectionCount(count); }
+
+  Result BeginFunctionBody(Index index, Offset size) override {
+    objdump_state_->function_bodies.push_back({index, state->offset, size});
     return Result::Ok;
   }
 
@@ -261,6 +297,11 @@ class BinaryReaderObjdumpPrepass : public BinaryReaderObjdumpBase {
     return Result::Ok;
   }
 
+  Result OnFunction(Index index, Index sig_index) override {
+    objdump_state_->function_types[index] = sig_index;
+    return Result::Ok;
+  }
+
   Result OnFuncType(Index index,
                     Index param_count,
                     Type* param_types,
@@ -453,6 +494,10 @@ class BinaryReaderObjdumpPrepass : public BinaryReaderObjdumpBase {
   }
 
  protected:
+  Result SetSectionCount(Index count) {
+    objdump_state_->sections.back().count = count;
+    return Result::Ok;
+  }
   void SetTypeName(Index index, std::string_view name);
   void SetFunctionName(Index index, std::string_view name);
   void SetGlobalName(Index index, std::string_view name);
@@ -515,11 +560,18 @@ Result BinaryReaderObjdumpPrepass::OnReloc(RelocType type,
 
 class BinaryReaderObjdumpDisassemble : public BinaryReaderObjdumpBase {
  public:
-  using BinaryReaderObjdumpBase::BinaryReaderObjdumpBase;
+  // The disassembly is written to |out_stream|, or to stdout if it is null.
+  // When writing to |out_stream| the "Code Disassembly:" heading is not
+  // printed, so that the output of several readers can be concatenated.
+  BinaryReaderObjdumpDisassemble(const uint8_t* data,
+                                 size_t size,
+                                 ObjdumpOptions* options,
+                                 ObjdumpState* state,
+                                 Stream* out_stream = nullptr);
 
   std::string BlockSigToString(Type type) const;
 
-  Result OnFunction(Index index, Index sig_index) override;
+  Result BeginModule(uint32_t version) override;
 
   Result BeginFunctionBody(Index index, Offset size) override;
   Result EndFunctionBody(Index index) override;
@@ -559,6 +611,9 @@ class BinaryReaderObjdumpDisassemble : public BinaryReaderObjdumpBase {
  private:
   void LogOpcode(const char* fmt, ...);
 
+  std::unique_ptr<FileStream> stdout_stream_;
+  Stream* out_;
+
   Offset current_opcode_offset = 0;
   Offset last_opcode_end = 0;
   int indent_level = 0;
@@ -629,24 +684,24 @@ Result BinaryReaderObjdumpDisassemble::OnLocalDecl(Index decl_index,
   Offset offset = current_opcode_offset;
   size_t data_size = state->offset - offset;
 
-  printf(" %06" PRIzx ":", GetPrintOffset(offset));
+  out_->Writef(" %06" PRIzx ":", GetPrintOffset(offset));
   for (size_t i = 0; i < data_size && i < IMMEDIATE_OCTET_COUNT;
        i++, offset++) {
-    printf(" %02x", data_[offset]);
+    out_->Writef(" %02x", data_[offset]);
   }
   for (size_t i = data_size; i < IMMEDIATE_OCTET_COUNT; i++) {
-    printf("   ");
+    out_->Writef("   ");
   }
-  printf(" | local[");
+  out_->Writef(" | local[");
   if (count > 0) {
-    printf("%" PRIindex, local_index_);
+    out_->Writef("%" PRIindex, local_index_);
 
     if (count != 1) {
-      printf("..%" PRIindex "", local_index_ + count - 1);
+      out_->Writef("..%" PRIindex "", local_index_ + count - 1);
     }
     local_index_ += count;
   }
-  printf("] type=%s\n", type.GetName().c_str());
+  out_->Writef("] type=%s\n", type.GetName().c_str());
 
   last_opcode_end = current_opcode_offset + data_size;
   current_opcode_offset = last_opcode_end;
@@ -675,17 +730,17 @@ void BinaryReaderObjdumpDisassemble::LogOpcode(const char* fmt, ...) {
   while (offset < offset_end) {
     // Print bytes, but only display a maximum of IMMEDIATE_OCTET_COUNT on each
     // line.
-    printf(" %06" PRIzx ":", GetPrintOffset(offset));
+    out_->Writef(" %06" PRIzx ":", GetPrintOffset(offset));
     size_t i;
     for (i = 0; offset < offset_end && i < IMMEDIATE_OCTET_COUNT;
          ++i, ++offset) {
-      printf(" %02x", data_[offset]);
+      out_->Writef(" %02x", data_[offset]);
     }
     // Fill the rest of the remaining space with spaces.
     for (; i < IMMEDIATE_OCTET_COUNT; ++i) {
-      printf("   ");
+      out_->Writef("   ");
     }
-    printf(" | ");
+    out_->Writef(" | ");
 
     if (first_line) {
       first_line = false;
@@ -702,21 +757,19 @@ void BinaryReaderObjdumpDisassemble::LogOpcode(const char* fmt, ...) {
           break;
       }
       for (int j = 0; j < indent_level; j++) {
-        printf("  ");
+        out_->Writef("  ");
       }
 
       const char* opcode_name = current_opcode.GetName();
-      printf("%s", opcode_name);
+      out_->Writef("%s", opcode_name);
       if (fmt) {
-        printf(" ");
-        va_list args;
-        va_start(args, fmt);
-        vprintf(fmt, args);
-        va_end(args);
+        out_->Writef(" ");
+        WABT_SNPRINTF_ALLOCA(buffer, length, fmt);
+        out_->WriteData(buffer, length);
       }
     }
 
-    printf("\n");
+    out_->Writef("\n");
   }
 
   last_opcode_end = state->offset;
@@ -728,7 +781,7 @@ void BinaryReaderObjdumpDisassemble::LogOpcode(const char* fmt, ...) {
     Offset code_start = GetSectionStart(BinarySection::Code);
     Offset abs_offset = code_start + reloc.offset;
     if (last_opcode_end > abs_offset) {
-      PrintRelocation(reloc, abs_offset);
+      PrintRelocation(out_, reloc, abs_offset);
       next_reloc++;
     }
   }
@@ -990,27 +1043,61 @@ Result BinaryReaderObjdumpDisassemble::OnEndExpr() {
   return Result::Ok;
 }
 
-Result BinaryReaderObjdumpDisassemble::OnFunction(Index index,
-                                                  Index sig_index) {
-  objdump_state_->function_types[index] = sig_index;
+BinaryReaderObjdumpDisassemble::BinaryReaderObjdumpDisassemble(
+    const uint8_t* data,
+    size_t size,
+    ObjdumpOptions* options,
+    ObjdumpState* objdump_state,
+    Stream* out_stream)
+    : BinaryReaderObjdumpBase(data, size, options, objdump_state),
+      out_(out_stream) {
+  if (!out_) {
+    stdout_stream_ = FileStream::CreateStdout();
+    out_ = stdout_stream_.get();
+  }
+}
+
+Result BinaryReaderObjdumpDisassemble::BeginModule(uint32_t version) {
+  if (stdout_stream_) {
+    return BinaryReaderObjdumpBase::BeginModule(version);
+  }
   return Result::Ok;
 }
 
 Result BinaryReaderObjdumpDisassemble::BeginFunctionBody(Index index,
                                                          Offset size) {
-  printf("%06" PRIzx " func[%" PRIindex "]", GetPrintOffset(state->offset),
-         index);
+  out_->Writef("%06" PRIzx " func[%" PRIindex "]",
+               GetPrintOffset(state->offset), index);
   auto name = GetFunctionName(index);
   if (!name.empty()) {
-    printf(" <" PRIstringview ">", WABT_PRINTF_STRING_VIEW_ARG(name));
+    out_->Writef(" <" PRIstringview ">", WABT_PRINTF_STRING_VIEW_ARG(name));
+  }
+  out_->Writef(":\n");
+
+  // Skip the relocations of any bodies before this one that were not read,
+  // either because of --func or because another thread disassembles them.
+  if (!options_->functions.empty() || !stdout_stream_) {
+    Offset code_start = GetSectionStart(BinarySection::Code);
+    while (next_reloc < objdump_state_->code_relocations.size() &&
+           code_start + objdump_state_->code_relocations[next_reloc].offset <
+               state->offset) {
+      next_reloc++;
+    }
   }
-  printf(":\n");
 
   last_opcode_end = 0;
   in_function_body = true;
   current_function_index = index;
-  auto type_index = objdump_state_->function_types[index];
-  local_index_ = objdump_state_->function_param_counts[type_index];
+  // Only look up the prepass results here; several readers may share them.
+  local_index_ = 0;
+  auto type_iter = objdump_state_->function_types.find(index);
+  if (type_iter != objdump_state_->function_types.end()) {
+    auto count_iter =
+        objdump_state_->function_param_counts.find(type_iter->second);
+    if (count_iter != objdump_state_->function_param_counts.end()) {
+      local_index_ = count_iter->second;
+    }
+  }
   return Result::Ok;
 }
 
@@ -1428,7 +1515,7 @@ Result BinaryReaderObjdump::EndModule() {
       for (size_t i = next_data_reloc_;
            i < objdump_state_->data_relocations.size(); i++) {
         const Reloc& reloc = objdump_state_->data_relocations[i];
-        PrintRelocation(reloc, reloc.offset);
+        PrintRelocation(out_stream_.get(), reloc, reloc.offset);
       }
 
       return Result::Error;
@@ -1527,7 +1614,6 @@ Result BinaryReaderObjdump::OnFunction(Index index, Index sig_index) {
     PrintDetails(" <" PRIstringview ">", WABT_PRINTF_STRING_VIEW_ARG(name));
   }
   PrintDetails("\n");
-  objdump_state_->function_types[index] = sig_index;
   return Result::Ok;
 }
 
@@ -2086,7 +2172,8 @@ Result BinaryReaderObjdump::OnDataSegmentData(Index index,
     if (abs_offset > state->offset) {
       break;
     }
-    PrintRelocation(reloc, reloc.offset - segment_offset + data_offset_);
+    PrintRelocation(out_stream_.get(), reloc,
+                    reloc.offset - segment_offset + data_offset_);
     next_data_reloc_++;
   }
 
@@ -2489,6 +2576,190 @@ void ObjdumpLocalNames::Set(Index function_index,
       std::string(name);
 }
 
+namespace {
+
+bool SectionMatches(const ObjdumpOptions* options,
+                    const ObjdumpSection& section) {
+  if (!options->section_name) {
+    return true;
+  }
+  const char* match_name = section.code == BinarySection::Custom
+                               ? section.name.c_str()
+                               : wabt::GetSectionName(section.code);
+  return !strcasecmp(options->section_name, match_name);
+}
+
+Result CheckSectionFound(const ObjdumpOptions* options,
+                         const ObjdumpState* state) {
+  for (const ObjdumpSection& section : state->sections) {
+    if (SectionMatches(options, section)) {
+      return Result::Ok;
+    }
+  }
+  fprintf(stderr, "Section not found: %s\n", options->section_name);
+  return Result::Error;
+}
+
+// Same output as the Headers pass of BinaryReaderObjdump, but printed from the
+// section index.
+Result DumpHeaders(const ObjdumpOptions* options, const ObjdumpState* state) {
+  printf("\n");
+  printf("Sections:\n\n");
+  for (const ObjdumpSection& section : state->sections) {
+    printf("%9s start=%#010" PRIzx " end=%#010" PRIzx " (size=%#010" PRIoffset
+           ") ",
+           wabt::GetSectionName(section.code), section.offset,
+           section.offset + section.size, section.size);
+    switch (section.code) {
+      case BinarySection::Custom:
+        printf("\"" PRIstringview "\"\n",
+               WABT_PRINTF_STRING_VIEW_ARG(section.name));
+        break;
+      case BinarySection::Start:
+        printf("start: %" PRIindex "\n", section.count);
+        break;
+      default:
+        printf("count: %" PRIindex "\n", section.count);
+        break;
+    }
+  }
+  return CheckSectionFound(options, state);
+}
+
+// Same output as the RawData pass of BinaryReaderObjdump, but printed from the
+// section index.
+Result DumpRawData(const uint8_t* data,
+                   const ObjdumpOptions* options,
+                   const ObjdumpState* state) {
+  std::unique_ptr<FileStream> out_stream = FileStream::CreateStdout();
+  for (const ObjdumpSection& section : state->sections) {
+    if (SectionMatches(options, section)) {
+      printf("\nContents of section %s:\n",
+             wabt::GetSectionName(section.code));
+      out_stream->WriteMemoryDump(data + section.offset, section.size,
+                                  section.offset, PrintChars::Yes);
+    }
+  }
+  return CheckSectionFound(options, state);
+}
+
+// Resolves the names or indices given with --func to the indices of functions
+// that have a body.
+Result FindFunctions(const ObjdumpOptions* options,
+                     const ObjdumpState* state,
+                     std::set<Index>* out_indices) {
+  std::set<Index> defined;
+  for (const ObjdumpFunctionBody& body : state->function_bodies) {
+    defined.insert(body.func_index);
+  }
+
+  Result result = Result::Ok;
+  for (const std::string& function : options->functions) {
+    Index index = kInvalidIndex;
+    if (Succeeded(ParseInt32(function.data(), function.data() + function.size(),
+                             &index, ParseIntType::UnsignedOnly))) {
+      if (!defined.count(index)) {
+        index = kInvalidIndex;
+      }
+    } else {
+      for (const auto& [func_index, name] : state->function_names.names) {
+        if (name == function && defined.count(func_index)) {
+          index = func_index;
+          break;
+        }
+      }
+    }
+
+    if (index == kInvalidIndex) {
+      fprintf(stderr, "Function not found: %s\n", function.c_str());
+      result = Result::Error;
+    } else {
+      out_indices->insert(index);
+    }
+  }
+  return result;
+}
+
+// Disassembles the function bodies on |options->jobs| threads. Each thread
+// reads the module with its own reader but only decodes one contiguous run of
+// bodies, into its own buffer. The buffers are written out in order, so the
+// output is the same as that of a single reader.
+Result DisassembleInParallel(const uint8_t* data,
+                             size_t size,
+                             ObjdumpOptions* options,
+                             ObjdumpState* state,
+                             const ReadBinaryOptions& read_options,
+                             const std::set<Index>& functions) {
+  struct Job {
+    Index first_func_index;
+    Index last_func_index;
+    MemoryStream output;
+    Result result = Result::Ok;
+  };
+
+  Offset total_size = 0;
+  std::vector<const ObjdumpFunctionBody*> bodies;
+  for (const ObjdumpFunctionBody& body : state->function_bodies) {
+    if (functions.empty() || functions.count(body.func_index)) {
+      bodies.push_back(&body);
+      total_size += body.size;
+    }
+  }
+
+  // Split the bodies into runs of roughly the same size.
+  size_t num_jobs = std::min<size_t>(options->jobs, bodies.size());
+  std::vector<Job> jobs(num_jobs);
+  Offset run_size = 0;
+  size_t job_index = 0;
+  jobs[0].first_func_index = bodies[0]->func_index;
+  for (size_t i = 0; i < bodies.size(); ++i) {
+    run_size += bodies[i]->size;
+    // Including the current run.
+    size_t jobs_left = num_jobs - job_index;
+    size_t bodies_left = bodies.size() - i - 1;
+    if (jobs_left > 1 && (run_size * jobs_left >= total_size ||
+                          bodies_left == jobs_left - 1)) {
+      jobs[job_index].last_func_index = bodies[i]->func_index;
+      jobs[++job_index].first_func_index = bodies[i + 1]->func_index;
+      total_size -= run_size;
+      run_size = 0;
+    }
+  }
+  jobs.back().last_func_index = bodies.back()->func_index;
+
+  std::vector<std::thread> threads;
+  for (Job& job : jobs) {
+    threads.emplace_back([&, job = &job]() {
+      ReadBinaryOptions job_options = read_options;
+      job_options.read_function_body = [&](Index func_index) {
+        return func_index >= job->first_func_index &&
+               func_index <= job->last_func_index &&
+               (functions.empty() || functions.count(func_index));
+      };
+      BinaryReaderObjdumpDisassemble reader(data, size, options, state,
+                                            &job->output);
+      job->result = ReadBinary(data, size, &reader, job_options);
+    });
+  }
+  for (std::thread& thread : threads) {
+    thread.join();
+  }
+
+  printf("\n");
+  printf("Code Disassembly:\n\n");
+  for (Job& job : jobs) {
+    const OutputBuffer& output = job.output.output_buffer();
+    fwrite(output.data.data(), 1, output.data.size(), stdout);
+    // A single reader would have stopped here.
+    if (Failed(job.result)) {
+      return Result::Error;
+    }
+  }
+  return Result::Ok;
+}
+
+}  // end anonymous namespace
+
 Result ReadBinaryObjdump(const uint8_t* data,
                          size_t size,
                          ObjdumpOptions* options,
@@ -2503,20 +2774,54 @@ Result ReadBinaryObjdump(const uint8_t* data,
 
   switch (options->mode) {
     case ObjdumpMode::Prepass: {
+      // The prepass also records where every section and function body is, so
+      // that later passes can skip reading the parts they don't print.
       read_options.skip_function_bodies = true;
       BinaryReaderObjdumpPrepass reader(data, size, options, state);
-      return ReadBinary(data, size, &reader, read_options);
+      Result result = ReadBinary(data, size, &reader, read_options);
+      state->index_complete = Succeeded(result);
+      return result;
     }
+    case ObjdumpMode::Headers:
+      if (state->index_complete) {
+        return DumpHeaders(options, state);
+      }
+      break;
+    case ObjdumpMode::RawData:
+      if (state->index_complete) {
+        return DumpRawData(data, options, state);
+      }
+      break;
     case ObjdumpMode::Disassemble: {
+      // Names were already read by the prepass.
+      read_options.read_debug_names = false;
+      std::set<Index> functions;
+      if (!options->functions.empty()) {
+        CHECK_RESULT(FindFunctions(options, state, &functions));
+      }
+      // The bodies to disassemble in parallel are found with the index; the
+      // --debug output would be interleaved, so it is always sequential.
+      if (options->jobs > 1 && state->index_complete && !options->debug &&
+          (functions.empty() ? state->function_bodies.size()
+                             : functions.size()) > 1) {
+        return DisassembleInParallel(data, size, options, state, read_options,
+                                     functions);
+      }
+      if (!functions.empty()) {
+        read_options.read_function_body = [&](Index func_index) {
+          return functions.count(func_index) != 0;
+        };
+      }
       BinaryReaderObjdumpDisassemble reader(data, size, options, state);
       return ReadBinary(data, size, &reader, read_options);
     }
-    default: {
-      read_options.skip_function_bodies = true;
-      BinaryReaderObjdump reader(data, size, options, state);
-      return ReadBinary(data, size, &reader, read_options);
-    }
+    case ObjdumpMode::Details:
+      break;
   }
+
+  read_options.skip_function_bodies = true;
+  BinaryReaderObjdump reader(data, size, options, state);
+  return ReadBinary(data, size, &reader, read_options);
 }
 
 }  // namespace wabt
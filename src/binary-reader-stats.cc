@@ -16,6 +16,7 @@
 
 #include "wabt/binary-reader-stats.h"
 
+#include <algorithm>
 #include <cassert>
 #include <cinttypes>
 #include <cstdarg>
@@ -77,9 +78,27 @@ void OpcodeInfo::WriteArray(Stream& stream, F&& write_func) {
   }
 }
 
+size_t OpcodeInfo::Hash() const {
+  // FNV-1a.
+  uint64_t hash = 14695981039346656037ull;
+  auto add = [&](uint8_t byte) { hash = (hash ^ byte) * 1099511628211ull; };
+  uint32_t opcode = opcode_;
+  for (size_t i = 0; i < sizeof(opcode); ++i) {
+    add(opcode >> (i * 8));
+  }
+  add(static_cast<uint8_t>(kind_));
+  for (uint8_t byte : data_) {
+    add(byte);
+  }
+  return static_cast<size_t>(hash);
+}
+
 void OpcodeInfo::Write(Stream& stream) {
   stream.Writef("%s", opcode_.GetName());
+  WriteImmediates(stream);
+}
 
+void OpcodeInfo::WriteImmediates(Stream& stream) {
   switch (kind_) {
     case Kind::Bare:
       break;
@@ -193,11 +212,19 @@ bool operator>=(const OpcodeInfo& lhs, const OpcodeInfo& rhs) {
   return !(lhs < rhs);
 }
 
+OpcodeStats::OpcodeStats()
+    : counts(kOpcodeCount), bare_counts(kOpcodeCount) {}
+
 namespace {
 
 class BinaryReaderOpcnt : public BinaryReaderNop {
  public:
-  explicit BinaryReaderOpcnt(OpcodeInfoCounts* counts);
+  BinaryReaderOpcnt(const ReadOpcntOptions& options, OpcodeStats* stats);
+
+  Result BeginFunctionBody(Index index, Offset size) override;
+  Result EndFunctionBody(Index index) override;
+  Result OnFunctionName(Index function_index,
+                        std::string_view function_name) override;
 
   Result OnOpcode(Opcode opcode) override;
   Result OnOpcodeBare() override;
@@ -218,26 +245,114 @@ class BinaryReaderOpcnt : public BinaryReaderNop {
   Result OnEndExpr() override;
 
  private:
+  void Count(Opcode opcode);
+  Result CountBare(Opcode opcode);
   template <typename... Args>
   Result Emplace(Args&&... args);
 
-  OpcodeInfoCounts* opcode_counts_;
+  const ReadOpcntOptions& options_;
+  OpcodeStats* stats_;
   Opcode current_opcode_;
+
+  uint64_t weight_ = 1;
+  bool in_function_body_ = false;
+  // The opcode before the current one in this function body, for pairs.
+  Opcode::Enum last_opcode_ = Opcode::Invalid;
+  // The index of each function in |options_.functions|, for naming them.
+  std::unordered_map<Index, size_t> function_stats_index_;
+  // Counts for the current function body, and the opcodes they are non-zero
+  // for, so that they can be cleared without touching the whole array.
+  std::vector<uint64_t> function_counts_;
+  std::vector<Opcode::Enum> function_opcodes_;
 };
 
-template <typename... Args>
-Result BinaryReaderOpcnt::Emplace(Args&&... args) {
-  auto pair = opcode_counts_->emplace(
-      std::piecewise_construct, std::make_tuple(std::forward<Args>(args)...),
-      std::make_tuple(0));
+BinaryReaderOpcnt::BinaryReaderOpcnt(const ReadOpcntOptions& options,
+                                     OpcodeStats* stats)
+    : options_(options), stats_(stats) {
+  if (options_.count_pairs && stats_->pair_counts.empty()) {
+    stats_->pair_counts.resize(kOpcodeCount * kOpcodeCount);
+  }
+  if (options_.functions) {
+    function_counts_.resize(kOpcodeCount);
+  }
+}
+
+Result BinaryReaderOpcnt::BeginFunctionBody(Index index, Offset size) {
+  in_function_body_ = true;
+  last_opcode_ = Opcode::Invalid;
+  weight_ = 1;
+  if (options_.function_weights) {
+    auto iter = options_.function_weights->find(index);
+    weight_ = iter != options_.function_weights->end() ? iter->second : 0;
+  }
+  if (options_.functions) {
+    function_stats_index_[index] = options_.functions->size();
+    options_.functions->push_back({index, {}, size, weight_, {}});
+  }
+  return Result::Ok;
+}
+
+Result BinaryReaderOpcnt::EndFunctionBody(Index index) {
+  in_function_body_ = false;
+  weight_ = 1;
+  if (options_.functions) {
+    auto& counts = options_.functions->back().counts;
+    std::sort(function_opcodes_.begin(), function_opcodes_.end());
+    for (Opcode::Enum opcode : function_opcodes_) {
+      counts.emplace_back(opcode, function_counts_[opcode]);
+      function_counts_[opcode] = 0;
+    }
+    function_opcodes_.clear();
+  }
+  return Result::Ok;
+}
+
+Result BinaryReaderOpcnt::OnFunctionName(Index index, std::string_view name) {
+  if (options_.functions) {
+    auto iter = function_stats_index_.find(index);
+    if (iter != function_stats_index_.end()) {
+      (*options_.functions)[iter->second].name = name;
+    }
+  }
+  return Result::Ok;
+}
+
+void BinaryReaderOpcnt::Count(Opcode opcode) {
+  Opcode::Enum e = opcode;
+  assert(e < kOpcodeCount);
+  stats_->total += weight_;
+  stats_->counts[e] += weight_;
+  if (!in_function_body_) {
+    return;
+  }
+  if (options_.count_pairs) {
+    if (last_opcode_ != Opcode::Invalid) {
+      stats_->pair_counts[last_opcode_ * kOpcodeCount + e] += weight_;
+    }
+    last_opcode_ = e;
+  }
+  if (options_.functions) {
+    if (function_counts_[e]++ == 0) {
+      function_opcodes_.push_back(e);
+    }
+  }
+}
 
-  auto& count = pair.first->second;
-  count++;
+Result BinaryReaderOpcnt::CountBare(Opcode opcode) {
+  Count(opcode);
+  stats_->bare_counts[opcode] += weight_;
   return Result::Ok;
 }
 
-BinaryReaderOpcnt::BinaryReaderOpcnt(OpcodeInfoCounts* counts)
-    : opcode_counts_(counts) {}
+template <typename... Args>
+Result BinaryReaderOpcnt::Emplace(Args&&... args) {
+  OpcodeInfo info(std::forward<Args>(args)...);
+  Count(info.opcode());
+  if (weight_ > 0) {
+    stats_->counts_with_immediates[std::move(info)] += weight_;
+  }
+  return Result::Ok;
+}
 
 Result BinaryReaderOpcnt::OnOpcode(Opcode opcode) {
   current_opcode_ = opcode;
@@ -245,7 +360,7 @@ Result BinaryReaderOpcnt::OnOpcode(Opcode opcode) {
 }
 
 Result BinaryReaderOpcnt::OnOpcodeBare() {
-  return Emplace(current_opcode_, OpcodeInfo::Kind::Bare);
+  return CountBare(current_opcode_);
 }
 
 Result BinaryReaderOpcnt::OnOpcodeUint32(uint32_t value) {
@@ -298,7 +413,7 @@ Result BinaryReaderOpcnt::OnBrTableExpr(Index num_targets,
 }
 
 Result BinaryReaderOpcnt::OnEndExpr() {
-  return Emplace(Opcode::End, OpcodeInfo::Kind::Bare);
+  return CountBare(Opcode::End);
 }
 
 }  // end anonymous namespace
@@ -306,8 +421,9 @@ Result BinaryReaderOpcnt::OnEndExpr() {
 Result ReadBinaryOpcnt(const void* data,
                        size_t size,
                        const ReadBinaryOptions& options,
-                       OpcodeInfoCounts* counts) {
-  BinaryReaderOpcnt reader(counts);
+                       const ReadOpcntOptions& opcnt_options,
+                       OpcodeStats* stats) {
+  BinaryReaderOpcnt reader(opcnt_options, stats);
   return ReadBinary(data, size, &reader, options);
 }
 
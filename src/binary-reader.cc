@@ -2867,6 +2867,12 @@ Result BinaryReader::ReadCodeSection(Offset section_size) {
     CHECK_RESULT(ReadU32Leb128(&body_size, "function body size"));
     Offset body_start_offset = state_.offset;
     Offset end_offset = body_start_offset + body_size;
+    if (options_.read_function_body && !options_.read_function_body(func_index)) {
+      ERROR_UNLESS(end_offset <= read_end_,
+                   "function body extends past end of code section");
+      state_.offset = end_offset;
+      continue;
+    }
     CALLBACK(BeginFunctionBody, func_index, body_size);
 
     uint64_t total_locals = 0;
@@ -386,7 +386,8 @@ class BinaryWriter {
  public:
   BinaryWriter(Stream*,
                const WriteBinaryOptions& options,
-               const Module* module);
+               const Module* module,
+               FuncBodySource* func_bodies);
 
   Result WriteModule();
 
@@ -396,9 +397,12 @@ class BinaryWriter {
   Offset WriteFixupU32Leb128Size(Offset offset,
                                  Offset leb_size_guess,
                                  const char* desc);
-  void BeginKnownSection(BinarySection section_code);
+  void BeginKnownSection(BinarySection section_code,
+                         Offset leb_size_guess = LEB_SECTION_SIZE_GUESS);
   void BeginCustomSection(const char* name);
-  void WriteSectionHeader(const char* desc, BinarySection section_code);
+  void WriteSectionHeader(const char* desc,
+                          BinarySection section_code,
+                          Offset leb_size_guess = LEB_SECTION_SIZE_GUESS);
   void EndSection();
   void BeginSubsection(const char* name);
   void EndSubsection();
@@ -434,11 +438,19 @@ class BinaryWriter {
   void WriteLinkingSection();
   template <typename T>
   void WriteNames(const std::vector<T*>& elems, NameSectionSubsection type);
+  void WriteDataCountSection();
+  Result WriteCodeSection();
+  Result EncodeFuncBodies(MemoryStream* code_stream,
+                          std::vector<Offset>* body_ends);
+  void WriteEncodedCodeSection(const OutputBuffer& code,
+                               const std::vector<Offset>& body_ends);
   void WriteCodeMetadataSections();
+  void InsertCodeMetadataSections();
 
   Stream* stream_;
   const WriteBinaryOptions& options_;
   const Module* module_;
+  FuncBodySource* func_bodies_;
 
   SymbolTable symtab_;
   std::vector<RelocSection> reloc_sections_;
@@ -477,8 +489,12 @@ static uint8_t log2_u32(uint32_t x) {
 
 BinaryWriter::BinaryWriter(Stream* stream,
                            const WriteBinaryOptions& options,
-                           const Module* module)
-    : stream_(stream), options_(options), module_(module) {}
+                           const Module* module,
+                           FuncBodySource* func_bodies)
+    : stream_(stream),
+      options_(options),
+      module_(module),
+      func_bodies_(func_bodies) {}
 
 void BinaryWriter::WriteHeader(const char* name, int index) {
   if (stream_->has_log_stream()) {
@@ -542,23 +558,25 @@ void BinaryWriter::WriteBlockDecl(const BlockDeclaration& decl) {
 }
 
 void BinaryWriter::WriteSectionHeader(const char* desc,
-                                      BinarySection section_code) {
+                                      BinarySection section_code,
+                                      Offset leb_size_guess) {
   assert(last_section_leb_size_guess_ == 0);
   WriteHeader(desc, PRINT_HEADER_NO_INDEX);
   stream_->WriteU8Enum(section_code, "section code");
   last_section_type_ = section_code;
-  last_section_leb_size_guess_ = LEB_SECTION_SIZE_GUESS;
+  last_section_leb_size_guess_ = leb_size_guess;
   last_section_offset_ =
-      WriteU32Leb128Space(LEB_SECTION_SIZE_GUESS, "section size (guess)");
+      WriteU32Leb128Space(leb_size_guess, "section size (guess)");
   last_section_payload_offset_ = stream_->offset();
 }
 
-void BinaryWriter::BeginKnownSection(BinarySection section_code) {
+void BinaryWriter::BeginKnownSection(BinarySection section_code,
+                                     Offset leb_size_guess) {
   char desc[100];
   wabt_snprintf(desc, sizeof(desc), "section \"%s\" (%u)",
                 GetSectionName(section_code),
                 static_cast<unsigned>(section_code));
-  WriteSectionHeader(desc, section_code);
+  WriteSectionHeader(desc, section_code, leb_size_guess);
 }
 
 void BinaryWriter::BeginCustomSection(const char* name) {
@@ -1615,78 +1633,66 @@ Result BinaryWriter::WriteModule() {
     EndSection();
   }
 
-  if (options_.features.bulk_memory_enabled() &&
-      module_->data_segments.size()) {
-    // Keep track of the data count section offset so it can be removed if
-    // it isn't needed.
-    data_count_start_ = stream_->offset();
-    BeginKnownSection(BinarySection::DataCount);
-    WriteU32Leb128(stream_, module_->data_segments.size(), "data count");
-    EndSection();
-    data_count_end_ = stream_->offset();
-  }
+  if (num_funcs && !stream_->has_log_stream()) {
+    // Encode the function bodies first, so the size of the code section and
+    // of each body is known before it is written. The DataCount and code
+    // metadata sections that precede it can then be written directly too,
+    // rather than removed or moved into place afterward. This isn't done when
+    // logging, since the log should show every byte at its final offset.
+    MemoryStream code_stream;
+    std::vector<Offset> body_ends;
+    CHECK_RESULT(EncodeFuncBodies(&code_stream, &body_ends));
+    if (options_.features.bulk_memory_enabled() &&
+        module_->data_segments.size() && has_data_segment_instruction_) {
+      WriteDataCountSection();
+    }
+    WriteCodeMetadataSections();
+    WriteEncodedCodeSection(code_stream.output_buffer(), body_ends);
+  } else {
+    if (options_.features.bulk_memory_enabled() &&
+        module_->data_segments.size()) {
+      // Keep track of the data count section offset so it can be removed if
+      // it isn't needed.
+      data_count_start_ = stream_->offset();
+      WriteDataCountSection();
+      data_count_end_ = stream_->offset();
+    }
+
+    if (num_funcs) {
+      CHECK_RESULT(WriteCodeSection());
+    }
+
+    // Remove the DataCount section if there are no instructions that require
+    // it.
+    if (options_.features.bulk_memory_enabled() &&
+        module_->data_segments.size() && !has_data_segment_instruction_) {
+      Offset size = stream_->offset() - data_count_end_;
+      if (size) {
+        // If the DataCount section was followed by anything, assert that it's
+        // only the Code section.  This limits the amount of fixing-up that we
+        // need to do.
+        assert(data_count_end_ == code_start_);
+        assert(last_section_type_ == BinarySection::Code);
+        stream_->MoveData(data_count_start_, data_count_end_, size);
+        code_start_ = data_count_start_;
+      }
+      stream_->Truncate(data_count_start_ + size);
 
-  if (num_funcs) {
-    code_start_ = stream_->offset();
-    BeginKnownSection(BinarySection::Code);
-    WriteU32Leb128(stream_, num_funcs, "num functions");
+      --section_count_;
 
-    for (size_t i = 0; i < num_funcs; ++i) {
-      cur_func_index_ = i + module_->num_func_imports;
-      WriteHeader("function body", i);
-      const Func* func = module_->funcs[cur_func_index_];
-
-      /* TODO(binji): better guess of the size of the function body section */
-      const Offset leb_size_guess = 1;
-      Offset body_size_offset =
-          WriteU32Leb128Space(leb_size_guess, "func body size (guess)");
-      cur_func_start_offset_ = stream_->offset();
-      WriteFunc(func);
-      auto func_start_offset = body_size_offset - last_section_payload_offset_;
-      auto func_end_offset = stream_->offset() - last_section_payload_offset_;
-      auto delta = WriteFixupU32Leb128Size(body_size_offset, leb_size_guess,
-                                           "FIXUP func body size");
-      if (current_reloc_section_ && delta != 0) {
-        for (Reloc& reloc : current_reloc_section_->relocations) {
-          if (reloc.offset >= func_start_offset &&
-              reloc.offset <= func_end_offset) {
-            reloc.offset += delta;
-          }
+      // We just effectively decremented the code section's index; adjust
+      // anything that might have captured it.
+      for (RelocSection& section : reloc_sections_) {
+        if (section.section_index == section_count_) {
+          assert(last_section_type_ == BinarySection::Code);
+          --section.section_index;
         }
       }
     }
-    EndSection();
-  }
-
-  // Remove the DataCount section if there are no instructions that require it.
-  if (options_.features.bulk_memory_enabled() &&
-      module_->data_segments.size() && !has_data_segment_instruction_) {
-    Offset size = stream_->offset() - data_count_end_;
-    if (size) {
-      // If the DataCount section was followed by anything, assert that it's
-      // only the Code section.  This limits the amount of fixing-up that we
-      // need to do.
-      assert(data_count_end_ == code_start_);
-      assert(last_section_type_ == BinarySection::Code);
-      stream_->MoveData(data_count_start_, data_count_end_, size);
-      code_start_ = data_count_start_;
-    }
-    stream_->Truncate(data_count_start_ + size);
 
-    --section_count_;
-
-    // We just effectively decremented the code section's index; adjust anything
-    // that might have captured it.
-    for (RelocSection& section : reloc_sections_) {
-      if (section.section_index == section_count_) {
-        assert(last_section_type_ == BinarySection::Code);
-        --section.section_index;
-      }
-    }
+    InsertCodeMetadataSections();
   }
 
-  WriteCodeMetadataSections();
-
   if (module_->data_segments.size()) {
     BeginKnownSection(BinarySection::Data);
     WriteU32Leb128(stream_, module_->data_segments.size(), "num data segments");
@@ -1798,23 +1804,140 @@ Result BinaryWriter::WriteModule() {
   return stream_->result();
 }
 
-void BinaryWriter::WriteCodeMetadataSections() {
-  if (code_metadata_sections_.empty())
-    return;
+void BinaryWriter::WriteDataCountSection() {
+  BeginKnownSection(BinarySection::DataCount);
+  WriteU32Leb128(stream_, module_->data_segments.size(), "data count");
+  EndSection();
+}
 
-  section_count_ -= 1;
-  // We have to increment the code section's index; adjust anything
-  // that might have captured it.
-  for (RelocSection& section : reloc_sections_) {
-    if (section.section_index == section_count_) {
-      assert(last_section_type_ == BinarySection::Code);
-      section.section_index += code_metadata_sections_.size();
+Result BinaryWriter::WriteCodeSection() {
+  Index num_funcs = module_->funcs.size() - module_->num_func_imports;
+  code_start_ = stream_->offset();
+  BeginKnownSection(BinarySection::Code);
+  WriteU32Leb128(stream_, num_funcs, "num functions");
+
+  for (size_t i = 0; i < num_funcs; ++i) {
+    cur_func_index_ = i + module_->num_func_imports;
+    WriteHeader("function body", i);
+    const Func* func = module_->funcs[cur_func_index_];
+    if (func_bodies_) {
+      CHECK_RESULT(func_bodies_->BeginFuncBody(cur_func_index_));
+    }
+
+    /* TODO(binji): better guess of the size of the function body section */
+    const Offset leb_size_guess = 1;
+    Offset body_size_offset =
+        WriteU32Leb128Space(leb_size_guess, "func body size (guess)");
+    cur_func_start_offset_ = stream_->offset();
+    WriteFunc(func);
+    auto func_start_offset = body_size_offset - last_section_payload_offset_;
+    auto func_end_offset = stream_->offset() - last_section_payload_offset_;
+    auto delta = WriteFixupU32Leb128Size(body_size_offset, leb_size_guess,
+                                         "FIXUP func body size");
+    if (func_bodies_) {
+      func_bodies_->EndFuncBody(cur_func_index_);
+    }
+    if (current_reloc_section_ && delta != 0) {
+      for (Reloc& reloc : current_reloc_section_->relocations) {
+        if (reloc.offset >= func_start_offset &&
+            reloc.offset <= func_end_offset) {
+          reloc.offset += delta;
+        }
+      }
     }
   }
+  EndSection();
+  return Result::Ok;
+}
 
-  MemoryStream tmp_stream;
+Result BinaryWriter::EncodeFuncBodies(MemoryStream* code_stream,
+                                      std::vector<Offset>* body_ends) {
+  Index num_funcs = module_->funcs.size() - module_->num_func_imports;
+
+  // Until the code section's index and payload offset are known, relocations
+  // go in a reloc section of their own, relative to the start of
+  // `code_stream`. WriteEncodedCodeSection fixes them up.
   Stream* main_stream = stream_;
-  stream_ = &tmp_stream;
+  Index section_count = section_count_;
+  stream_ = code_stream;
+  section_count_ = kInvalidIndex;
+  last_section_type_ = BinarySection::Code;
+  last_section_payload_offset_ = 0;
+
+  for (size_t i = 0; i < num_funcs; ++i) {
+    cur_func_index_ = i + module_->num_func_imports;
+    const Func* func = module_->funcs[cur_func_index_];
+    if (func_bodies_) {
+      CHECK_RESULT(func_bodies_->BeginFuncBody(cur_func_index_));
+    }
+    cur_func_start_offset_ = stream_->offset();
+    WriteFunc(func);
+    body_ends->push_back(stream_->offset());
+    if (func_bodies_) {
+      func_bodies_->EndFuncBody(cur_func_index_);
+    }
+  }
+
+  stream_ = main_stream;
+  section_count_ = section_count;
+  return code_stream->result();
+}
+
+void BinaryWriter::WriteEncodedCodeSection(
+    const OutputBuffer& code,
+    const std::vector<Offset>& body_ends) {
+  auto body_size_leb_length = [this](Offset size) {
+    return options_.canonicalize_lebs ? U32Leb128Length(size)
+                                      : MAX_U32_LEB128_BYTES;
+  };
+
+  Offset section_size = U32Leb128Length(body_ends.size());
+  Offset body_start = 0;
+  for (Offset body_end : body_ends) {
+    Offset body_size = body_end - body_start;
+    section_size += body_size_leb_length(body_size) + body_size;
+    body_start = body_end;
+  }
+
+  code_start_ = stream_->offset();
+  BeginKnownSection(BinarySection::Code, U32Leb128Length(section_size));
+  WriteU32Leb128(stream_, body_ends.size(), "num functions");
+
+  RelocSection* code_relocs = nullptr;
+  for (RelocSection& section : reloc_sections_) {
+    if (section.section_index == kInvalidIndex) {
+      section.section_index = section_count_;
+      code_relocs = &section;
+    }
+  }
+
+  size_t reloc_index = 0;
+  body_start = 0;
+  for (Offset body_end : body_ends) {
+    Offset body_size = body_end - body_start;
+    if (options_.canonicalize_lebs) {
+      WriteU32Leb128(stream_, body_size, "func body size");
+    } else {
+      WriteFixedU32Leb128(stream_, body_size, "func body size");
+    }
+    Offset delta =
+        stream_->offset() - last_section_payload_offset_ - body_start;
+    if (code_relocs) {
+      auto& relocs = code_relocs->relocations;
+      for (; reloc_index < relocs.size() &&
+             relocs[reloc_index].offset < body_end;
+           ++reloc_index) {
+        relocs[reloc_index].offset += delta;
+      }
+    }
+    stream_->WriteData(code.data.data() + body_start, body_size,
+                       "function body");
+    body_start = body_end;
+  }
+  EndSection();
+}
+
+void BinaryWriter::WriteCodeMetadataSections() {
   for (auto& s : code_metadata_sections_) {
     std::string name = "metadata.code.";
     name.append(s.first);
@@ -1834,6 +1957,26 @@ void BinaryWriter::WriteCodeMetadataSections() {
     }
     EndSection();
   }
+}
+
+void BinaryWriter::InsertCodeMetadataSections() {
+  if (code_metadata_sections_.empty())
+    return;
+
+  section_count_ -= 1;
+  // We have to increment the code section's index; adjust anything
+  // that might have captured it.
+  for (RelocSection& section : reloc_sections_) {
+    if (section.section_index == section_count_) {
+      assert(last_section_type_ == BinarySection::Code);
+      section.section_index += code_metadata_sections_.size();
+    }
+  }
+
+  MemoryStream tmp_stream;
+  Stream* main_stream = stream_;
+  stream_ = &tmp_stream;
+  WriteCodeMetadataSections();
   stream_ = main_stream;
   auto buf = tmp_stream.ReleaseOutputBuffer();
   stream_->MoveData(code_start_ + buf->data.size(), code_start_,
@@ -1849,8 +1992,9 @@ void BinaryWriter::WriteCodeMetadataSections() {
 
 Result WriteBinaryModule(Stream* stream,
                          const Module* module,
-                         const WriteBinaryOptions& options) {
-  BinaryWriter binary_writer(stream, options, module);
+                         const WriteBinaryOptions& options,
+                         FuncBodySource* func_bodies) {
+  BinaryWriter binary_writer(stream, options, module, func_bodies);
   return binary_writer.WriteModule();
 }
 
@@ -16,6 +16,7 @@
 
 #include "wabt/c-writer.h"
 
+#include <algorithm>
 #include <cctype>
 #include <cinttypes>
 #include <iterator>
@@ -183,9 +184,10 @@ int GetShiftMask(Type type) {
 /*
  * This function is the default behavior for name_to_output_file_index_. For
  * single .c output, this function returns a vector filled with 0. For multiple
- * .c outputs, this function sorts all non-imported functions in the module by
- * their names, and then divides all non-imported functions into equal-sized
- * buckets (# of non-imported functions / # of .c outputs) based on the sorting.
+ * .c outputs, each non-imported function goes into the output chosen by a
+ * hash of its name, so that adding, removing or reordering other functions
+ * doesn't move it, and the outputs whose functions haven't changed are
+ * written the same.
  */
 static std::vector<size_t> default_name_to_output_file_index(
     std::vector<Func*>::const_iterator func_begin,
@@ -198,22 +200,18 @@ static std::vector<size_t> default_name_to_output_file_index(
     return result;
   }
 
-  std::map<std::string, Index> sorted_functions;
-  size_t non_imported_funcs = result.size() - num_imports;
-  size_t bucket_size = non_imported_funcs / num_streams +
-                       (non_imported_funcs % num_streams ? 1 : 0);
   Index func_index = 0;
   for (auto func = func_begin; func != func_end; func++) {
-    sorted_functions.insert({(*func)->name, func_index});
-    ++func_index;
-  }
-  Index sorted_func_index = 0;
-  for (const auto& [func_name, index] : sorted_functions) {
-    bool is_import = index < num_imports;
+    bool is_import = func_index < num_imports;
     if (!is_import) {
-      result.at(index) = sorted_func_index / bucket_size;
-      ++sorted_func_index;
+      // FNV-1a, which unlike std::hash is the same on every platform.
+      uint64_t hash = 0xcbf29ce484222325;
+      for (char c : (*func)->name) {
+        hash = (hash ^ static_cast<uint8_t>(c)) * 0x100000001b3;
+      }
+      result.at(func_index) = hash % num_streams;
     }
+    ++func_index;
   }
   return result;
 }
@@ -257,6 +255,12 @@ class CWriter {
   void PushType(Type);
   void PushTypes(const TypeVector&);
   void DropTypes(size_t count);
+  void ForgetStackValues(size_t mark);
+  void ForgetLocalsAssignedIn(const ExprList&);
+  bool IsAccessInBounds(Index memory_index,
+                        Index address,
+                        const Opcode&,
+                        Address offset);
 
   void PushLabel(LabelType,
                  const std::string& name,
@@ -413,6 +417,7 @@ class CWriter {
   void WriteFuncRefWrappers();
   void WriteElemTableInit(bool, const ElemSegment*, const Table*);
   bool IsSingleUnsharedMemory();
+  bool CanUseMemoryImage(Index memory_index) const;
   void InstallSegueBase(Memory* memory, bool save_old_value);
   void RestoreSegueBase();
   void WriteExports(CWriterPhase);
@@ -438,6 +443,7 @@ class CWriter {
   void WriteLocals(const std::vector<std::string>& index_to_name);
   void WriteStackVarDeclarations();
   void Write(const ExprList&);
+  void WriteExprs(const ExprList&);
   void WriteTailCallAsserts(const FuncSignature&);
   void WriteTailCallStack();
   void WriteUnwindTryCatchStack(const Label*);
@@ -482,15 +488,27 @@ class CWriter {
   void Write(const AtomicLoadExpr& expr);
   void Write(const AtomicStoreExpr& expr);
   void Write(const AtomicRmwExpr& expr);
+  void Write(const AtomicWaitExpr& expr);
+  void Write(const AtomicNotifyExpr& expr);
   void Write(const AtomicRmwCmpxchgExpr& expr);
 
   size_t BeginTry(const Block& block);
+  size_t BeginCheckedTry(const Block& block);
   void WriteTryCatch(const TryExpr& tryexpr);
   void WriteTryDelegate(const TryExpr& tryexpr);
   void Write(const TryTableExpr& try_table_expr);
   void Write(const Catch& c);
   void Write(const TableCatch& c);
   void WriteThrow();
+  void ComputeStaticTables();
+  void ComputeRecursiveFuncs();
+  bool WriteDevirtualizedCall(const CallIndirectExpr&);
+  void WriteDelegateToCaller();
+  void WritePropagateException();
+  void WriteCheckPendingException();
+  void WriteRethrowPendingException();
+  void WriteUnwindLabel();
+  bool CheckedExceptions() const;
 
   void PushTryCatch(const std::string& name);
   void PopTryCatch();
@@ -543,6 +561,31 @@ class CWriter {
   bool simd_used_in_header_;
 
   bool in_tail_callee_;
+  bool unwind_label_used_;
+
+  // The functions a call_indirect through a table with fixed contents can
+  // reach, with the slots that hold each of them, in slot order.
+  using DevirtualizedTargets =
+      std::vector<std::pair<const Func*, std::vector<Index>>>;
+  using SignatureKey = std::pair<TypeVector, TypeVector>;
+  // The targets of each signature in each funcref table that never changes
+  // after instantiation. Signatures with too many targets to devirtualize
+  // have an empty list.
+  std::map<const Table*, std::map<SignatureKey, DevirtualizedTargets>>
+      static_tables_;
+  // Functions on a cycle of the call graph, which check for stack exhaustion.
+  std::set<const Func*> recursive_funcs_;
+
+  // A local's value after its Nth assignment in the function being written.
+  using LocalValue = std::pair<Index, Index>;
+  std::vector<Index> local_versions_;
+  // Values known to be held by stack vars, by their position in type_stack_.
+  std::map<size_t, LocalValue> stack_locals_;
+  std::map<size_t, uint64_t> stack_consts_;
+  // The end (offset + size) of the largest access past a local value that has
+  // passed its bounds check, in the code being written.
+  std::map<std::pair<LocalValue, const Memory*>, uint64_t> checked_ranges_;
+  BoundsCheckStats bounds_check_stats_;
 };
 
 // TODO: if WABT begins supporting debug names for labels,
@@ -550,6 +593,10 @@ class CWriter {
 // the implicit func label
 static constexpr char kImplicitFuncLabel[] = "$Bfunc";
 
+// Target of an exception a function doesn't catch, with checked exception
+// lowering. Generated labels all start with "var_", so this can't collide.
+static constexpr char kUnwindLabel[] = "unwind";
+
 // These should be greater than any ModuleFieldType (used for MangleField).
 static constexpr char kParamSuffix =
     'a' + static_cast<char>(ModuleFieldType::Tag) + 1;
@@ -562,6 +609,11 @@ static constexpr char kAdminSymbolPrefix[] = "wasm2c_";
 static constexpr char kTailCallSymbolPrefix[] = "wasm_tailcall_";
 static constexpr char kTailCallFallbackPrefix[] = "wasm_fallback_";
 static constexpr unsigned int kTailCallStackSize = 1024;
+// A call_indirect through a table with fixed contents is written as a switch
+// over the possible callees, if there are at most this many of them in at
+// most this many slots.
+static constexpr size_t kMaxDevirtualizedTargets = 16;
+static constexpr size_t kMaxDevirtualizedSlots = 256;
 
 size_t CWriter::MarkTypeStack() const {
   return type_stack_.size();
@@ -570,6 +622,7 @@ size_t CWriter::MarkTypeStack() const {
 void CWriter::ResetTypeStack(size_t mark) {
   assert(mark <= type_stack_.size());
   type_stack_.erase(type_stack_.begin() + mark, type_stack_.end());
+  ForgetStackValues(mark);
 }
 
 Type CWriter::StackType(Index index) const {
@@ -578,16 +631,70 @@ Type CWriter::StackType(Index index) const {
 }
 
 void CWriter::PushType(Type type) {
+  ForgetStackValues(type_stack_.size());
   type_stack_.push_back(type);
 }
 
 void CWriter::PushTypes(const TypeVector& types) {
+  ForgetStackValues(type_stack_.size());
   type_stack_.insert(type_stack_.end(), types.begin(), types.end());
 }
 
 void CWriter::DropTypes(size_t count) {
   assert(count <= type_stack_.size());
   type_stack_.erase(type_stack_.end() - count, type_stack_.end());
+  ForgetStackValues(type_stack_.size());
+}
+
+void CWriter::ForgetStackValues(size_t mark) {
+  stack_locals_.erase(stack_locals_.lower_bound(mark), stack_locals_.end());
+  stack_consts_.erase(stack_consts_.lower_bound(mark), stack_consts_.end());
+}
+
+bool CWriter::IsAccessInBounds(Index memory_index,
+                               Index address,
+                               const Opcode& opcode,
+                               Address offset) {
+  /*
+   * Memories never shrink, so once an access has passed its bounds check,
+   * any access to the same address that ends no further is in bounds too.
+   * Accesses at constant addresses are in bounds if they end within the
+   * initial size of a memory this module defines; nothing checks that an
+   * imported memory is as large as its import declares.
+   */
+  bounds_check_stats_.accesses++;
+  const Memory* memory = module_->memories[memory_index];
+  size_t position = type_stack_.size() - address - 1;
+  uint64_t size = opcode.GetMemorySize();
+  if (offset > std::numeric_limits<uint64_t>::max() - size) {
+    return false;
+  }
+  uint64_t end = offset + size;
+
+  auto const_iter = stack_consts_.find(position);
+  if (const_iter != stack_consts_.end()) {
+    uint64_t initial_pages = memory->page_limits.initial;
+    bool in_bounds =
+        memory_index >= module_->num_memory_imports &&
+        const_iter->second <= std::numeric_limits<uint64_t>::max() - end &&
+        initial_pages <=
+            std::numeric_limits<uint64_t>::max() / memory->page_size &&
+        const_iter->second + end <= initial_pages * memory->page_size;
+    bounds_check_stats_.unchecked += in_bounds;
+    return in_bounds;
+  }
+
+  auto local_iter = stack_locals_.find(position);
+  if (local_iter == stack_locals_.end()) {
+    return false;
+  }
+  uint64_t& checked_end = checked_ranges_[{local_iter->second, memory}];
+  if (end <= checked_end) {
+    bounds_check_stats_.unchecked++;
+    return true;
+  }
+  checked_end = end;
+  return false;
 }
 
 void CWriter::PushLabel(LabelType label_type,
@@ -1181,6 +1288,7 @@ void CWriter::Write(const GotoLabel& goto_label) {
         Write(StackVar(amount - i - 1 + offset, label->sig[i]), " = ",
               StackVar(amount - i - 1), "; ");
       }
+      ForgetStackValues(label->type_stack_size);
     }
   }
 
@@ -1311,6 +1419,10 @@ void CWriter::Write(const Const& const_) {
       } else if (f32_bits == 0x80000000) {
         // Negative zero. Special-cased so it isn't written as -0 below.
         Writef("-0.f");
+      } else if (options_.shortest_floats) {
+        char buf[WABT_MAX_FLOAT_DECIMAL];
+        WriteFloatDecimal(buf, sizeof(buf), f32_bits);
+        Write(buf, "f");
       } else {
         Writef("%.9g", Bitcast<float>(f32_bits));
       }
@@ -1335,6 +1447,11 @@ void CWriter::Write(const Const& const_) {
       } else if (f64_bits == 0x8000000000000000ull) {
         // Negative zero. Special-cased so it isn't written as -0 below.
         Writef("-0.0");
+      } else if (options_.shortest_floats) {
+        // Always contains a decimal point or an exponent.
+        char buf[WABT_MAX_DOUBLE_DECIMAL];
+        WriteDoubleDecimal(buf, sizeof(buf), f64_bits);
+        Write(buf);
       } else {
         char buf[128];
         snprintf(buf, sizeof(buf), "%.17g", Bitcast<double>(f64_bits));
@@ -1931,7 +2048,7 @@ void CWriter::WriteTailCallWeakImports() {
     Index num_results = func.GetNumResults();
     if (num_params >= 1) {
       Write(func.decl.sig.param_types, " params;", Newline());
-      Write("wasm_rt_memcpy(params, tail_call_stack, sizeof(params));",
+      Write("wasm_rt_memcpy(&params, tail_call_stack, sizeof(params));",
             Newline());
     }
 
@@ -2016,6 +2133,333 @@ void CWriter::WriteCallIndirectFuncDeclaration(const FuncDeclaration& decl,
   Write(")");
 }
 
+template <typename F>
+static void ForEachExpr(const ExprList& exprs, const F& func) {
+  for (const Expr& expr : exprs) {
+    func(expr);
+    switch (expr.type()) {
+      case ExprType::Block:
+        ForEachExpr(cast<BlockExpr>(&expr)->block.exprs, func);
+        break;
+      case ExprType::Loop:
+        ForEachExpr(cast<LoopExpr>(&expr)->block.exprs, func);
+        break;
+      case ExprType::If:
+        ForEachExpr(cast<IfExpr>(&expr)->true_.exprs, func);
+        ForEachExpr(cast<IfExpr>(&expr)->false_, func);
+        break;
+      case ExprType::Try:
+        ForEachExpr(cast<TryExpr>(&expr)->block.exprs, func);
+        for (const Catch& c : cast<TryExpr>(&expr)->catches) {
+          ForEachExpr(c.exprs, func);
+        }
+        break;
+      case ExprType::TryTable:
+        ForEachExpr(cast<TryTableExpr>(&expr)->block.exprs, func);
+        break;
+      default:
+        break;
+    }
+  }
+}
+
+void CWriter::ForgetLocalsAssignedIn(const ExprList& exprs) {
+  ForEachExpr(exprs, [&](const Expr& expr) {
+    if (expr.type() == ExprType::LocalSet) {
+      local_versions_[func_->GetLocalIndex(cast<LocalSetExpr>(&expr)->var)]++;
+    } else if (expr.type() == ExprType::LocalTee) {
+      local_versions_[func_->GetLocalIndex(cast<LocalTeeExpr>(&expr)->var)]++;
+    }
+  });
+}
+
+void CWriter::ComputeStaticTables() {
+  /*
+   * A funcref table has the same contents for the life of the instance if it
+   * is defined here and not exported, no instruction writes to it, and only
+   * active segments with constant offsets and function elements fill it.
+   */
+  std::set<const Table*> candidates;
+  for (Index i = module_->num_table_imports; i < module_->tables.size(); ++i) {
+    if (module_->tables[i]->elem_type == Type::FuncRef) {
+      candidates.insert(module_->tables[i]);
+    }
+  }
+  for (const Export* export_ : module_->exports) {
+    if (export_->kind == ExternalKind::Table) {
+      candidates.erase(module_->GetTable(export_->var));
+    }
+  }
+  for (const Func* func : module_->funcs) {
+    ForEachExpr(func->exprs, [&](const Expr& expr) {
+      switch (expr.type()) {
+        case ExprType::TableSet:
+          candidates.erase(module_->GetTable(cast<TableSetExpr>(&expr)->var));
+          break;
+        case ExprType::TableGrow:
+          candidates.erase(module_->GetTable(cast<TableGrowExpr>(&expr)->var));
+          break;
+        case ExprType::TableFill:
+          candidates.erase(module_->GetTable(cast<TableFillExpr>(&expr)->var));
+          break;
+        case ExprType::TableCopy:
+          candidates.erase(
+              module_->GetTable(cast<TableCopyExpr>(&expr)->dst_table));
+          break;
+        case ExprType::TableInit:
+          candidates.erase(
+              module_->GetTable(cast<TableInitExpr>(&expr)->table_index));
+          break;
+        default:
+          break;
+      }
+    });
+  }
+
+  /*
+   * Only the slots that segments fill are kept, since the declared size of a
+   * table can be far larger than its contents.
+   */
+  std::map<const Table*, std::map<Index, const Func*>> contents;
+  for (const Table* table : candidates) {
+    contents[table];
+  }
+  for (const ElemSegment* segment : module_->elem_segments) {
+    if (segment->kind != SegmentKind::Active) {
+      continue;
+    }
+    const Table* table = module_->GetTable(segment->table_var);
+    auto iter = contents.find(table);
+    if (iter == contents.end()) {
+      continue;
+    }
+    std::map<Index, const Func*>& elems = iter->second;
+    const ExprList& offset = segment->offset;
+    if (offset.size() != 1 || offset.front().type() != ExprType::Const ||
+        cast<ConstExpr>(&offset.front())->const_.type() != Type::I32) {
+      contents.erase(iter);
+      continue;
+    }
+    uint64_t slot = cast<ConstExpr>(&offset.front())->const_.u32();
+    if (slot + segment->elem_exprs.size() > table->elem_limits.initial) {
+      // Instantiation traps, so no call can ever go through the table.
+      contents.erase(iter);
+      continue;
+    }
+    for (const ExprList& elem_expr : segment->elem_exprs) {
+      const Expr* expr = elem_expr.size() == 1 ? &elem_expr.front() : nullptr;
+      if (expr && expr->type() == ExprType::RefFunc) {
+        elems[slot++] = module_->GetFunc(cast<RefFuncExpr>(expr)->var);
+      } else if (expr && expr->type() == ExprType::RefNull) {
+        elems.erase(slot++);
+      } else {
+        contents.erase(iter);
+        break;
+      }
+    }
+  }
+
+  /*
+   * Group the slots of each table by signature and then by function, once,
+   * so that each call site only has to look up its signature.
+   */
+  static_tables_.clear();
+  for (const auto& [table, elems] : contents) {
+    std::map<SignatureKey, DevirtualizedTargets>& signatures =
+        static_tables_[table];
+    std::map<SignatureKey, size_t> num_slots;
+    std::map<const Func*, size_t> target_index;
+    for (const auto& [slot, func] : elems) {
+      SignatureKey key(func->decl.sig.param_types,
+                       func->decl.sig.result_types);
+      DevirtualizedTargets& targets = signatures[key];
+      if (++num_slots[key] > kMaxDevirtualizedSlots) {
+        continue;
+      }
+      auto [target, inserted] = target_index.emplace(func, targets.size());
+      if (inserted) {
+        targets.emplace_back(func, std::vector<Index>());
+      }
+      targets[target->second].second.push_back(slot);
+    }
+    for (const auto& [key, count] : num_slots) {
+      if (count > kMaxDevirtualizedSlots ||
+          signatures[key].size() > kMaxDevirtualizedTargets) {
+        signatures[key].clear();
+      }
+    }
+  }
+}
+
+void CWriter::ComputeRecursiveFuncs() {
+  /*
+   * Only functions on a cycle of the call graph can exhaust the stack, since
+   * every other call chain is bounded by the size of the module. Indirect
+   * calls and imports may reach any function whose reference escapes, so they
+   * call an extra node standing for everything outside the direct calls.
+   */
+  const Index num_funcs = module_->funcs.size();
+  const Index outside = num_funcs;
+  std::vector<std::vector<Index>> callees(num_funcs + 1);
+  auto escape = [&](const Var& var) {
+    callees[outside].push_back(module_->GetFuncIndex(var));
+  };
+  auto escape_exprs = [&](const ExprList& exprs) {
+    for (const Expr& expr : exprs) {
+      if (expr.type() == ExprType::RefFunc) {
+        escape(cast<RefFuncExpr>(&expr)->var);
+      }
+    }
+  };
+
+  for (Index i = 0; i < num_funcs; ++i) {
+    if (i < module_->num_func_imports) {
+      callees[i].push_back(outside);
+      continue;
+    }
+    ForEachExpr(module_->funcs[i]->exprs, [&](const Expr& expr) {
+      switch (expr.type()) {
+        case ExprType::Call:
+          callees[i].push_back(
+              module_->GetFuncIndex(cast<CallExpr>(&expr)->var));
+          break;
+        case ExprType::ReturnCall:
+          callees[i].push_back(
+              module_->GetFuncIndex(cast<ReturnCallExpr>(&expr)->var));
+          break;
+        case ExprType::CallIndirect:
+        case ExprType::ReturnCallIndirect:
+        case ExprType::CallRef:
+          callees[i].push_back(outside);
+          break;
+        case ExprType::RefFunc:
+          escape(cast<RefFuncExpr>(&expr)->var);
+          break;
+        default:
+          break;
+      }
+    });
+  }
+  for (const Export* export_ : module_->exports) {
+    if (export_->kind == ExternalKind::Func) {
+      escape(export_->var);
+    }
+  }
+  for (const ElemSegment* segment : module_->elem_segments) {
+    for (const ExprList& elem_expr : segment->elem_exprs) {
+      escape_exprs(elem_expr);
+    }
+  }
+  for (const Global* global : module_->globals) {
+    escape_exprs(global->init_expr);
+  }
+
+  // Find the strongly connected components with Tarjan's algorithm, using an
+  // explicit stack so deep call chains can't overflow ours.
+  const Index num_nodes = num_funcs + 1;
+  std::vector<Index> order(num_nodes, kInvalidIndex);
+  std::vector<Index> low(num_nodes);
+  std::vector<bool> on_stack(num_nodes);
+  std::vector<Index> component;
+  std::vector<std::pair<Index, size_t>> work;
+  Index next_order = 0;
+  auto visit = [&](Index node) {
+    order[node] = low[node] = next_order++;
+    component.push_back(node);
+    on_stack[node] = true;
+    work.emplace_back(node, 0);
+  };
+
+  recursive_funcs_.clear();
+  for (Index root = 0; root < num_nodes; ++root) {
+    if (order[root] != kInvalidIndex) {
+      continue;
+    }
+    visit(root);
+    while (!work.empty()) {
+      auto [node, edge] = work.back();
+      if (edge < callees[node].size()) {
+        work.back().second++;
+        Index callee = callees[node][edge];
+        if (order[callee] == kInvalidIndex) {
+          visit(callee);
+        } else if (on_stack[callee]) {
+          low[node] = std::min(low[node], order[callee]);
+        }
+        continue;
+      }
+
+      work.pop_back();
+      if (!work.empty()) {
+        Index caller = work.back().first;
+        low[caller] = std::min(low[caller], low[node]);
+      }
+      if (low[node] != order[node]) {
+        continue;
+      }
+      auto begin = std::find(component.begin(), component.end(), node);
+      bool is_cycle = component.end() - begin > 1 ||
+                      std::count(callees[node].begin(), callees[node].end(),
+                                 node) != 0;
+      for (auto iter = begin; iter != component.end(); ++iter) {
+        on_stack[*iter] = false;
+        if (is_cycle && *iter != outside) {
+          recursive_funcs_.insert(module_->funcs[*iter]);
+        }
+      }
+      component.erase(begin, component.end());
+    }
+  }
+}
+
+bool CWriter::WriteDevirtualizedCall(const CallIndirectExpr& expr) {
+  auto iter = static_tables_.find(module_->GetTable(expr.table));
+  if (iter == static_tables_.end()) {
+    return false;
+  }
+
+  /*
+   * Every other slot is null or holds a function of another type, so it
+   * traps, the same as an index out of bounds. If the table has no function
+   * of this type, every call traps.
+   */
+  const FuncDeclaration& decl = expr.decl;
+  static const DevirtualizedTargets kNoTargets;
+  const DevirtualizedTargets* targets = &kNoTargets;
+  SignatureKey key(decl.sig.param_types, decl.sig.result_types);
+  auto signature = iter->second.find(key);
+  if (signature != iter->second.end()) {
+    if (signature->second.empty()) {
+      return false;
+    }
+    targets = &signature->second;
+  }
+
+  Write("switch (", StackVar(0), ") ", OpenBrace());
+  DropTypes(1);
+  const size_t mark = MarkTypeStack() - decl.GetNumParams();
+  for (const auto& [func, slots] : *targets) {
+    for (Index slot : slots) {
+      Write("case ", slot, ":", Newline());
+    }
+    Indent();
+    ResetTypeStack(mark);
+    PushTypes(decl.sig.param_types);
+    Write(ExprList{std::make_unique<CallExpr>(Var(func->name, expr.loc),
+                                              expr.loc)});
+    Write("break;", Newline());
+    Dedent();
+  }
+  Write("default:", Newline());
+  Indent();
+  Write("TRAP(CALL_INDIRECT);", Newline());
+  Dedent();
+  Write(CloseBrace(), Newline());
+  ResetTypeStack(mark);
+  PushTypes(decl.sig.result_types);
+  return true;
+}
+
 static bool func_uses_simd(const FuncSignature& sig) {
   return std::any_of(sig.param_types.begin(), sig.param_types.end(),
                      [](auto x) { return x == Type::V128; }) ||
@@ -2043,7 +2487,7 @@ void CWriter::ComputeSimdScope() {
 void CWriter::WriteHeaderIncludes() {
   Write("#include \"wasm-rt.h\"", Newline());
 
-  if (module_->features_used.exceptions) {
+  if (module_->features_used.exceptions || CheckedExceptions()) {
     Write("#include \"wasm-rt-exceptions.h\"", Newline(), Newline());
   }
 
@@ -2218,6 +2662,41 @@ void CWriter::WriteDataInitializerDecls() {
   }
 }
 
+// A memory can be initialized from an image when it's defined by this module,
+// and its active data segments all have constant offsets that are in bounds
+// of its initial size, so the contents don't depend on the instance and loading
+// them can't trap.
+bool CWriter::CanUseMemoryImage(Index memory_index) const {
+  const Memory* memory = module_->memories[memory_index];
+  if (memory_index < module_->num_memory_imports ||
+      memory->page_limits.is_shared ||
+      memory->page_size != WABT_DEFAULT_PAGE_SIZE ||
+      memory->page_limits.initial >
+          std::numeric_limits<uint64_t>::max() / WABT_DEFAULT_PAGE_SIZE) {
+    return false;
+  }
+  uint64_t size = memory->page_limits.initial * WABT_DEFAULT_PAGE_SIZE;
+  bool has_data = false;
+  for (const DataSegment* data_segment : module_->data_segments) {
+    if (data_segment->kind != SegmentKind::Active ||
+        module_->GetMemoryIndex(data_segment->memory_var) != memory_index) {
+      continue;
+    }
+    if (data_segment->offset.size() != 1 ||
+        data_segment->offset.front().type() != ExprType::Const) {
+      return false;
+    }
+    const Const& offset =
+        cast<ConstExpr>(&data_segment->offset.front())->const_;
+    uint64_t start = offset.type() == Type::I32 ? offset.u32() : offset.u64();
+    if (start > size || data_segment->data.size() > size - start) {
+      return false;
+    }
+    has_data |= !data_segment->data.empty();
+  }
+  return has_data;
+}
+
 void CWriter::WriteDataInitializers() {
   if (module_->memories.empty()) {
     return;
@@ -2242,31 +2721,20 @@ void CWriter::WriteDataInitializers() {
     Write(CloseBrace(), ";", Newline());
   }
 
-  Write(Newline(), "static void init_memories(", ModuleInstanceTypeName(),
-        "* instance) ", OpenBrace());
-  if (module_->memories.size() > module_->num_memory_imports) {
-    Index memory_idx = module_->num_memory_imports;
-    for (Index i = memory_idx; i < module_->memories.size(); i++) {
-      const Memory* memory = module_->memories[i];
-      uint64_t max;
-      if (memory->page_limits.has_max) {
-        max = memory->page_limits.max;
-      } else {
-        max = memory->page_limits.is_64 ? (static_cast<uint64_t>(1) << 48)
-                                        : 65536;
-      }
-      std::string func = GetMemoryAPIString(*memory, "wasm_rt_allocate_memory");
-      Write(func, "(",
-            ExternalInstancePtr(ModuleFieldType::Memory, memory->name), ", ",
-            memory->page_limits.initial, ", ", max, ", ",
-            memory->page_limits.is_64, ");", Newline());
-    }
-  }
-
-  for (const DataSegment* data_segment : module_->data_segments) {
-    if (data_segment->kind != SegmentKind::Active) {
-      continue;
+  auto max_pages = [](const Memory* memory) -> uint64_t {
+    if (memory->page_limits.has_max) {
+      return memory->page_limits.max;
     }
+    return memory->page_limits.is_64 ? (static_cast<uint64_t>(1) << 48)
+                                     : 65536;
+  };
+  auto write_allocate = [&](const Memory* memory) {
+    std::string func = GetMemoryAPIString(*memory, "wasm_rt_allocate_memory");
+    Write(func, "(", ExternalInstancePtr(ModuleFieldType::Memory, memory->name),
+          ", ", memory->page_limits.initial, ", ", max_pages(memory), ", ",
+          memory->page_limits.is_64, ");", Newline());
+  };
+  auto write_load_data = [&](const DataSegment* data_segment) {
     const Memory* memory =
         module_->memories[module_->GetMemoryIndex(data_segment->memory_var)];
     Write("LOAD_DATA(",
@@ -2280,6 +2748,66 @@ void CWriter::WriteDataInitializers() {
             data_segment->data.size());
     }
     Write(");", Newline());
+  };
+
+  std::set<Index> imaged_memories;
+  for (Index i = module_->num_memory_imports; i < module_->memories.size();
+       i++) {
+    if (CanUseMemoryImage(i)) {
+      imaged_memories.insert(i);
+    }
+  }
+
+  Write(Newline(), "static void init_memories(", ModuleInstanceTypeName(),
+        "* instance) ", OpenBrace());
+  if (!imaged_memories.empty()) {
+    // The data segments of these memories can't trap, so the order in which
+    // they're loaded can't be observed. Each memory is initialized from an
+    // image of the first instance's memory, or loaded and then captured.
+    NonIndented([&] { Write("#if WASM_RT_USE_MEMORY_IMAGES", Newline()); });
+    for (Index i = module_->num_memory_imports; i < module_->memories.size();
+         i++) {
+      const Memory* memory = module_->memories[i];
+      if (!imaged_memories.count(i)) {
+        write_allocate(memory);
+        continue;
+      }
+      std::string image = "memory_image_" + std::to_string(i);
+      ExternalInstancePtr memory_ptr(ModuleFieldType::Memory, memory->name);
+      Write("static wasm_rt_memory_image_t ", image, ";", Newline());
+      Write("if (!wasm_rt_allocate_memory_from_image(", memory_ptr, ", &",
+            image, ", ", memory->page_limits.initial, ", ", max_pages(memory),
+            ", ", memory->page_limits.is_64, ")) ", OpenBrace());
+      for (const DataSegment* data_segment : module_->data_segments) {
+        if (data_segment->kind == SegmentKind::Active &&
+            module_->GetMemoryIndex(data_segment->memory_var) == i) {
+          write_load_data(data_segment);
+        }
+      }
+      Write("wasm_rt_capture_memory_image(&", image, ", ", memory_ptr, ");",
+            Newline());
+      Write(CloseBrace(), Newline());
+    }
+    for (const DataSegment* data_segment : module_->data_segments) {
+      if (data_segment->kind == SegmentKind::Active &&
+          !imaged_memories.count(
+              module_->GetMemoryIndex(data_segment->memory_var))) {
+        write_load_data(data_segment);
+      }
+    }
+    NonIndented([&] { Write("#else", Newline()); });
+  }
+  for (Index i = module_->num_memory_imports; i < module_->memories.size();
+       i++) {
+    write_allocate(module_->memories[i]);
+  }
+  for (const DataSegment* data_segment : module_->data_segments) {
+    if (data_segment->kind == SegmentKind::Active) {
+      write_load_data(data_segment);
+    }
+  }
+  if (!imaged_memories.empty()) {
+    NonIndented([&] { Write("#endif", Newline()); });
   }
 
   Write(CloseBrace(), Newline());
@@ -2660,6 +3188,7 @@ void CWriter::WriteExports(CWriterPhase kind) {
         if (IsSingleUnsharedMemory()) {
           RestoreSegueBase();
         }
+        WriteRethrowPendingException();
         if (num_results > 0) {
           Write("return ret;", Newline());
         }
@@ -2783,6 +3312,7 @@ void CWriter::WriteInit() {
       Write("(instance);");
     }
     Write(Newline());
+    WriteRethrowPendingException();
   }
 
   if (IsSingleUnsharedMemory()) {
@@ -3034,6 +3564,10 @@ void CWriter::WriteTailCallStack() {
 void CWriter::WriteUnwindTryCatchStack(const Label* label) {
   assert(try_catch_stack_.size() >= label->try_catch_stack_size);
 
+  if (CheckedExceptions()) {
+    return;
+  }
+
   if (try_catch_stack_.size() != label->try_catch_stack_size) {
     const std::string& name =
         try_catch_stack_.at(label->try_catch_stack_size).name;
@@ -3050,6 +3584,7 @@ void CWriter::FinishReturnCall() {
 
   Write("while (next->fn) { next->fn(instance_ptr, tail_call_stack, next); }",
         Newline());
+  WriteCheckPendingException();
   PushTypes(func_->decl.sig.result_types);
   if (!func_->decl.sig.result_types.empty()) {
     Write(OpenBrace(), func_->decl.sig.result_types, " tmp;", Newline(),
@@ -3065,6 +3600,9 @@ void CWriter::FinishReturnCall() {
 void CWriter::BeginFunction(const Func& func) {
   func_ = &func;
   in_tail_callee_ = false;
+  unwind_label_used_ = false;
+  local_versions_.assign(func.GetNumParamsAndLocals(), 0);
+  checked_ranges_.clear();
   local_syms_.clear();
   local_sym_map_.clear();
   stack_var_sym_map_.clear();
@@ -3108,6 +3646,9 @@ void CWriter::Write(const Func& func) {
         GlobalName(ModuleFieldType::Func, func.name), "(");
   WriteParamsAndLocals();
   Write("FUNC_PROLOGUE;", Newline());
+  if (recursive_funcs_.count(&func)) {
+    Write("FUNC_STACK_CHECK;", Newline());
+  }
 
   size_t stack_vars_section = func_sections_.size() - 1;
   PushFuncSection();
@@ -3131,6 +3672,7 @@ void CWriter::Write(const Func& func) {
     Spill(func.decl.sig.result_types);
     Write("return tmp;", Newline(), CloseBrace(), Newline());
   }
+  WriteUnwindLabel();
 
   stream_ = prev_stream;
   FinishFunction(stack_vars_section);
@@ -3219,6 +3761,7 @@ void CWriter::WriteTailCallee(const Func& func) {
     Write(CloseBrace(), Newline());
   }
   Write("next->fn = NULL;", Newline());
+  WriteUnwindLabel();
 
   stream_ = prev_stream;
   FinishFunction(stack_vars_section);
@@ -3319,6 +3862,9 @@ void CWriter::Write(const Block& block) {
 }
 
 size_t CWriter::BeginTry(const Block& block) {
+  if (CheckedExceptions()) {
+    return BeginCheckedTry(block);
+  }
   func_includes_.insert("exceptions");
   Write(OpenBrace()); /* beginning of try-catch or try_table */
   const std::string tlabel = DefineLabelName(block.label);
@@ -3348,6 +3894,35 @@ size_t CWriter::BeginTry(const Block& block) {
   return mark;
 }
 
+size_t CWriter::BeginCheckedTry(const Block& block) {
+  /*
+   * Nothing is saved on entry: a throw in this function jumps straight to the
+   * catch label, and a call that returns with an exception pending jumps
+   * there after testing the flag.
+   */
+  Write(OpenBrace()); /* beginning of try-catch or try_table */
+  const std::string tlabel = DefineLabelName(block.label);
+  DropTypes(block.decl.GetNumParams());
+  const size_t mark = MarkTypeStack();
+  PushLabel(LabelType::Try, block.label, block.decl.sig);
+  PushTypes(block.decl.sig.param_types);
+  PushTryCatch(tlabel);
+  Write(block.exprs);
+  ResetTypeStack(mark);
+  assert(label_stack_.back().name == block.label);
+  assert(label_stack_.back().label_type == LabelType::Try);
+  /* skip the catch blocks; the label is declared once they are written */
+  Write("goto ", tlabel, ";", Newline());
+  label_stack_.back().used = true;
+  label_stack_.back().label_type = LabelType::Catch;
+  if (try_catch_stack_.back().used) {
+    Write(tlabel, "_catch:;", Newline());
+    Write("wasm_rt_exception_pending = false;", Newline());
+  }
+
+  return mark;
+}
+
 void CWriter::WriteTryCatch(const TryExpr& tryexpr) {
   const size_t mark = BeginTry(tryexpr.block);
 
@@ -3355,7 +3930,9 @@ void CWriter::WriteTryCatch(const TryExpr& tryexpr) {
 
   const LabelName tlabel = LabelName(tryexpr.block.label);
 
-  Write("wasm_rt_set_unwind_target(", tlabel, "_outer_target);", Newline());
+  if (!CheckedExceptions()) {
+    Write("wasm_rt_set_unwind_target(", tlabel, "_outer_target);", Newline());
+  }
   PopTryCatch();
 
   /* save the thrown exception to the stack if it might be rethrown later */
@@ -3390,7 +3967,9 @@ void CWriter::WriteTryCatch(const TryExpr& tryexpr) {
     WriteThrow();
     Write(CloseBrace(), Newline());
   }
-  Write(CloseBrace(), Newline()); /* end of catch blocks */
+  if (!CheckedExceptions()) {
+    Write(CloseBrace(), Newline()); /* end of catch blocks */
+  }
   Write(CloseBrace(), Newline()); /* end of try-catch */
 
   ResetTypeStack(mark);
@@ -3430,13 +4009,89 @@ void CWriter::Write(const Catch& c) {
 
 void CWriter::WriteThrow() {
   if (try_catch_stack_.empty()) {
-    Write("wasm_rt_throw();", Newline());
+    if (CheckedExceptions()) {
+      WritePropagateException();
+    } else {
+      Write("wasm_rt_throw();", Newline());
+    }
+  } else {
+    Write("goto ", try_catch_stack_.back().name, "_catch;", Newline());
+    try_catch_stack_.back().used = true;
+  }
+}
+
+void CWriter::WriteDelegateToCaller() {
+  if (CheckedExceptions()) {
+    WritePropagateException();
+    return;
+  }
+
+  assert(!try_catch_stack_.empty());
+  const std::string& unwind_name = try_catch_stack_.at(0).name;
+  Write("wasm_rt_set_unwind_target(", unwind_name, "_outer_target);",
+        Newline());
+  Write("wasm_rt_throw();", Newline());
+}
+
+void CWriter::WritePropagateException() {
+  Write("wasm_rt_exception_pending = true;", Newline());
+  Write("goto ", kUnwindLabel, ";", Newline());
+  unwind_label_used_ = true;
+}
+
+void CWriter::WriteCheckPendingException() {
+  if (!CheckedExceptions()) {
+    return;
+  }
+
+  Write("if (UNLIKELY(wasm_rt_exception_pending)) ");
+  if (try_catch_stack_.empty()) {
+    Write("goto ", kUnwindLabel, ";", Newline());
+    unwind_label_used_ = true;
   } else {
     Write("goto ", try_catch_stack_.back().name, "_catch;", Newline());
     try_catch_stack_.back().used = true;
   }
 }
 
+void CWriter::WriteRethrowPendingException() {
+  if (!CheckedExceptions()) {
+    return;
+  }
+
+  /* callers outside the module expect exceptions to be thrown */
+  Write("if (UNLIKELY(wasm_rt_exception_pending)) ", OpenBrace());
+  Write("wasm_rt_exception_pending = false;", Newline());
+  Write("wasm_rt_throw();", Newline());
+  Write(CloseBrace(), Newline());
+}
+
+void CWriter::WriteUnwindLabel() {
+  if (!unwind_label_used_) {
+    return;
+  }
+
+  /* an exception this function doesn't catch returns to the caller */
+  if (in_tail_callee_ || func_->GetNumResults() == 0) {
+    Write("return;", Newline());
+  }
+  Write(kUnwindLabel, ":;", Newline());
+  if (in_tail_callee_) {
+    Write("next->fn = NULL;", Newline());
+    return;
+  }
+  Write("FUNC_EPILOGUE;", Newline());
+  if (func_->GetNumResults()) {
+    Write(OpenBrace(), func_->decl.sig.result_types, " tmp = {0};", Newline(),
+          "return tmp;", Newline(), CloseBrace(), Newline());
+  }
+}
+
+bool CWriter::CheckedExceptions() const {
+  return options_.exception_lowering == ExceptionLowering::Checked &&
+         options_.features.exceptions_enabled();
+}
+
 void CWriter::PushTryCatch(const std::string& name) {
   try_catch_stack_.emplace_back(name, try_catch_stack_.size());
 }
@@ -3453,12 +4108,7 @@ void CWriter::WriteTryDelegate(const TryExpr& tryexpr) {
 
   if (tryexpr.delegate_target.is_index()) {
     /* must be the implicit function label */
-    assert(!try_catch_stack_.empty());
-    const std::string& unwind_name = try_catch_stack_.at(0).name;
-    Write("wasm_rt_set_unwind_target(", unwind_name, "_outer_target);",
-          Newline());
-
-    Write("wasm_rt_throw();", Newline());
+    WriteDelegateToCaller();
   } else {
     const Label* label = FindLabel(tryexpr.delegate_target, false);
 
@@ -3468,12 +4118,7 @@ void CWriter::WriteTryDelegate(const TryExpr& tryexpr) {
       Write("goto ", LabelName(label->name), "_catch;", Newline());
       try_catch_stack_.at(label->try_catch_stack_size).used = true;
     } else if (label->try_catch_stack_size == 0) {
-      assert(!try_catch_stack_.empty());
-      const std::string& unwind_name = try_catch_stack_.at(0).name;
-      Write("wasm_rt_set_unwind_target(", unwind_name, "_outer_target);",
-            Newline());
-
-      Write("wasm_rt_throw();", Newline());
+      WriteDelegateToCaller();
     } else {
       const std::string label_target =
           try_catch_stack_.at(label->try_catch_stack_size - 1).name + "_catch";
@@ -3482,7 +4127,9 @@ void CWriter::WriteTryDelegate(const TryExpr& tryexpr) {
     }
   }
 
-  Write(CloseBrace(), Newline());
+  if (!CheckedExceptions()) {
+    Write(CloseBrace(), Newline());
+  }
   Write(CloseBrace(), Newline());
 
   PopTryCatch();
@@ -3501,13 +4148,20 @@ void CWriter::Write(const TryTableExpr& try_table_expr) {
 
   const LabelName tlabel = LabelName(try_table_expr.block.label);
 
-  Write("wasm_rt_set_unwind_target(", tlabel, "_outer_target);", Newline());
+  if (!CheckedExceptions()) {
+    Write("wasm_rt_set_unwind_target(", tlabel, "_outer_target);", Newline());
+  }
   PopTryCatch();
 
   ResetTypeStack(mark);
   assert(!label_stack_.empty());
   assert(label_stack_.back().name == try_table_expr.block.label);
-  Write(LabelDecl(GetLocalName(try_table_expr.block.label, true)));
+  /*
+   * The catch clauses branch to labels outside the try_table, so its own label
+   * is popped here, but declared after the catch blocks: a branch to it must
+   * not run them.
+   */
+  const bool label_used = IsTopLabelUsed();
   PopLabel();
 
   assert(!try_table_expr.catches.empty());
@@ -3532,8 +4186,13 @@ void CWriter::Write(const TryTableExpr& try_table_expr) {
     WriteThrow();
     Write(CloseBrace(), Newline());
   }
-  Write(CloseBrace(), Newline()); /* end of catch blocks */
+  if (!CheckedExceptions()) {
+    Write(CloseBrace(), Newline()); /* end of catch blocks */
+  }
   Write(CloseBrace(), Newline()); /* end of try-catch */
+  if (label_used) {
+    Write(tlabel, ":;", Newline());
+  }
 
   ResetTypeStack(mark);
   PushTypes(try_table_expr.block.decl.sig.result_types);
@@ -3574,6 +4233,13 @@ void CWriter::Write(const TableCatch& c) {
 }
 
 void CWriter::Write(const ExprList& exprs) {
+  // Bounds checks passed in a nested block don't cover the code after it.
+  auto outer_checked_ranges = checked_ranges_;
+  WriteExprs(exprs);
+  checked_ranges_ = std::move(outer_checked_ranges);
+}
+
+void CWriter::WriteExprs(const ExprList& exprs) {
   for (const Expr& expr : exprs) {
     switch (expr.type()) {
       case ExprType::Binary:
@@ -3616,6 +4282,17 @@ void CWriter::Write(const ExprList& exprs) {
         Index num_params = func.GetNumParams();
         Index num_results = func.GetNumResults();
         assert(type_stack_.size() >= num_params);
+        // Imported functions report exceptions with wasm_rt_throw(), so catch
+        // the longjmp here and continue as if the call had returned with the
+        // exception pending.
+        const bool guard_import = IsImport(func.name) && CheckedExceptions();
+        if (guard_import) {
+          Write(OpenBrace(), "WASM_RT_UNWIND_TARGET *outer_target = ",
+                "wasm_rt_get_unwind_target();", Newline());
+          Write("WASM_RT_UNWIND_TARGET unwind_target;", Newline());
+          Write("if (!wasm_rt_try(unwind_target)) ", OpenBrace());
+          Write("wasm_rt_set_unwind_target(&unwind_target);", Newline());
+        }
         if (num_results > 1) {
           Write(OpenBrace(), func.decl.sig.result_types, " tmp = ");
         } else if (num_results == 1) {
@@ -3641,10 +4318,21 @@ void CWriter::Write(const ExprList& exprs) {
           Unspill(func.decl.sig.result_types);
           Write(CloseBrace(), Newline());
         }
+        if (guard_import) {
+          Write("wasm_rt_set_unwind_target(outer_target);", Newline());
+          Write(CloseBrace(), " else ", OpenBrace());
+          Write("wasm_rt_set_unwind_target(outer_target);", Newline());
+          Write("wasm_rt_exception_pending = true;", Newline());
+          Write(CloseBrace(), Newline(), CloseBrace(), Newline());
+        }
+        WriteCheckPendingException();
         break;
       }
 
       case ExprType::CallIndirect: {
+        if (WriteDevirtualizedCall(*cast<CallIndirectExpr>(&expr))) {
+          break;
+        }
         const FuncDeclaration& decl = cast<CallIndirectExpr>(&expr)->decl;
         Index num_params = decl.GetNumParams();
         Index num_results = decl.GetNumResults();
@@ -3680,6 +4368,7 @@ void CWriter::Write(const ExprList& exprs) {
           Unspill(decl.sig.result_types);
           Write(CloseBrace(), Newline());
         }
+        WriteCheckPendingException();
         break;
       }
 
@@ -3694,6 +4383,11 @@ void CWriter::Write(const ExprList& exprs) {
         const Const& const_ = cast<ConstExpr>(&expr)->const_;
         PushType(const_.type());
         Write(StackVar(0), " = ", const_, ";", Newline());
+        if (const_.type() == Type::I32) {
+          stack_consts_[type_stack_.size() - 1] = const_.u32();
+        } else if (const_.type() == Type::I64) {
+          stack_consts_[type_stack_.size() - 1] = const_.u64();
+        }
         break;
       }
 
@@ -3749,12 +4443,16 @@ void CWriter::Write(const ExprList& exprs) {
         const Var& var = cast<LocalGetExpr>(&expr)->var;
         PushType(func_->GetLocalType(var));
         Write(StackVar(0), " = ", var, ";", Newline());
+        Index index = func_->GetLocalIndex(var);
+        stack_locals_[type_stack_.size() - 1] = {index,
+                                                 local_versions_[index]};
         break;
       }
 
       case ExprType::LocalSet: {
         const Var& var = cast<LocalSetExpr>(&expr)->var;
         Write(var, " = ", StackVar(0), ";", Newline());
+        local_versions_[func_->GetLocalIndex(var)]++;
         DropTypes(1);
         break;
       }
@@ -3762,6 +4460,9 @@ void CWriter::Write(const ExprList& exprs) {
       case ExprType::LocalTee: {
         const Var& var = cast<LocalTeeExpr>(&expr)->var;
         Write(var, " = ", StackVar(0), ";", Newline());
+        Index index = func_->GetLocalIndex(var);
+        stack_locals_[type_stack_.size() - 1] = {index,
+                                                 ++local_versions_[index]};
         break;
       }
 
@@ -3774,6 +4475,8 @@ void CWriter::Write(const ExprList& exprs) {
           size_t mark = MarkTypeStack();
           PushLabel(LabelType::Loop, block.label, block.decl.sig);
           PushTypes(block.decl.sig.param_types);
+          // The back edge may bring other values of these locals.
+          ForgetLocalsAssignedIn(block.exprs);
           Write(Newline(), block.exprs);
           ResetTypeStack(mark);
           PopLabel();
@@ -3995,6 +4698,8 @@ void CWriter::Write(const ExprList& exprs) {
         Write(StackVar(0), " = ", func, "(",
               ExternalInstancePtr(ModuleFieldType::Memory, memory->name), ", ",
               StackVar(0), ");", Newline());
+        DropTypes(1);
+        PushType(memory->page_limits.IndexType());
         if (IsSingleUnsharedMemory()) {
           InstallSegueBase(module_->memories[0], false /* save_old_value */);
         }
@@ -4006,9 +4711,15 @@ void CWriter::Write(const ExprList& exprs) {
             cast<MemorySizeExpr>(&expr)->memidx)];
 
         PushType(memory->page_limits.IndexType());
-        Write(StackVar(0), " = ",
-              ExternalInstanceRef(ModuleFieldType::Memory, memory->name),
-              ".pages;", Newline());
+        if (memory->page_limits.is_shared) {
+          Write(StackVar(0), " = memory_size_shared(",
+                ExternalInstancePtr(ModuleFieldType::Memory, memory->name),
+                ");", Newline());
+        } else {
+          Write(StackVar(0), " = ",
+                ExternalInstanceRef(ModuleFieldType::Memory, memory->name),
+                ".pages;", Newline());
+        }
         break;
       }
 
@@ -4163,6 +4874,16 @@ void CWriter::Write(const ExprList& exprs) {
         break;
       }
 
+      case ExprType::AtomicWait: {
+        Write(*cast<AtomicWaitExpr>(&expr));
+        break;
+      }
+
+      case ExprType::AtomicNotify: {
+        Write(*cast<AtomicNotifyExpr>(&expr));
+        break;
+      }
+
       case ExprType::AtomicFence: {
         Write("atomic_fence();", Newline());
         break;
@@ -4175,11 +4896,16 @@ void CWriter::Write(const ExprList& exprs) {
         const FuncDeclaration& decl = func.decl;
         assert(decl.sig.result_types == func_->decl.sig.result_types);
         WriteUnwindTryCatchStack(FindLabel(Var(label_stack_.size() - 1, {})));
+        // The callee replaces this frame, so its exceptions must not reach
+        // this function's catch blocks.
+        std::vector<TryCatchLabel> try_catch_stack;
+        std::swap(try_catch_stack, try_catch_stack_);
 
         if (!IsImport(func.name) && !func.features_used.tailcall) {
           // make normal call, then return
           Write(ExprList{std::make_unique<CallExpr>(inst->var, inst->loc)});
           Write("goto ", LabelName(kImplicitFuncLabel), ";", Newline());
+          std::swap(try_catch_stack, try_catch_stack_);
           return;
         }
 
@@ -4200,13 +4926,14 @@ void CWriter::Write(const ExprList& exprs) {
 
         Write("next->fn = ", TailCallRef(func.name), ";", Newline());
         if (IsImport(func.name)) {
-          Write("*instance_ptr = ",
+          Write("*instance_ptr = instance->",
                 GlobalName(ModuleFieldType::Import,
                            import_module_sym_map_.at(func.name)),
                 ";", Newline());
         }
         DropTypes(num_params);
         FinishReturnCall();
+        std::swap(try_catch_stack, try_catch_stack_);
         return;
       }
 
@@ -4218,6 +4945,8 @@ void CWriter::Write(const ExprList& exprs) {
         const Index num_params = decl.GetNumParams();
         WriteTailCallAsserts(decl.sig);
         WriteUnwindTryCatchStack(FindLabel(Var(label_stack_.size() - 1, {})));
+        std::vector<TryCatchLabel> try_catch_stack;
+        std::swap(try_catch_stack, try_catch_stack_);
         const Table* table = module_->GetTable(inst->table);
         Write("CHECK_CALL_INDIRECT(",
               ExternalInstanceRef(ModuleFieldType::Table, table->name), ", ",
@@ -4261,11 +4990,10 @@ void CWriter::Write(const ExprList& exprs) {
 
         DropTypes(num_params + 1);
         FinishReturnCall();
+        std::swap(try_catch_stack, try_catch_stack_);
         return;
       }
 
-      case ExprType::AtomicWait:
-      case ExprType::AtomicNotify:
       case ExprType::CallRef:
         UNIMPLEMENTED("...");
         break;
@@ -4570,7 +5298,7 @@ void CWriter::Write(const BinaryExpr& expr) {
       break;
 
     case Opcode::I16X8Q15mulrSatS:
-      WritePrefixBinaryExpr(expr.opcode, "simde_wasm_i16x8_q15mulr_sat");
+      WritePrefixBinaryExpr(expr.opcode, "v128_i16x8_q15mulr_sat");
       break;
 
     case Opcode::I16X8Shl:
@@ -5261,8 +5989,13 @@ void CWriter::Write(const LoadExpr& expr) {
   }
   // clang-format on
 
-  Memory* memory = module_->memories[module_->GetMemoryIndex(expr.memidx)];
-  func = GetMemoryAPIString(*memory, func);
+  Index memory_index = module_->GetMemoryIndex(expr.memidx);
+  Memory* memory = module_->memories[memory_index];
+  if (IsAccessInBounds(memory_index, 0, expr.opcode, expr.offset)) {
+    func += memory->page_limits.is_shared ? "_shared_unchecked" : "_unchecked";
+  } else {
+    func = GetMemoryAPIString(*memory, func);
+  }
 
   Type result_type = expr.opcode.GetResultType();
   Write(StackVar(0, result_type), " = ", func, "(",
@@ -5295,8 +6028,13 @@ void CWriter::Write(const StoreExpr& expr) {
   }
   // clang-format on
 
-  Memory* memory = module_->memories[module_->GetMemoryIndex(expr.memidx)];
-  func = GetMemoryAPIString(*memory, func);
+  Index memory_index = module_->GetMemoryIndex(expr.memidx);
+  Memory* memory = module_->memories[memory_index];
+  if (IsAccessInBounds(memory_index, 1, expr.opcode, expr.offset)) {
+    func += memory->page_limits.is_shared ? "_shared_unchecked" : "_unchecked";
+  } else {
+    func = GetMemoryAPIString(*memory, func);
+  }
 
   Write(func, "(", ExternalInstancePtr(ModuleFieldType::Memory, memory->name),
         ", (u64)(", StackVar(1), ")");
@@ -5410,7 +6148,7 @@ void CWriter::Write(const UnaryExpr& expr) {
       break;
 
     case Opcode::I8X16AllTrue:
-      WriteSimpleUnaryExpr(expr.opcode, "simde_wasm_i8x16_all_true");
+      WriteSimpleUnaryExpr(expr.opcode, "v128_i8x16_all_true");
       break;
 
     case Opcode::I8X16Bitmask:
@@ -5422,7 +6160,7 @@ void CWriter::Write(const UnaryExpr& expr) {
       break;
 
     case Opcode::I8X16Popcnt:
-      WriteSimpleUnaryExpr(expr.opcode, "simde_wasm_i8x16_popcnt");
+      WriteSimpleUnaryExpr(expr.opcode, "v128_i8x16_popcnt");
       break;
 
     case Opcode::I8X16Splat:
@@ -5622,7 +6360,7 @@ void CWriter::Write(const UnaryExpr& expr) {
       break;
 
     case Opcode::V128AnyTrue:
-      WriteSimpleUnaryExpr(expr.opcode, "simde_wasm_v128_any_true");
+      WriteSimpleUnaryExpr(expr.opcode, "v128_any_true");
       break;
 
     case Opcode::V128Not:
@@ -5992,6 +6730,44 @@ void CWriter::Write(const AtomicRmwExpr& expr) {
   PushType(result_type);
 }
 
+void CWriter::Write(const AtomicWaitExpr& expr) {
+  std::string func;
+  // clang-format off
+  switch (expr.opcode) {
+    case Opcode::MemoryAtomicWait32: func = "memory_atomic_wait32"; break;
+    case Opcode::MemoryAtomicWait64: func = "memory_atomic_wait64"; break;
+    default:
+      WABT_UNREACHABLE;
+  }
+  // clang-format on
+
+  Memory* memory = module_->memories[module_->GetMemoryIndex(expr.memidx)];
+  func = GetMemoryAPIString(*memory, func);
+
+  Write(StackVar(2, Type::I32), " = ", func, "(",
+        ExternalInstancePtr(ModuleFieldType::Memory, memory->name), ", (u64)(",
+        StackVar(2), ")");
+  if (expr.offset != 0)
+    Write(" + ", expr.offset);
+  Write(", ", StackVar(1), ", ", StackVar(0), ");", Newline());
+  DropTypes(3);
+  PushType(Type::I32);
+}
+
+void CWriter::Write(const AtomicNotifyExpr& expr) {
+  Memory* memory = module_->memories[module_->GetMemoryIndex(expr.memidx)];
+  std::string func = GetMemoryAPIString(*memory, "memory_atomic_notify");
+
+  Write(StackVar(1, Type::I32), " = ", func, "(",
+        ExternalInstancePtr(ModuleFieldType::Memory, memory->name), ", (u64)(",
+        StackVar(1), ")");
+  if (expr.offset != 0)
+    Write(" + ", expr.offset);
+  Write(", ", StackVar(0), ");", Newline());
+  DropTypes(2);
+  PushType(Type::I32);
+}
+
 void CWriter::Write(const AtomicRmwCmpxchgExpr& expr) {
   std::string func;
   // clang-format off
@@ -6105,8 +6881,14 @@ void CWriter::WriteCSource() {
 Result CWriter::WriteModule(const Module& module) {
   WABT_USE(options_);
   module_ = &module;
+  ComputeStaticTables();
+  ComputeRecursiveFuncs();
   WriteCHeader();
   WriteCSource();
+  if (options_.bounds_check_stats) {
+    options_.bounds_check_stats->accesses += bounds_check_stats_.accesses;
+    options_.bounds_check_stats->unchecked += bounds_check_stats_.unchecked;
+  }
   return result_;
 }
 
@@ -6148,6 +6930,26 @@ const char* CWriter::InternalSymbolScope() const {
 
 }  // end anonymous namespace
 
+static bool IsFeatureSupported(std::string_view feature) {
+  static const std::string_view kSupportedFeatures[] = {
+      "multi-memory", "multi-value", "sign-extension", "saturating-float-to-int",
+      "exceptions",   "memory64",    "extended-const", "simd",
+      "threads",      "tail-call"};
+  return std::find(std::begin(kSupportedFeatures), std::end(kSupportedFeatures),
+                   feature) != std::end(kSupportedFeatures);
+}
+
+bool AreCWriterFeaturesSupported(const Features& features) {
+  bool any_non_supported_feature = false;
+#define WABT_FEATURE(variable, flag, default_, help)                        \
+  any_non_supported_feature |= features.variable##_enabled() != default_ && \
+                               features.variable##_enabled() &&             \
+                               !IsFeatureSupported(flag);
+#include "wabt/feature.def"
+#undef WABT_FEATURE
+  return !any_non_supported_feature;
+}
+
 Result WriteC(std::vector<Stream*>&& c_streams,
               Stream* h_stream,
               Stream* h_impl_stream,
@@ -27,6 +27,8 @@
 
 #include <inttypes.h>
 
+#include <deque>
+
 namespace wabt {
 
 struct Decompiler {
@@ -56,23 +58,44 @@ struct Decompiler {
     return p == Precedence::Add || p == Precedence::Multiply;
   }
 
+  // The lines of a value are kept as a tree, and only turned into text once
+  // the whole function has been decompiled. That way wrapping a value in a
+  // parent, which may indent it, prepend a line or append to its last line,
+  // doesn't need to copy any of its lines, which would make deeply nested
+  // expressions quadratic.
+  struct Lines {
+    enum class Kind {
+      Text,    // A single line.
+      Indent,  // |child| indented by |amount|, using |text| for the first line.
+      Concat,  // The lines of |child| followed by those of |next|.
+      Append,  // |child| with |text| appended to the last line.
+    };
+
+    Kind kind;
+    std::string text;
+    size_t amount = 0;
+    const Lines* child = nullptr;
+    const Lines* next = nullptr;
+
+    // Cached so that layout decisions don't have to walk the tree.
+    size_t count = 0;
+    size_t width = 0;
+    size_t last_width = 0;
+    char last_char = 0;
+  };
+
   struct Value {
-    std::vector<std::string> v;
+    const Lines* lines;
     // Lazily add bracketing only if the parent requires it.
     // This is the precedence level of this value, for example, if this
     // precedence is Add, and the parent is Multiply, bracketing is needed,
     // but not if it is the reverse.
     Precedence precedence;
 
-    Value(std::vector<std::string>&& v, Precedence p) : v(v), precedence(p) {}
+    Value(const Lines* lines, Precedence p) : lines(lines), precedence(p) {}
 
-    size_t width() {
-      size_t w = 0;
-      for (auto& s : v) {
-        w = std::max(w, s.size());
-      }
-      return w;
-    }
+    size_t size() const { return lines ? lines->count : 0; }
+    size_t width() const { return lines ? lines->width : 0; }
 
     // This value should really never be copied, only moved.
     Value(Value&& rhs) = default;
@@ -89,7 +112,114 @@ struct Decompiler {
     return s;
   }
 
-  std::string Indent(size_t amount) { return std::string(amount, ' '); }
+  Lines* NewLines(Lines::Kind kind) {
+    lines_arena.emplace_back();
+    Lines* lines = &lines_arena.back();
+    lines->kind = kind;
+    return lines;
+  }
+
+  const Lines* Line(std::string text) {
+    Lines* lines = NewLines(Lines::Kind::Text);
+    lines->count = 1;
+    lines->width = lines->last_width = text.size();
+    lines->last_char = text.empty() ? 0 : text.back();
+    lines->text = std::move(text);
+    return lines;
+  }
+
+  Value MakeValue(std::string text, Precedence precedence) {
+    return Value{Line(std::move(text)), precedence};
+  }
+
+  const Lines* Concat(const Lines* first, const Lines* second) {
+    if (!first || !second) {
+      return first ? first : second;
+    }
+    Lines* lines = NewLines(Lines::Kind::Concat);
+    lines->child = first;
+    lines->next = second;
+    lines->count = first->count + second->count;
+    lines->width = std::max(first->width, second->width);
+    lines->last_width = second->last_width;
+    lines->last_char = second->last_char;
+    return lines;
+  }
+
+  const Lines* Append(const Lines* child, std::string_view text) {
+    if (!child) {
+      return Line(std::string(text));
+    }
+    Lines* lines = NewLines(Lines::Kind::Append);
+    lines->child = child;
+    lines->text = std::string(text);
+    lines->count = child->count;
+    lines->last_width = child->last_width + text.size();
+    lines->width = std::max(child->width, lines->last_width);
+    lines->last_char = text.empty() ? child->last_char : text.back();
+    return lines;
+  }
+
+  // Writes |lines| to |out|, indenting all but the first line by |indent|.
+  void WriteLines(const Lines* lines, size_t indent, std::string& out) {
+    // A Concat chain is as long as a function has statements, so use an
+    // explicit stack rather than recursion.
+    struct Item {
+      const Lines* lines;
+      // If |lines| is null, |text| is written instead, after starting a new
+      // line indented by |indent| if |newline| is set.
+      std::string_view text;
+      size_t indent;
+      bool newline;
+    };
+    std::vector<Item> stack;
+    stack.push_back({lines, {}, indent, false});
+    while (!stack.empty()) {
+      Item item = stack.back();
+      stack.pop_back();
+      if (!item.lines) {
+        if (item.newline) {
+          out += '\n';
+          out.append(item.indent, ' ');
+        }
+        out.append(item.text.data(), item.text.size());
+        continue;
+      }
+      const Lines& l = *item.lines;
+      switch (l.kind) {
+        case Lines::Kind::Text:
+          out += l.text;
+          break;
+        case Lines::Kind::Indent:
+          if (l.text.empty()) {
+            out.append(l.amount, ' ');
+          } else {
+            out += l.text;
+          }
+          stack.push_back({l.child, {}, item.indent + l.amount, false});
+          break;
+        case Lines::Kind::Concat:
+          stack.push_back({l.next, {}, item.indent, false});
+          stack.push_back({nullptr, {}, item.indent, true});
+          stack.push_back({l.child, {}, item.indent, false});
+          break;
+        case Lines::Kind::Append:
+          stack.push_back({nullptr, l.text, 0, false});
+          stack.push_back({l.child, {}, item.indent, false});
+          break;
+      }
+    }
+  }
+
+  // The text of a value that fits on a single line.
+  std::string LineText(const Value& val) {
+    assert(val.size() <= 1);
+    std::string s;
+    if (val.lines) {
+      WriteLines(val.lines, 0, s);
+    }
+    return s;
+  }
 
   std::string OpcodeToToken(Opcode opcode) {
     std::string s = opcode.GetDecomp();
@@ -98,13 +228,26 @@ struct Decompiler {
   }
 
   void IndentValue(Value& val, size_t amount, std::string_view first_indent) {
-    auto indent = Indent(amount);
-    for (auto& stat : val.v) {
-      auto is = (&stat != &val.v[0] || first_indent.empty())
-                    ? std::string_view(indent)
-                    : first_indent;
-      stat.insert(0, is.data(), is.size());
+    assert(first_indent.empty() || first_indent.size() == amount);
+    if (!val.lines) {
+      return;
+    }
+    const Lines* child = val.lines;
+    Lines* lines = NewLines(Lines::Kind::Indent);
+    lines->text = std::string(first_indent);
+    lines->amount = amount;
+    lines->child = child;
+    lines->count = child->count;
+    lines->width = child->width + amount;
+    lines->last_width = child->last_width + amount;
+    lines->last_char = child->last_char;
+    if (!child->last_width) {
+      lines->last_char =
+          child->count == 1 && !first_indent.empty() ? first_indent.back()
+          : amount                                   ? ' '
+                                                     : 0;
     }
+    val.lines = lines;
   }
 
   Value WrapChild(Value& child,
@@ -112,24 +255,22 @@ struct Decompiler {
                   std::string_view postfix,
                   Precedence precedence) {
     auto width = prefix.size() + postfix.size() + child.width();
-    auto& v = child.v;
     if (width < target_exp_width ||
         (prefix.size() <= indent_amount && postfix.size() <= indent_amount)) {
-      if (v.size() == 1) {
+      if (child.size() == 1) {
         // Fits in a single line.
-        v[0].insert(0, prefix.data(), prefix.size());
-        v[0].append(postfix.data(), postfix.size());
+        child = MakeValue(cat(prefix, LineText(child), postfix), precedence);
+        return std::move(child);
       } else {
         // Multiline, but with prefix on same line.
         IndentValue(child, prefix.size(), prefix);
-        v.back().append(postfix.data(), postfix.size());
       }
     } else {
       // Multiline with prefix on its own line.
       IndentValue(child, indent_amount, {});
-      v.insert(v.begin(), std::string(prefix));
-      v.back().append(postfix.data(), postfix.size());
+      child.lines = Concat(Line(std::string(prefix)), child.lines);
     }
+    child.lines = Append(child.lines, postfix);
     child.precedence = precedence;
     return std::move(child);
   }
@@ -153,17 +294,15 @@ struct Decompiler {
     BracketIfNeeded(left, precedence);
     BracketIfNeeded(right, precedence);
     auto width = infix.size() + left.width() + right.width() + 2;
-    if (width < target_exp_width && left.v.size() == 1 && right.v.size() == 1) {
-      return Value{{cat(left.v[0], " ", infix, " ", right.v[0])}, precedence};
+    if (width < target_exp_width && left.size() == 1 && right.size() == 1) {
+      return MakeValue(cat(LineText(left), " ", infix, " ", LineText(right)),
+                       precedence);
     } else {
-      Value bin{{}, precedence};
-      std::move(left.v.begin(), left.v.end(), std::back_inserter(bin.v));
-      bin.v.back().append(" ", 1);
-      bin.v.back().append(infix.data(), infix.size());
+      Value bin{Append(left.lines, cat(" ", infix)), precedence};
       if (indent_right) {
         IndentValue(right, indent_amount, {});
       }
-      std::move(right.v.begin(), right.v.end(), std::back_inserter(bin.v));
+      bin.lines = Concat(bin.lines, right.lines);
       return bin;
     }
   }
@@ -179,7 +318,7 @@ struct Decompiler {
       auto w = child.width();
       max_width = std::max(max_width, w);
       total_width += w;
-      multiline = multiline || child.v.size() > 1;
+      multiline = multiline || child.size() > 1;
     }
     if (!multiline &&
         (total_width + prefix.size() + postfix.size() < target_exp_width ||
@@ -189,28 +328,28 @@ struct Decompiler {
       for (auto& child : args) {
         if (&child != &args[0])
           s += ", ";
-        s += child.v[0];
+        s += LineText(child);
       }
       s += postfix;
-      return Value{{std::move(s)}, precedence};
+      return MakeValue(std::move(s), precedence);
     } else {
       // Multi-line.
-      Value ml{{}, precedence};
+      Value ml{nullptr, precedence};
       auto ident_with_name = max_width + prefix.size() < target_exp_width;
       size_t i = 0;
       for (auto& child : args) {
         IndentValue(child, ident_with_name ? prefix.size() : indent_amount,
                     !i && ident_with_name ? prefix : std::string_view{});
         if (i < args.size() - 1) {
-          child.v.back() += ",";
+          child.lines = Append(child.lines, ",");
         }
-        std::move(child.v.begin(), child.v.end(), std::back_inserter(ml.v));
+        ml.lines = Concat(ml.lines, child.lines);
         i++;
       }
       if (!ident_with_name) {
-        ml.v.insert(ml.v.begin(), std::string(prefix));
+        ml.lines = Concat(Line(std::string(prefix)), ml.lines);
       }
-      ml.v.back() += postfix;
+      ml.lines = Append(ml.lines, postfix);
       return ml;
     }
   }
@@ -222,7 +361,7 @@ struct Decompiler {
 
   template <ExprType T>
   Value Get(const VarExpr<T>& ve) {
-    return Value{{std::string(VarName(ve.var.name()))}, Precedence::Atomic};
+    return MakeValue(std::string(VarName(ve.var.name())), Precedence::Atomic);
   }
 
   template <ExprType T>
@@ -273,7 +412,7 @@ struct Decompiler {
       } else {
         // We can do this load/store as a struct access.
         BracketIfNeeded(val, Precedence::Indexing);
-        val.v.back() += "." + access;
+        val.lines = Append(val.lines, "." + access);
         return;
       }
     }
@@ -292,7 +431,7 @@ struct Decompiler {
             abs_base >= dat_base && abs_base < dat_base + dat->data.size()) {
           // We are inside the range of this data segment!
           // Turn expression into data_name[index]
-          val = Value{{dat->name}, Precedence::Atomic};
+          val = MakeValue(dat->name, Precedence::Atomic);
           // The new offset is from the start of the data segment, instead of
           // whatever it was.. this may be a different value from both the
           // original const and offset!
@@ -327,12 +466,12 @@ struct Decompiler {
             // TODO: we're decompiling these twice.
             // The thing to the left of << is going to be part of the index.
             auto ival = DecompileExpr(shift_exp.children[0], &shift_exp);
-            if (ival.v.size() == 1) {  // Don't bother if huge.
+            if (ival.size() == 1) {  // Don't bother if huge.
               if (offset == 0) {
-                index = ival.v[0];
+                index = LineText(ival);
               } else {
                 BracketIfNeeded(ival, Precedence::Add);
-                index = cat(ival.v[0], " + ", index);
+                index = cat(LineText(ival), " + ", index);
               }
               // We're going to use the thing to the left of + as the new
               // base address:
@@ -343,10 +482,11 @@ struct Decompiler {
       }
     }
     BracketIfNeeded(val, Precedence::Indexing);
-    val.v.back() += cat("[", index, "]");
+    val.lines = Append(val.lines, cat("[", index, "]"));
     if (append_type) {
-      val.v.back() += cat(":", GetDecompTypeName(GetMemoryType(op_type, opc)),
-                          lst.GenAlign(align, opc));
+      val.lines = Append(
+          val.lines, cat(":", GetDecompTypeName(GetMemoryType(op_type, opc)),
+                         lst.GenAlign(align, opc)));
     }
     val.precedence = Precedence::Indexing;
   }
@@ -370,17 +510,16 @@ struct Decompiler {
         return WrapNAry(args, decls, "", Precedence::Assign);
       }
       case NodeType::FlushedVar: {
-        return Value{{TempVarName(n.u.var_start)}, Precedence::Atomic};
+        return MakeValue(TempVarName(n.u.var_start), Precedence::Atomic);
       }
       case NodeType::Statements: {
-        Value stats{{}, Precedence::None};
+        Value stats{nullptr, Precedence::None};
         for (size_t i = 0; i < n.children.size(); i++) {
-          auto& s = args[i].v.back();
-          if (s.back() != '}' && s.back() != ':') {
-            s += ';';
+          auto& lines = args[i].lines;
+          if (lines->last_char != '}' && lines->last_char != ':') {
+            lines = Append(lines, ";");
           }
-          std::move(args[i].v.begin(), args[i].v.end(),
-                    std::back_inserter(stats.v));
+          stats.lines = Concat(stats.lines, lines);
         }
         return stats;
       }
@@ -389,9 +528,9 @@ struct Decompiler {
       }
       case NodeType::Decl: {
         cur_ast->vars_defined[n.u.var->name()].defined = true;
-        return Value{{"var " + LocalDecl(std::string(n.u.var->name()),
-                                         cur_func->GetLocalType(*n.u.var))},
-                     Precedence::None};
+        return MakeValue("var " + LocalDecl(std::string(n.u.var->name()),
+                                            cur_func->GetLocalType(*n.u.var)),
+                         Precedence::None);
       }
       case NodeType::DeclInit: {
         if (cur_ast->vars_defined[n.u.var->name()].defined) {
@@ -420,21 +559,22 @@ struct Decompiler {
         auto& c = cast<ConstExpr>(n.e)->const_;
         switch (c.type()) {
           case Type::I32:
-            return Value{{std::to_string(static_cast<int32_t>(c.u32()))},
-                         Precedence::Atomic};
+            return MakeValue(std::to_string(static_cast<int32_t>(c.u32())),
+                             Precedence::Atomic);
           case Type::I64:
-            return Value{{std::to_string(static_cast<int64_t>(c.u64())) + "L"},
-                         Precedence::Atomic};
+            return MakeValue(
+                std::to_string(static_cast<int64_t>(c.u64())) + "L",
+                Precedence::Atomic);
           case Type::F32: {
             float f = Bitcast<float>(c.f32_bits());
-            return Value{{to_string(f) + "f"}, Precedence::Atomic};
+            return MakeValue(to_string(f) + "f", Precedence::Atomic);
           }
           case Type::F64: {
             double d = Bitcast<double>(c.f64_bits());
-            return Value{{to_string(d)}, Precedence::Atomic};
+            return MakeValue(to_string(d), Precedence::Atomic);
           }
           case Type::V128:
-            return Value{{"V128"}, Precedence::Atomic};  // FIXME
+            return MakeValue("V128", Precedence::Atomic);  // FIXME
           default:
             WABT_UNREACHABLE;
         }
@@ -504,42 +644,41 @@ struct Decompiler {
         }
         auto& thenp = args[1];
         auto& ifs = args[0];
-        bool multiline = ifs.v.size() > 1 || thenp.v.size() > 1;
+        bool multiline = ifs.size() > 1 || thenp.size() > 1;
         size_t width = ifs.width() + thenp.width();
         if (elsep) {
           width += elsep->width();
-          multiline = multiline || elsep->v.size() > 1;
+          multiline = multiline || elsep->size() > 1;
         }
         multiline = multiline || width > target_exp_width;
         if (multiline) {
           auto if_start = std::string_view("if (");
           IndentValue(ifs, if_start.size(), if_start);
-          ifs.v.back() += ") {";
+          ifs.lines = Append(ifs.lines, ") {");
           IndentValue(thenp, indent_amount, {});
-          std::move(thenp.v.begin(), thenp.v.end(), std::back_inserter(ifs.v));
+          ifs.lines = Concat(ifs.lines, thenp.lines);
           if (elsep) {
-            ifs.v.push_back("} else {");
+            ifs.lines = Concat(ifs.lines, Line("} else {"));
             IndentValue(*elsep, indent_amount, {});
-            std::move(elsep->v.begin(), elsep->v.end(),
-                      std::back_inserter(ifs.v));
+            ifs.lines = Concat(ifs.lines, elsep->lines);
           }
-          ifs.v.push_back("}");
+          ifs.lines = Concat(ifs.lines, Line("}"));
           ifs.precedence = Precedence::If;
           return std::move(ifs);
         } else {
-          auto s = cat("if (", ifs.v[0], ") {");
-          if (!thenp.v.empty())
-            s += cat(" ", thenp.v[0], " ");
+          auto s = cat("if (", LineText(ifs), ") {");
+          if (thenp.size())
+            s += cat(" ", LineText(thenp), " ");
           s += "}";
           if (elsep)
-            s += cat(" else { ", elsep->v[0], " }");
-          return Value{{std::move(s)}, Precedence::If};
+            s += cat(" else { ", LineText(*elsep), " }");
+          return MakeValue(std::move(s), Precedence::If);
         }
       }
       case ExprType::Block: {
         auto& val = args[0];
-        val.v.push_back(
-            cat("label ", VarName(cast<BlockExpr>(n.e)->block.label), ":"));
+        auto label = VarName(cast<BlockExpr>(n.e)->block.label);
+        val.lines = Concat(val.lines, Line(cat("label ", label, ":")));
         // If this block is part of a larger statement scope, it doesn't
         // need its own indenting, but if its part of an exp we wrap it in {}.
         if (parent && parent->ntype != NodeType::Statements &&
@@ -547,8 +686,7 @@ struct Decompiler {
             parent->etype != ExprType::Loop &&
             (parent->etype != ExprType::If || &parent->children[0] == &n)) {
           IndentValue(val, indent_amount, {});
-          val.v.insert(val.v.begin(), "{");
-          val.v.push_back("}");
+          val.lines = Concat(Concat(Line("{"), val.lines), Line("}"));
         }
         val.precedence = Precedence::Atomic;
         return std::move(val);
@@ -557,16 +695,17 @@ struct Decompiler {
         auto& val = args[0];
         auto& block = cast<LoopExpr>(n.e)->block;
         IndentValue(val, indent_amount, {});
-        val.v.insert(val.v.begin(), cat("loop ", VarName(block.label), " {"));
-        val.v.push_back("}");
+        val.lines = Concat(
+            Concat(Line(cat("loop ", VarName(block.label), " {")), val.lines),
+            Line("}"));
         val.precedence = Precedence::Atomic;
         return std::move(val);
       }
       case ExprType::Br: {
         auto be = cast<BrExpr>(n.e);
-        return Value{{(n.u.lt == LabelType::Loop ? "continue " : "goto ") +
-                      VarName(be->var.name())},
-                     Precedence::None};
+        return MakeValue((n.u.lt == LabelType::Loop ? "continue " : "goto ") +
+                             VarName(be->var.name()),
+                         Precedence::None);
       }
       case ExprType::BrIf: {
         auto bie = cast<BrIfExpr>(n.e);
@@ -587,13 +726,13 @@ struct Decompiler {
         return std::move(args[0]);
       }
       case ExprType::Nop: {
-        return Value{{"nop"}, Precedence::None};
+        return MakeValue("nop", Precedence::None);
       }
       case ExprType::Unreachable: {
-        return Value{{"unreachable"}, Precedence::None};
+        return MakeValue("unreachable", Precedence::None);
       }
       case ExprType::RefNull: {
-        return Value{{"null"}, Precedence::Atomic};
+        return MakeValue("null", Precedence::Atomic);
       }
       case ExprType::BrTable: {
         auto bte = cast<BrTableExpr>(n.e);
@@ -611,7 +750,7 @@ struct Decompiler {
         auto cme = cast<CodeMetadataExpr>(n.e);
         std::string c = "// @metadata.code." + cme->name + " ";
         c += BinaryToString(cme->data);
-        return Value{{std::move(c)}, Precedence::None};
+        return MakeValue(std::move(c), Precedence::None);
       }
       default: {
         // Everything that looks like a function call.
@@ -692,8 +831,8 @@ struct Decompiler {
     AST ast(mc, nullptr);
     ast.Construct(el, 1, 0, false);
     auto val = DecompileExpr(ast.exp_stack[0], nullptr);
-    assert(ast.exp_stack.size() == 1 && val.v.size() == 1);
-    return std::move(val.v[0]);
+    assert(ast.exp_stack.size() == 1 && val.size() == 1);
+    return LineText(val);
   }
 
   // FIXME: Merge with WatWriter::WriteQuotedData somehow.
@@ -722,7 +861,9 @@ struct Decompiler {
     return s;
   }
 
-  std::string Decompile() {
+  // Writes each function to |stream| as soon as it has been decompiled, so
+  // that only one function's worth of text is held at a time.
+  Result Decompile(Stream* stream) {
     std::string s;
     // Memories.
     Index memory_index = 0;
@@ -789,6 +930,9 @@ struct Decompiler {
     }
     if (!mc.module.data_segments.empty())
       s += "\n";
+    stream->WriteData(s.data(), s.size());
+    s.clear();
+    lines_arena.clear();
 
     // Code.
     Index func_index = 0;
@@ -831,20 +975,23 @@ struct Decompiler {
         s += cat(" { // func", std::to_string(func_index), "\n");
         auto val = DecompileExpr(ast.exp_stack[0], nullptr);
         IndentValue(val, indent_amount, {});
-        for (auto& stat : val.v) {
-          s += stat;
+        if (val.lines) {
+          WriteLines(val.lines, 0, s);
           s += "\n";
         }
         s += "}";
       }
       s += "\n\n";
+      stream->WriteData(s.data(), s.size());
+      s.clear();
+      lines_arena.clear();
       mc.EndFunc();
       lst.Clear();
       func_index++;
       cur_ast = nullptr;
       cur_func = nullptr;
     }
-    return s;
+    return stream->result();
   }
 
   ModuleContext mc;
@@ -854,11 +1001,23 @@ struct Decompiler {
   const Func* cur_func = nullptr;
   AST* cur_ast = nullptr;
   LoadStoreTracking lst;
+  // Backing store for the Lines of the function being decompiled; a deque so
+  // that adding to it doesn't move the existing nodes.
+  std::deque<Lines> lines_arena;
 };
 
-std::string Decompile(const Module& module, const DecompileOptions& options) {
+Result Decompile(const Module& module,
+                 const DecompileOptions& options,
+                 Stream* stream) {
   Decompiler decompiler(module, options);
-  return decompiler.Decompile();
+  return decompiler.Decompile(stream);
+}
+
+std::string Decompile(const Module& module, const DecompileOptions& options) {
+  MemoryStream stream;
+  Decompile(module, options, &stream);
+  const std::vector<uint8_t>& data = stream.output_buffer().data;
+  return std::string(data.begin(), data.end());
 }
 
 }  // namespace wabt
@@ -42,6 +42,7 @@ struct FloatTraitsBase<float> {
   static constexpr int kSigBits = 23;
   static constexpr float kHugeVal = HUGE_VALF;
   static constexpr int kMaxHexBufferSize = WABT_MAX_FLOAT_HEX;
+  static constexpr int kMaxDecimalBufferSize = WABT_MAX_FLOAT_DECIMAL;
 
   static float Strto(const char* s, char** endptr) { return strtof(s, endptr); }
 };
@@ -53,6 +54,7 @@ struct FloatTraitsBase<double> {
   static constexpr int kSigBits = 52;
   static constexpr float kHugeVal = HUGE_VAL;
   static constexpr int kMaxHexBufferSize = WABT_MAX_DOUBLE_HEX;
+  static constexpr int kMaxDecimalBufferSize = WABT_MAX_DOUBLE_DECIMAL;
 
   static double Strto(const char* s, char** endptr) {
     return strtod(s, endptr);
@@ -111,6 +113,7 @@ class FloatWriter {
   using Uint = typename Traits::Uint;
 
   static void WriteHex(char* out, size_t size, Uint bits);
+  static void WriteDecimal(char* out, size_t size, Uint bits);
 };
 
 // Return 1 if the non-NULL-terminated string starting with |start| and ending
@@ -554,6 +557,392 @@ void FloatWriter<T>::WriteHex(char* out, size_t size, Uint bits) {
   out[len] = '\0';
 }
 
+// Shortest round-trip decimal formatting, using the Grisu2 algorithm from
+// Florian Loitsch, "Printing Floating-Point Numbers Quickly and Accurately
+// with Integers" (PLDI 2010). The generated digits always parse back to the
+// same bits with a correctly-rounded strtof/strtod, and are the shortest such
+// digit string in the vast majority of cases.
+
+// A "do-it-yourself" floating point value: f * 2^e.
+struct DiyFp {
+  static constexpr int kPrecision = 64;
+
+  uint64_t f;
+  int e;
+
+  DiyFp(uint64_t f, int e) : f(f), e(e) {}
+
+  // Subtract two values with the same exponent; requires x.f >= y.f.
+  static DiyFp Sub(DiyFp x, DiyFp y) {
+    assert(x.e == y.e && x.f >= y.f);
+    return DiyFp(x.f - y.f, x.e);
+  }
+
+  // Multiply two values, keeping the upper 64 bits (rounded) of the 128-bit
+  // product.
+  static DiyFp Mul(DiyFp x, DiyFp y) {
+    uint64_t u_lo = x.f & 0xffffffffu;
+    uint64_t u_hi = x.f >> 32;
+    uint64_t v_lo = y.f & 0xffffffffu;
+    uint64_t v_hi = y.f >> 32;
+
+    uint64_t p0 = u_lo * v_lo;
+    uint64_t p1 = u_lo * v_hi;
+    uint64_t p2 = u_hi * v_lo;
+    uint64_t p3 = u_hi * v_hi;
+
+    uint64_t q = (p0 >> 32) + (p1 & 0xffffffffu) + (p2 & 0xffffffffu);
+    q += uint64_t(1) << 31;  // Round, ties up.
+    uint64_t h = p3 + (p2 >> 32) + (p1 >> 32) + (q >> 32);
+    return DiyFp(h, x.e + y.e + 64);
+  }
+
+  static DiyFp Normalize(DiyFp x) {
+    assert(x.f != 0);
+    while ((x.f >> 63) == 0) {
+      x.f <<= 1;
+      x.e--;
+    }
+    return x;
+  }
+
+  static DiyFp NormalizeTo(DiyFp x, int target_exponent) {
+    int delta = x.e - target_exponent;
+    assert(delta >= 0 && ((x.f << delta) >> delta) == x.f);
+    return DiyFp(x.f << delta, target_exponent);
+  }
+};
+
+struct CachedPower {
+  uint64_t f;
+  int e;
+  int k;
+};
+
+// The normalized exponent of the scaled value must lie in [kAlpha, kGamma] so
+// the integral part fits in 32 bits and digit generation can use 64-bit
+// arithmetic.
+constexpr int kAlpha = -60;
+constexpr int kGamma = -32;
+
+// Returns c = 10^k with exponent c.e, such that
+// kAlpha <= c.e + e + 64 <= kGamma.
+CachedPower GetCachedPowerForBinaryExponent(int e) {
+  // Normalized approximations of 10^k, for k = -348, -340, ..., 340.
+  static const CachedPower kCachedPowers[] = {
+      {0xfa8fd5a0081c0288, -1220, -348},
+      {0xbaaee17fa23ebf76, -1193, -340},
+      {0x8b16fb203055ac76, -1166, -332},
+      {0xcf42894a5dce35ea, -1140, -324},
+      {0x9a6bb0aa55653b2d, -1113, -316},
+      {0xe61acf033d1a45df, -1087, -308},
+      {0xab70fe17c79ac6ca, -1060, -300},
+      {0xff77b1fcbebcdc4f, -1034, -292},
+      {0xbe5691ef416bd60c, -1007, -284},
+      {0x8dd01fad907ffc3c, -980, -276},
+      {0xd3515c2831559a83, -954, -268},
+      {0x9d71ac8fada6c9b5, -927, -260},
+      {0xea9c227723ee8bcb, -901, -252},
+      {0xaecc49914078536d, -874, -244},
+      {0x823c12795db6ce57, -847, -236},
+      {0xc21094364dfb5637, -821, -228},
+      {0x9096ea6f3848984f, -794, -220},
+      {0xd77485cb25823ac7, -768, -212},
+      {0xa086cfcd97bf97f4, -741, -204},
+      {0xef340a98172aace5, -715, -196},
+      {0xb23867fb2a35b28e, -688, -188},
+      {0x84c8d4dfd2c63f3b, -661, -180},
+      {0xc5dd44271ad3cdba, -635, -172},
+      {0x936b9fcebb25c996, -608, -164},
+      {0xdbac6c247d62a584, -582, -156},
+      {0xa3ab66580d5fdaf6, -555, -148},
+      {0xf3e2f893dec3f126, -529, -140},
+      {0xb5b5ada8aaff80b8, -502, -132},
+      {0x87625f056c7c4a8b, -475, -124},
+      {0xc9bcff6034c13053, -449, -116},
+      {0x964e858c91ba2655, -422, -108},
+      {0xdff9772470297ebd, -396, -100},
+      {0xa6dfbd9fb8e5b88f, -369, -92},
+      {0xf8a95fcf88747d94, -343, -84},
+      {0xb94470938fa89bcf, -316, -76},
+      {0x8a08f0f8bf0f156b, -289, -68},
+      {0xcdb02555653131b6, -263, -60},
+      {0x993fe2c6d07b7fac, -236, -52},
+      {0xe45c10c42a2b3b06, -210, -44},
+      {0xaa242499697392d3, -183, -36},
+      {0xfd87b5f28300ca0e, -157, -28},
+      {0xbce5086492111aeb, -130, -20},
+      {0x8cbccc096f5088cc, -103, -12},
+      {0xd1b71758e219652c, -77, -4},
+      {0x9c40000000000000, -50, 4},
+      {0xe8d4a51000000000, -24, 12},
+      {0xad78ebc5ac620000, 3, 20},
+      {0x813f3978f8940984, 30, 28},
+      {0xc097ce7bc90715b3, 56, 36},
+      {0x8f7e32ce7bea5c70, 83, 44},
+      {0xd5d238a4abe98068, 109, 52},
+      {0x9f4f2726179a2245, 136, 60},
+      {0xed63a231d4c4fb27, 162, 68},
+      {0xb0de65388cc8ada8, 189, 76},
+      {0x83c7088e1aab65db, 216, 84},
+      {0xc45d1df942711d9a, 242, 92},
+      {0x924d692ca61be758, 269, 100},
+      {0xda01ee641a708dea, 295, 108},
+      {0xa26da3999aef774a, 322, 116},
+      {0xf209787bb47d6b85, 348, 124},
+      {0xb454e4a179dd1877, 375, 132},
+      {0x865b86925b9bc5c2, 402, 140},
+      {0xc83553c5c8965d3d, 428, 148},
+      {0x952ab45cfa97a0b3, 455, 156},
+      {0xde469fbd99a05fe3, 481, 164},
+      {0xa59bc234db398c25, 508, 172},
+      {0xf6c69a72a3989f5c, 534, 180},
+      {0xb7dcbf5354e9bece, 561, 188},
+      {0x88fcf317f22241e2, 588, 196},
+      {0xcc20ce9bd35c78a5, 614, 204},
+      {0x98165af37b2153df, 641, 212},
+      {0xe2a0b5dc971f303a, 667, 220},
+      {0xa8d9d1535ce3b396, 694, 228},
+      {0xfb9b7cd9a4a7443c, 720, 236},
+      {0xbb764c4ca7a44410, 747, 244},
+      {0x8bab8eefb6409c1a, 774, 252},
+      {0xd01fef10a657842c, 800, 260},
+      {0x9b10a4e5e9913129, 827, 268},
+      {0xe7109bfba19c0c9d, 853, 276},
+      {0xac2820d9623bf429, 880, 284},
+      {0x80444b5e7aa7cf85, 907, 292},
+      {0xbf21e44003acdd2d, 933, 300},
+      {0x8e679c2f5e44ff8f, 960, 308},
+      {0xd433179d9c8cb841, 986, 316},
+      {0x9e19db92b4e31ba9, 1013, 324},
+      {0xeb96bf6ebadf77d9, 1039, 332},
+      {0xaf87023b9bf0ee6b, 1066, 340},
+  };
+  static constexpr int kCachedPowersMinDecExp = -348;
+  static constexpr int kCachedPowersDecStep = 8;
+
+  // k = ceil((kAlpha - e - 1) * log10(2)); 78913 / 2^18 approximates
+  // log10(2) closely enough for the range of binary exponents used here.
+  int f = kAlpha - e - 1;
+  int k = (f * 78913) / (1 << 18) + (f > 0 ? 1 : 0);
+  int index = (-kCachedPowersMinDecExp + k + (kCachedPowersDecStep - 1)) /
+              kCachedPowersDecStep;
+  assert(index >= 0 &&
+         static_cast<size_t>(index) < WABT_ARRAY_SIZE(kCachedPowers));
+  const CachedPower& cached = kCachedPowers[index];
+  assert(kAlpha <= cached.e + e + 64 && cached.e + e + 64 <= kGamma);
+  return cached;
+}
+
+// Returns the number of decimal digits in n, and sets |pow10| to
+// 10^(digits - 1).
+int FindLargestPow10(uint32_t n, uint32_t* pow10) {
+  uint32_t p = 1000000000;
+  int digits = 10;
+  while (digits > 1 && n < p) {
+    p /= 10;
+    digits--;
+  }
+  *pow10 = p;
+  return digits;
+}
+
+// Move the last generated digit towards w while it stays inside the safe
+// interval, so the result is as close as possible to the exact value.
+void Grisu2Round(char* buffer,
+                 int length,
+                 uint64_t dist,
+                 uint64_t delta,
+                 uint64_t rest,
+                 uint64_t ten_k) {
+  while (rest < dist && delta - rest >= ten_k &&
+         (rest + ten_k < dist || dist - rest > rest + ten_k - dist)) {
+    buffer[length - 1]--;
+    rest += ten_k;
+  }
+}
+
+// Generate the digits of a value in [m_minus, m_plus] that is closest to w.
+// On return, value = buffer * 10^decimal_exponent.
+void Grisu2DigitGen(char* buffer,
+                    int* length,
+                    int* decimal_exponent,
+                    DiyFp m_minus,
+                    DiyFp w,
+                    DiyFp m_plus) {
+  uint64_t delta = DiyFp::Sub(m_plus, m_minus).f;
+  uint64_t dist = DiyFp::Sub(m_plus, w).f;
+
+  // Split m_plus into an integral part p1 and a fractional part p2.
+  const DiyFp one(uint64_t(1) << -m_plus.e, m_plus.e);
+  uint32_t p1 = static_cast<uint32_t>(m_plus.f >> -one.e);
+  uint64_t p2 = m_plus.f & (one.f - 1);
+
+  uint32_t pow10;
+  int n = FindLargestPow10(p1, &pow10);
+  while (n > 0) {
+    uint32_t d = p1 / pow10;
+    p1 %= pow10;
+    buffer[(*length)++] = static_cast<char>('0' + d);
+    n--;
+
+    uint64_t rest = (uint64_t(p1) << -one.e) + p2;
+    if (rest <= delta) {
+      *decimal_exponent += n;
+      Grisu2Round(buffer, *length, dist, delta, rest,
+                  uint64_t(pow10) << -one.e);
+      return;
+    }
+    pow10 /= 10;
+  }
+
+  // The integral part is exhausted; generate fractional digits until the
+  // remainder fits in the safe interval.
+  int m = 0;
+  for (;;) {
+    p2 *= 10;
+    uint64_t d = p2 >> -one.e;
+    p2 &= one.f - 1;
+    buffer[(*length)++] = static_cast<char>('0' + d);
+    m++;
+    delta *= 10;
+    dist *= 10;
+    if (p2 <= delta) {
+      break;
+    }
+  }
+  *decimal_exponent -= m;
+  Grisu2Round(buffer, *length, dist, delta, p2, one.f);
+}
+
+// Write the digits in |digits| (with value digits * 10^decimal_exponent) to
+// |p|, using plain notation for moderately-sized values and exponent notation
+// otherwise. Returns a pointer past the last character written.
+char* FormatDecimal(char* p,
+                    const char* digits,
+                    int length,
+                    int decimal_exponent,
+                    int max_plain_exp) {
+  static constexpr int kMinPlainExp = -4;
+
+  // Position of the decimal point relative to the start of the digits.
+  int n = length + decimal_exponent;
+
+  if (length <= n && n <= max_plain_exp) {
+    // ddd00.0
+    memcpy(p, digits, length);
+    p += length;
+    memset(p, '0', n - length);
+    p += n - length;
+    *p++ = '.';
+    *p++ = '0';
+  } else if (0 < n && n <= max_plain_exp) {
+    // dd.ddd
+    memcpy(p, digits, n);
+    p += n;
+    *p++ = '.';
+    memcpy(p, digits + n, length - n);
+    p += length - n;
+  } else if (kMinPlainExp < n && n <= 0) {
+    // 0.00ddd
+    *p++ = '0';
+    *p++ = '.';
+    memset(p, '0', -n);
+    p += -n;
+    memcpy(p, digits, length);
+    p += length;
+  } else {
+    // d.dddde+nn
+    *p++ = digits[0];
+    if (length > 1) {
+      *p++ = '.';
+      memcpy(p, digits + 1, length - 1);
+      p += length - 1;
+    }
+    *p++ = 'e';
+    int exp = n - 1;
+    if (exp < 0) {
+      *p++ = '-';
+      exp = -exp;
+    } else {
+      *p++ = '+';
+    }
+    if (exp >= 100) {
+      *p++ = static_cast<char>('0' + exp / 100);
+    }
+    if (exp >= 10) {
+      *p++ = static_cast<char>('0' + (exp / 10) % 10);
+    }
+    *p++ = static_cast<char>('0' + exp % 10);
+  }
+  return p;
+}
+
+// static
+template <typename T>
+void FloatWriter<T>::WriteDecimal(char* out, size_t size, Uint bits) {
+  static constexpr int kBias = Traits::kExpBias + Traits::kSigBits;
+  static constexpr Uint kHiddenBit = Uint(1) << Traits::kSigBits;
+
+  bool is_neg = (bits >> Traits::kSignShift);
+  int biased_exp = (bits >> Traits::kSigBits) & Traits::kExpMask;
+  Uint sig = bits & Traits::kSigMask;
+
+  if (biased_exp == Traits::kExpMask) {
+    // Infinity and nan are written the same way in both formats.
+    WriteHex(out, size, bits);
+    return;
+  }
+
+  char buffer[Traits::kMaxDecimalBufferSize];
+  char* p = buffer;
+  if (is_neg) {
+    *p++ = '-';
+  }
+
+  if (biased_exp == 0 && sig == 0) {
+    strcpy(p, "0.0");
+    p += 3;
+  } else {
+    // Compute the boundaries m- and m+ of the rounding interval of v; every
+    // value strictly between them rounds to v.
+    DiyFp v = biased_exp == 0 ? DiyFp(sig, 1 - kBias)
+                              : DiyFp(sig + kHiddenBit, biased_exp - kBias);
+    bool lower_boundary_is_closer = sig == 0 && biased_exp > 1;
+    DiyFp m_plus(2 * v.f + 1, v.e - 1);
+    DiyFp m_minus = lower_boundary_is_closer ? DiyFp(4 * v.f - 1, v.e - 2)
+                                             : DiyFp(2 * v.f - 1, v.e - 1);
+    m_plus = DiyFp::Normalize(m_plus);
+    m_minus = DiyFp::NormalizeTo(m_minus, m_plus.e);
+    v = DiyFp::Normalize(v);
+
+    // Scale by a cached power of ten so the digits can be generated with
+    // integer arithmetic, then shrink the interval by one unit on each side
+    // to account for the imprecision of the multiplication.
+    CachedPower cached = GetCachedPowerForBinaryExponent(m_plus.e);
+    DiyFp c_minus_k(cached.f, cached.e);
+    DiyFp w = DiyFp::Mul(v, c_minus_k);
+    DiyFp w_minus = DiyFp::Mul(m_minus, c_minus_k);
+    DiyFp w_plus = DiyFp::Mul(m_plus, c_minus_k);
+
+    char digits[32];
+    int length = 0;
+    int decimal_exponent = -cached.k;
+    Grisu2DigitGen(digits, &length, &decimal_exponent,
+                   DiyFp(w_minus.f + 1, w_minus.e), w,
+                   DiyFp(w_plus.f - 1, w_plus.e));
+    p = FormatDecimal(p, digits, length, decimal_exponent,
+                      std::numeric_limits<T>::digits10);
+  }
+
+  size_t len = p - buffer;
+  if (len >= size) {
+    len = size - 1;
+  }
+  memcpy(out, buffer, len);
+  out[len] = '\0';
+}
+
 }  // end anonymous namespace
 
 Result ParseHexdigit(char c, uint32_t* out) {
@@ -791,6 +1180,14 @@ void WriteDoubleHex(char* buffer, size_t size, uint64_t bits) {
   return FloatWriter<double>::WriteHex(buffer, size, bits);
 }
 
+void WriteFloatDecimal(char* buffer, size_t size, uint32_t bits) {
+  return FloatWriter<float>::WriteDecimal(buffer, size, bits);
+}
+
+void WriteDoubleDecimal(char* buffer, size_t size, uint64_t bits) {
+  return FloatWriter<double>::WriteDecimal(buffer, size, bits);
+}
+
 void WriteUint128(char* buffer, size_t size, v128 bits) {
   uint64_t digits;
   uint64_t remainder;
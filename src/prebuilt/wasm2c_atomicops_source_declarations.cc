@@ -8,6 +8,19 @@ R"w2c_template(#error "C11 is required for Wasm threads and shared memory suppor
 R"w2c_template(#endif
 )w2c_template"
 R"w2c_template(
+// memory.grow publishes a shared memory's new size before its new page count,
+)w2c_template"
+R"w2c_template(// so a thread that sees the new page count can access the new pages.
+)w2c_template"
+R"w2c_template(static inline u64 memory_size_shared(wasm_rt_shared_memory_t* mem) {
+)w2c_template"
+R"w2c_template(  return atomic_load_explicit((_Atomic volatile u64*)&mem->pages,
+)w2c_template"
+R"w2c_template(                              memory_order_acquire);
+)w2c_template"
+R"w2c_template(}
+)w2c_template"
+R"w2c_template(
 #define ATOMIC_ALIGNMENT_CHECK(addr, t1) \
 )w2c_template"
 R"w2c_template(  if (UNLIKELY(addr % sizeof(t1))) {     \
@@ -449,6 +462,108 @@ R"w2c_template(DEFINE_ATOMIC_CMP_XCHG(i64_atomic_rmw32_cmpxchg_u, u64, u32);
 R"w2c_template(DEFINE_ATOMIC_CMP_XCHG(i64_atomic_rmw_cmpxchg, u64, u64);
 )w2c_template"
 R"w2c_template(
+#define DEFINE_ATOMIC_WAIT(name, t, wait_func)                               \
+)w2c_template"
+R"w2c_template(  static inline u32 name##_unchecked(wasm_rt_memory_t* mem, u64 addr,       \
+)w2c_template"
+R"w2c_template(                                     t expected, s64 timeout) {             \
+)w2c_template"
+R"w2c_template(    ATOMIC_ALIGNMENT_CHECK(addr, t);                                        \
+)w2c_template"
+R"w2c_template(    t value;                                                                \
+)w2c_template"
+R"w2c_template(    wasm_rt_memcpy(&value, MEM_ADDR(mem, addr, sizeof(t)), sizeof(t));      \
+)w2c_template"
+R"w2c_template(    FORCE_READ_INT(value);                                                  \
+)w2c_template"
+R"w2c_template(    return TRAP(WAIT_UNSHARED);                                             \
+)w2c_template"
+R"w2c_template(  }                                                                         \
+)w2c_template"
+R"w2c_template(  DEF_MEM_CHECKS2(name, _, t, return, u32, t, s64)                          \
+)w2c_template"
+R"w2c_template(  static inline u32 name##_shared_unchecked(wasm_rt_shared_memory_t* mem,   \
+)w2c_template"
+R"w2c_template(                                            u64 addr, t expected,           \
+)w2c_template"
+R"w2c_template(                                            s64 timeout) {                  \
+)w2c_template"
+R"w2c_template(    ATOMIC_ALIGNMENT_CHECK(addr, t);                                        \
+)w2c_template"
+R"w2c_template(    /* Fault here, not while holding the runtime lock. */                   \
+)w2c_template"
+R"w2c_template(    t value = atomic_load_explicit(                                         \
+)w2c_template"
+R"w2c_template(        (_Atomic volatile t*)MEM_ADDR(mem, addr, sizeof(t)),                \
+)w2c_template"
+R"w2c_template(        memory_order_relaxed);                                              \
+)w2c_template"
+R"w2c_template(    FORCE_READ_INT(value);                                                  \
+)w2c_template"
+R"w2c_template(    return wait_func((_Atomic volatile t*)MEM_ADDR(mem, addr, sizeof(t)),   \
+)w2c_template"
+R"w2c_template(                     expected, timeout);                                    \
+)w2c_template"
+R"w2c_template(  }                                                                         \
+)w2c_template"
+R"w2c_template(  DEF_MEM_CHECKS2(name##_shared, _shared_, t, return, u32, t, s64)
+)w2c_template"
+R"w2c_template(
+DEFINE_ATOMIC_WAIT(memory_atomic_wait32, u32, wasm_rt_atomic_wait32)
+)w2c_template"
+R"w2c_template(DEFINE_ATOMIC_WAIT(memory_atomic_wait64, u64, wasm_rt_atomic_wait64)
+)w2c_template"
+R"w2c_template(
+static inline u32 memory_atomic_notify_unchecked(wasm_rt_memory_t* mem,
+)w2c_template"
+R"w2c_template(                                                 u64 addr,
+)w2c_template"
+R"w2c_template(                                                 u32 count) {
+)w2c_template"
+R"w2c_template(  ATOMIC_ALIGNMENT_CHECK(addr, u32);
+)w2c_template"
+R"w2c_template(  u32 value;
+)w2c_template"
+R"w2c_template(  wasm_rt_memcpy(&value, MEM_ADDR(mem, addr, sizeof(u32)), sizeof(u32));
+)w2c_template"
+R"w2c_template(  FORCE_READ_INT(value);
+)w2c_template"
+R"w2c_template(  // Nothing can be waiting on an unshared memory.
+)w2c_template"
+R"w2c_template(  return 0;
+)w2c_template"
+R"w2c_template(}
+)w2c_template"
+R"w2c_template(DEF_MEM_CHECKS1(memory_atomic_notify, _, u32, return, u32, u32)
+)w2c_template"
+R"w2c_template(
+static inline u32 memory_atomic_notify_shared_unchecked(
+)w2c_template"
+R"w2c_template(    wasm_rt_shared_memory_t* mem,
+)w2c_template"
+R"w2c_template(    u64 addr,
+)w2c_template"
+R"w2c_template(    u32 count) {
+)w2c_template"
+R"w2c_template(  ATOMIC_ALIGNMENT_CHECK(addr, u32);
+)w2c_template"
+R"w2c_template(  u32 value = atomic_load_explicit(
+)w2c_template"
+R"w2c_template(      (_Atomic volatile u32*)MEM_ADDR(mem, addr, sizeof(u32)),
+)w2c_template"
+R"w2c_template(      memory_order_relaxed);
+)w2c_template"
+R"w2c_template(  FORCE_READ_INT(value);
+)w2c_template"
+R"w2c_template(  return wasm_rt_atomic_notify((volatile void*)MEM_ADDR(mem, addr, sizeof(u32)),
+)w2c_template"
+R"w2c_template(                               count);
+)w2c_template"
+R"w2c_template(}
+)w2c_template"
+R"w2c_template(DEF_MEM_CHECKS1(memory_atomic_notify_shared, _shared_, u32, return, u32, u32)
+)w2c_template"
+R"w2c_template(
 #define atomic_fence() atomic_thread_fence(memory_order_seq_cst)
 )w2c_template"
 ;
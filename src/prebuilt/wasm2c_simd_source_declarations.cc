@@ -663,6 +663,222 @@ R"w2c_template(#define v128_f64x2_convert_low_u32x4 simde_wasm_f64x2_convert_low
 )w2c_template"
 R"w2c_template(#endif
 )w2c_template"
+R"w2c_template(
+#define v128_i8x16_popcnt simde_wasm_i8x16_popcnt
+)w2c_template"
+R"w2c_template(#define v128_i16x8_q15mulr_sat simde_wasm_i16x8_q15mulr_sat
+)w2c_template"
+R"w2c_template(#define v128_any_true simde_wasm_v128_any_true
+)w2c_template"
+R"w2c_template(#define v128_i8x16_all_true simde_wasm_i8x16_all_true
+)w2c_template"
+R"w2c_template(
+// simde's portable versions of these operations are much slower than the
+)w2c_template"
+R"w2c_template(// x86 SSSE3/SSE4.1 or AArch64 NEON sequences below, so those are used when
+)w2c_template"
+R"w2c_template(// simde has the native types available. Build with -DWASM_RT_SIMD_NATIVE=0 to
+)w2c_template"
+R"w2c_template(// use simde for everything.
+)w2c_template"
+R"w2c_template(#ifndef WASM_RT_SIMD_NATIVE
+)w2c_template"
+R"w2c_template(#define WASM_RT_SIMD_NATIVE 1
+)w2c_template"
+R"w2c_template(#endif
+)w2c_template"
+R"w2c_template(
+#if WASM_RT_SIMD_NATIVE && !WABT_BIG_ENDIAN && defined(SIMDE_X86_SSSE3_NATIVE)
+)w2c_template"
+R"w2c_template(#include <immintrin.h>
+)w2c_template"
+R"w2c_template(static inline v128 v128_impl_i8x16_swizzle(v128 a, v128 b) {
+)w2c_template"
+R"w2c_template(  // pshufb zeroes the lanes whose index has its top bit set. Adding 0x70 with
+)w2c_template"
+R"w2c_template(  // unsigned saturation moves every index above 15 there, and keeps the low
+)w2c_template"
+R"w2c_template(  // four bits of the others.
+)w2c_template"
+R"w2c_template(  return _mm_shuffle_epi8(a, _mm_adds_epu8(b, _mm_set1_epi8(0x70)));
+)w2c_template"
+R"w2c_template(}
+)w2c_template"
+R"w2c_template(static inline v128 v128_impl_i8x16_popcnt(v128 a) {
+)w2c_template"
+R"w2c_template(#if defined(SIMDE_X86_AVX512BITALG_NATIVE) && defined(SIMDE_X86_AVX512VL_NATIVE)
+)w2c_template"
+R"w2c_template(  return _mm_popcnt_epi8(a);
+)w2c_template"
+R"w2c_template(#else
+)w2c_template"
+R"w2c_template(  // Look up the count of each nibble in a 16-entry table.
+)w2c_template"
+R"w2c_template(  const __m128i counts = _mm_setr_epi8(0,1,1,2,1,2,2,3,1,2,2,3,2,3,3,4);
+)w2c_template"
+R"w2c_template(  const __m128i nibble = _mm_set1_epi8(0x0f);
+)w2c_template"
+R"w2c_template(  __m128i lo = _mm_shuffle_epi8(counts, _mm_and_si128(a, nibble));
+)w2c_template"
+R"w2c_template(  __m128i hi = _mm_shuffle_epi8(counts, _mm_and_si128(_mm_srli_epi16(a, 4), nibble));
+)w2c_template"
+R"w2c_template(  return _mm_add_epi8(lo, hi);
+)w2c_template"
+R"w2c_template(#endif
+)w2c_template"
+R"w2c_template(}
+)w2c_template"
+R"w2c_template(static inline v128 v128_impl_i16x8_q15mulr_sat(v128 a, v128 b) {
+)w2c_template"
+R"w2c_template(  // pmulhrsw rounds the same way, but wraps the one overflowing product
+)w2c_template"
+R"w2c_template(  // (-32768 * -32768) to -32768 rather than saturating it to 32767.
+)w2c_template"
+R"w2c_template(  __m128i r = _mm_mulhrs_epi16(a, b);
+)w2c_template"
+R"w2c_template(  return _mm_xor_si128(r, _mm_cmpeq_epi16(r, _mm_set1_epi16(INT16_MIN)));
+)w2c_template"
+R"w2c_template(}
+)w2c_template"
+R"w2c_template(static inline u32 v128_impl_any_true(v128 a) {
+)w2c_template"
+R"w2c_template(#if defined(SIMDE_X86_SSE4_1_NATIVE)
+)w2c_template"
+R"w2c_template(  return !_mm_testz_si128(a, a);
+)w2c_template"
+R"w2c_template(#else
+)w2c_template"
+R"w2c_template(  return _mm_movemask_epi8(_mm_cmpeq_epi8(a, _mm_setzero_si128())) != 0xffff;
+)w2c_template"
+R"w2c_template(#endif
+)w2c_template"
+R"w2c_template(}
+)w2c_template"
+R"w2c_template(static inline u32 v128_impl_i8x16_all_true(v128 a) {
+)w2c_template"
+R"w2c_template(  return _mm_movemask_epi8(_mm_cmpeq_epi8(a, _mm_setzero_si128())) == 0;
+)w2c_template"
+R"w2c_template(}
+)w2c_template"
+R"w2c_template(static inline u32 v128_impl_i8x16_bitmask(v128 a) {
+)w2c_template"
+R"w2c_template(  return (u32)_mm_movemask_epi8(a);
+)w2c_template"
+R"w2c_template(}
+)w2c_template"
+R"w2c_template(#define WASM_RT_SIMD_NATIVE_OPS 1
+)w2c_template"
+R"w2c_template(#elif WASM_RT_SIMD_NATIVE && !WABT_BIG_ENDIAN && defined(SIMDE_ARM_NEON_A64V8_NATIVE)
+)w2c_template"
+R"w2c_template(#include <arm_neon.h>
+)w2c_template"
+R"w2c_template(static inline v128 v128_impl_i8x16_swizzle(v128 a, v128 b) {
+)w2c_template"
+R"w2c_template(  // tbl zeroes the lanes whose index is out of range, as wasm does.
+)w2c_template"
+R"w2c_template(  return vreinterpretq_s32_u8(vqtbl1q_u8(vreinterpretq_u8_s32(a), vreinterpretq_u8_s32(b)));
+)w2c_template"
+R"w2c_template(}
+)w2c_template"
+R"w2c_template(static inline v128 v128_impl_i8x16_popcnt(v128 a) {
+)w2c_template"
+R"w2c_template(  return vreinterpretq_s32_u8(vcntq_u8(vreinterpretq_u8_s32(a)));
+)w2c_template"
+R"w2c_template(}
+)w2c_template"
+R"w2c_template(static inline v128 v128_impl_i16x8_q15mulr_sat(v128 a, v128 b) {
+)w2c_template"
+R"w2c_template(  return vreinterpretq_s32_s16(vqrdmulhq_s16(vreinterpretq_s16_s32(a), vreinterpretq_s16_s32(b)));
+)w2c_template"
+R"w2c_template(}
+)w2c_template"
+R"w2c_template(static inline u32 v128_impl_any_true(v128 a) {
+)w2c_template"
+R"w2c_template(  return vmaxvq_u32(vreinterpretq_u32_s32(a)) != 0;
+)w2c_template"
+R"w2c_template(}
+)w2c_template"
+R"w2c_template(static inline u32 v128_impl_i8x16_all_true(v128 a) {
+)w2c_template"
+R"w2c_template(  return vminvq_u8(vreinterpretq_u8_s32(a)) != 0;
+)w2c_template"
+R"w2c_template(}
+)w2c_template"
+R"w2c_template(static inline u32 v128_impl_i8x16_bitmask(v128 a) {
+)w2c_template"
+R"w2c_template(  // Keep one bit of each lane's sign at the lane's position within its half,
+)w2c_template"
+R"w2c_template(  // then add up each half.
+)w2c_template"
+R"w2c_template(  static const uint8_t weights[16] = {1,2,4,8,16,32,64,128,1,2,4,8,16,32,64,128};
+)w2c_template"
+R"w2c_template(  uint8x16_t signs = vreinterpretq_u8_s8(vshrq_n_s8(vreinterpretq_s8_s32(a), 7));
+)w2c_template"
+R"w2c_template(  uint8x16_t bits = vandq_u8(signs, vld1q_u8(weights));
+)w2c_template"
+R"w2c_template(  return vaddv_u8(vget_low_u8(bits)) | ((u32)vaddv_u8(vget_high_u8(bits)) << 8);
+)w2c_template"
+R"w2c_template(}
+)w2c_template"
+R"w2c_template(#define WASM_RT_SIMD_NATIVE_OPS 1
+)w2c_template"
+R"w2c_template(#endif
+)w2c_template"
+R"w2c_template(
+#if WASM_RT_SIMD_NATIVE_OPS
+)w2c_template"
+R"w2c_template(// Shuffles with constant indices, which the compiler turns into the best
+)w2c_template"
+R"w2c_template(// sequence it has for each pattern (often a single unpack or palignr).
+)w2c_template"
+R"w2c_template(#if defined(__clang__)
+)w2c_template"
+R"w2c_template(typedef u8 v128_impl_u8x16 __attribute__((vector_size(16)));
+)w2c_template"
+R"w2c_template(#define v128_impl_i8x16_shuffle(v1,v2,a,b,c,d,e,f,g,h,i,j,k,l,m,n,o,p) ((v128)__builtin_shufflevector((v128_impl_u8x16)(v1),(v128_impl_u8x16)(v2),a,b,c,d,e,f,g,h,i,j,k,l,m,n,o,p))
+)w2c_template"
+R"w2c_template(#undef v128_i8x16_shuffle
+)w2c_template"
+R"w2c_template(#define v128_i8x16_shuffle v128_impl_i8x16_shuffle
+)w2c_template"
+R"w2c_template(#elif defined(__GNUC__)
+)w2c_template"
+R"w2c_template(typedef u8 v128_impl_u8x16 __attribute__((vector_size(16)));
+)w2c_template"
+R"w2c_template(#define v128_impl_i8x16_shuffle(v1,v2,a,b,c,d,e,f,g,h,i,j,k,l,m,n,o,p) ((v128)__builtin_shuffle((v128_impl_u8x16)(v1),(v128_impl_u8x16)(v2),(v128_impl_u8x16){a,b,c,d,e,f,g,h,i,j,k,l,m,n,o,p}))
+)w2c_template"
+R"w2c_template(#undef v128_i8x16_shuffle
+)w2c_template"
+R"w2c_template(#define v128_i8x16_shuffle v128_impl_i8x16_shuffle
+)w2c_template"
+R"w2c_template(#endif
+)w2c_template"
+R"w2c_template(#undef v128_i8x16_swizzle
+)w2c_template"
+R"w2c_template(#undef v128_i8x16_bitmask
+)w2c_template"
+R"w2c_template(#undef v128_i8x16_popcnt
+)w2c_template"
+R"w2c_template(#undef v128_i16x8_q15mulr_sat
+)w2c_template"
+R"w2c_template(#undef v128_any_true
+)w2c_template"
+R"w2c_template(#undef v128_i8x16_all_true
+)w2c_template"
+R"w2c_template(#define v128_i8x16_swizzle v128_impl_i8x16_swizzle
+)w2c_template"
+R"w2c_template(#define v128_i8x16_bitmask v128_impl_i8x16_bitmask
+)w2c_template"
+R"w2c_template(#define v128_i8x16_popcnt v128_impl_i8x16_popcnt
+)w2c_template"
+R"w2c_template(#define v128_i16x8_q15mulr_sat v128_impl_i16x8_q15mulr_sat
+)w2c_template"
+R"w2c_template(#define v128_any_true v128_impl_any_true
+)w2c_template"
+R"w2c_template(#define v128_i8x16_all_true v128_impl_i8x16_all_true
+)w2c_template"
+R"w2c_template(#endif
+)w2c_template"
 R"w2c_template(// clang-format on
 )w2c_template"
 ;
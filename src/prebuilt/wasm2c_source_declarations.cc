@@ -134,6 +134,21 @@ R"w2c_template(
 R"w2c_template(#endif
 )w2c_template"
 R"w2c_template(
+#if WASM_RT_STACK_POINTER_CHECK
+)w2c_template"
+R"w2c_template(#define FUNC_STACK_CHECK                                       \
+)w2c_template"
+R"w2c_template(  if (UNLIKELY(WASM_RT_STACK_POINTER() < wasm_rt_stack_limit)) \
+)w2c_template"
+R"w2c_template(    TRAP(EXHAUSTION);
+)w2c_template"
+R"w2c_template(#else
+)w2c_template"
+R"w2c_template(#define FUNC_STACK_CHECK
+)w2c_template"
+R"w2c_template(#endif
+)w2c_template"
+R"w2c_template(
 #define UNREACHABLE TRAP(UNREACHABLE)
 )w2c_template"
 R"w2c_template(
@@ -247,7 +262,25 @@ R"w2c_template(    TRAP(OOB);
 R"w2c_template(#endif
 )w2c_template"
 R"w2c_template(
-// MEMCHECK_GENERAL can be used for any memory
+// MEMCHECK_GENERAL can be used for any memory. With guard pages, every
+)w2c_template"
+R"w2c_template(// memory (including memory64) is followed by an inaccessible region at least
+)w2c_template"
+R"w2c_template(// as large as any access, so it suffices to check that the access starts in
+)w2c_template"
+R"w2c_template(// bounds.
+)w2c_template"
+R"w2c_template(#if WASM_RT_MEMCHECK_GUARD_PAGES
+)w2c_template"
+R"w2c_template(#define MEMCHECK_GENERAL(mem, a, t) \
+)w2c_template"
+R"w2c_template(  WASM_RT_CHECK_BASE(mem);          \
+)w2c_template"
+R"w2c_template(  if (UNLIKELY(a >= mem->size))     \
+)w2c_template"
+R"w2c_template(    TRAP(OOB);
+)w2c_template"
+R"w2c_template(#else
 )w2c_template"
 R"w2c_template(#define MEMCHECK_GENERAL(mem, a, t) \
 )w2c_template"
@@ -255,6 +288,8 @@ R"w2c_template(  WASM_RT_CHECK_BASE(mem);          \
 )w2c_template"
 R"w2c_template(  RANGE_CHECK(mem, a, sizeof(t));
 )w2c_template"
+R"w2c_template(#endif
+)w2c_template"
 R"w2c_template(
 #ifdef __GNUC__
 )w2c_template"
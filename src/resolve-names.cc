@@ -33,6 +33,7 @@ class NameResolver : public ExprVisitor::DelegateNop {
   NameResolver(Script* script, Errors* errors);
 
   Result VisitModule(Module* module);
+  Result VisitFuncBody(Module* module, Func* func);
   Result VisitScript(Script* script);
 
   // Implementation of ExprVisitor::DelegateNop.
@@ -649,6 +650,15 @@ void NameResolver::VisitCommand(Command* command) {
   }
 }
 
+Result NameResolver::VisitFuncBody(Module* module, Func* func) {
+  current_module_ = module;
+  current_func_ = func;
+  visitor_.VisitFunc(func);
+  current_func_ = nullptr;
+  current_module_ = nullptr;
+  return result_;
+}
+
 Result NameResolver::VisitScript(Script* script) {
   for (const std::unique_ptr<Command>& command : script->commands)
     VisitCommand(command.get());
@@ -660,6 +670,11 @@ Result ResolveNamesModule(Module* module, Errors* errors) {
   return resolver.VisitModule(module);
 }
 
+Result ResolveNamesFuncBody(Module* module, Func* func, Errors* errors) {
+  NameResolver resolver(nullptr, errors);
+  return resolver.VisitFuncBody(module, func);
+}
+
 Result ResolveNamesScript(Script* script, Errors* errors) {
   NameResolver resolver(script, errors);
   return resolver.VisitScript(script);
@@ -16,10 +16,18 @@
 
 #include "wabt/stream.h"
 
+#include <algorithm>
 #include <cassert>
 #include <cctype>
 #include <cerrno>
 
+#include "wabt/config.h"
+
+#if HAVE_WRITEV
+#include <sys/uio.h>
+#include <unistd.h>
+#endif
+
 #define DUMP_OCTETS_PER_LINE 16
 #define DUMP_OCTETS_PER_GROUP 2
 
@@ -157,6 +165,21 @@ Result OutputBuffer::WriteToFile(std::string_view filename) const {
   return Result::Ok;
 }
 
+Result OutputBuffer::WriteToFileIfChanged(std::string_view filename) const {
+  std::string filename_str(filename);
+  if (FILE* file = fopen(filename_str.c_str(), "rb")) {
+    // Read one byte more than needed, to tell if the file is longer.
+    std::vector<uint8_t> old_data(data.size() + 1);
+    size_t old_size = fread(old_data.data(), 1, old_data.size(), file);
+    fclose(file);
+    if (old_size == data.size() &&
+        std::equal(data.begin(), data.end(), old_data.begin())) {
+      return Result::Ok;
+    }
+  }
+  return WriteToFile(filename);
+}
+
 Result OutputBuffer::WriteToStdout() const {
   if (data.empty()) {
     return Result::Ok;
@@ -237,6 +260,10 @@ FileStream::FileStream(std::string_view filename, Stream* log_stream)
   // TODO(binji): this is pretty cheesy, should come up with a better API.
   if (file_) {
     should_close_ = true;
+    // All data goes through buffer_, so stdio's own buffer would only add a
+    // copy (and would get out of sync with writev on the descriptor).
+    setvbuf(file_, nullptr, _IONBF, 0);
+    buffer_.reserve(kBufferSize);
   } else {
     ERROR("fopen name=\"%s\" failed, errno=%d\n", filename_str.c_str(), errno);
   }
@@ -253,25 +280,62 @@ FileStream& FileStream::operator=(FileStream&& other) {
   file_ = other.file_;
   offset_ = other.offset_;
   should_close_ = other.should_close_;
+  buffer_ = std::move(other.buffer_);
   other.file_ = nullptr;
   other.offset_ = 0;
   other.should_close_ = false;
+  other.buffer_ = std::vector<uint8_t>();
   return *this;
 }
 
 FileStream::~FileStream() {
+  Close();
+}
+
+Result FileStream::Close() {
+  if (!file_) {
+    return result();
+  }
+  Result close_result = FlushBuffer();
   // We don't want to close existing files (stdout/sterr, for example).
   if (should_close_) {
-    fclose(file_);
+    if (fclose(file_) != 0) {
+      ERROR("fclose failed, errno=%d\n", errno);
+      close_result = Result::Error;
+    }
+  } else if (fflush(file_) != 0) {
+    ERROR("fflush failed, errno=%d\n", errno);
+    close_result = Result::Error;
   }
+  file_ = nullptr;
+  should_close_ = false;
+  return close_result | result();
 }
 
 void FileStream::Flush() {
   if (file_) {
+    FlushBuffer();
     fflush(file_);
   }
 }
 
+Result FileStream::WriteFile(const void* data, size_t size) {
+  if (fwrite(data, size, 1, file_) != 1) {
+    ERROR("fwrite size=%" PRIzd " failed, errno=%d\n", size, errno);
+    return Result::Error;
+  }
+  return Result::Ok;
+}
+
+Result FileStream::FlushBuffer() {
+  if (!file_ || buffer_.empty()) {
+    return Result::Ok;
+  }
+  Result result = WriteFile(buffer_.data(), buffer_.size());
+  buffer_.clear();
+  return result;
+}
+
 Result FileStream::WriteDataImpl(size_t at, const void* data, size_t size) {
   if (!file_) {
     return Result::Error;
@@ -280,16 +344,72 @@ Result FileStream::WriteDataImpl(size_t at, const void* data, size_t size) {
     return Result::Ok;
   }
   if (at != offset_) {
+    if (Failed(FlushBuffer())) {
+      return Result::Error;
+    }
     if (fseek(file_, at, SEEK_SET) != 0) {
       ERROR("fseek offset=%" PRIzd " failed, errno=%d\n", size, errno);
       return Result::Error;
     }
     offset_ = at;
   }
-  if (fwrite(data, size, 1, file_) != 1) {
-    ERROR("fwrite size=%" PRIzd " failed, errno=%d\n", size, errno);
-    return Result::Error;
+
+  // Unbuffered stream (wrapping a caller's FILE*).
+  if (buffer_.capacity() == 0) {
+    CHECK_RESULT(WriteFile(data, size));
+    offset_ += size;
+    return Result::Ok;
+  }
+
+  if (buffer_.size() + size <= kBufferSize) {
+    buffer_.insert(buffer_.end(), static_cast<const uint8_t*>(data),
+                   static_cast<const uint8_t*>(data) + size);
+    offset_ += size;
+    return Result::Ok;
+  }
+
+#if HAVE_WRITEV
+  // Write the pending buffer and the new data with one syscall, rather than
+  // copying the new data through the buffer.
+  struct iovec iov[2];
+  iov[0].iov_base = buffer_.data();
+  iov[0].iov_len = buffer_.size();
+  iov[1].iov_base = const_cast<void*>(data);
+  iov[1].iov_len = size;
+  struct iovec* next = iov;
+  int count = 2;
+  while (count > 0) {
+    ssize_t written = writev(fileno(file_), next, count);
+    if (written < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      ERROR("writev size=%" PRIzd " failed, errno=%d\n",
+            buffer_.size() + size, errno);
+      buffer_.clear();
+      return Result::Error;
+    }
+    size_t left = written;
+    while (count > 0 && left >= next->iov_len) {
+      left -= next->iov_len;
+      ++next;
+      --count;
+    }
+    if (count > 0) {
+      next->iov_base = static_cast<uint8_t*>(next->iov_base) + left;
+      next->iov_len -= left;
+    }
+  }
+  buffer_.clear();
+#else
+  CHECK_RESULT(FlushBuffer());
+  if (size >= kBufferSize) {
+    CHECK_RESULT(WriteFile(data, size));
+  } else {
+    buffer_.insert(buffer_.end(), static_cast<const uint8_t*>(data),
+                   static_cast<const uint8_t*>(data) + size);
   }
+#endif
   offset_ += size;
   return Result::Ok;
 }
@@ -71,6 +71,14 @@ static inline void wasm_rt_segue_write_base(void* base) {
 #define FUNC_EPILOGUE
 #endif
 
+#if WASM_RT_STACK_POINTER_CHECK
+#define FUNC_STACK_CHECK                                       \
+  if (UNLIKELY(WASM_RT_STACK_POINTER() < wasm_rt_stack_limit)) \
+    TRAP(EXHAUSTION);
+#else
+#define FUNC_STACK_CHECK
+#endif
+
 #define UNREACHABLE TRAP(UNREACHABLE)
 
 static inline bool func_types_eq(const wasm_rt_func_type_t a,
@@ -132,10 +140,20 @@ static inline bool add_overflow(uint64_t a, uint64_t b, uint64_t* resptr) {
     TRAP(OOB);
 #endif
 
-// MEMCHECK_GENERAL can be used for any memory
+// MEMCHECK_GENERAL can be used for any memory. With guard pages, every
+// memory (including memory64) is followed by an inaccessible region at least
+// as large as any access, so it suffices to check that the access starts in
+// bounds.
+#if WASM_RT_MEMCHECK_GUARD_PAGES
+#define MEMCHECK_GENERAL(mem, a, t) \
+  WASM_RT_CHECK_BASE(mem);          \
+  if (UNLIKELY(a >= mem->size))     \
+    TRAP(OOB);
+#else
 #define MEMCHECK_GENERAL(mem, a, t) \
   WASM_RT_CHECK_BASE(mem);          \
   RANGE_CHECK(mem, a, sizeof(t));
+#endif
 
 #ifdef __GNUC__
 #define FORCE_READ_INT(var) __asm__("" ::"r"(var));
@@ -4,6 +4,13 @@
 #error "C11 is required for Wasm threads and shared memory support"
 #endif
 
+// memory.grow publishes a shared memory's new size before its new page count,
+// so a thread that sees the new page count can access the new pages.
+static inline u64 memory_size_shared(wasm_rt_shared_memory_t* mem) {
+  return atomic_load_explicit((_Atomic volatile u64*)&mem->pages,
+                              memory_order_acquire);
+}
+
 #define ATOMIC_ALIGNMENT_CHECK(addr, t1) \
   if (UNLIKELY(addr % sizeof(t1))) {     \
     TRAP(UNALIGNED);                     \
@@ -234,4 +241,57 @@ DEFINE_ATOMIC_CMP_XCHG(i64_atomic_rmw16_cmpxchg_u, u64, u16);
 DEFINE_ATOMIC_CMP_XCHG(i64_atomic_rmw32_cmpxchg_u, u64, u32);
 DEFINE_ATOMIC_CMP_XCHG(i64_atomic_rmw_cmpxchg, u64, u64);
 
+#define DEFINE_ATOMIC_WAIT(name, t, wait_func)                               \
+  static inline u32 name##_unchecked(wasm_rt_memory_t* mem, u64 addr,       \
+                                     t expected, s64 timeout) {             \
+    ATOMIC_ALIGNMENT_CHECK(addr, t);                                        \
+    t value;                                                                \
+    wasm_rt_memcpy(&value, MEM_ADDR(mem, addr, sizeof(t)), sizeof(t));      \
+    FORCE_READ_INT(value);                                                  \
+    return TRAP(WAIT_UNSHARED);                                             \
+  }                                                                         \
+  DEF_MEM_CHECKS2(name, _, t, return, u32, t, s64)                          \
+  static inline u32 name##_shared_unchecked(wasm_rt_shared_memory_t* mem,   \
+                                            u64 addr, t expected,           \
+                                            s64 timeout) {                  \
+    ATOMIC_ALIGNMENT_CHECK(addr, t);                                        \
+    /* Fault here, not while holding the runtime lock. */                   \
+    t value = atomic_load_explicit(                                         \
+        (_Atomic volatile t*)MEM_ADDR(mem, addr, sizeof(t)),                \
+        memory_order_relaxed);                                              \
+    FORCE_READ_INT(value);                                                  \
+    return wait_func((_Atomic volatile t*)MEM_ADDR(mem, addr, sizeof(t)),   \
+                     expected, timeout);                                    \
+  }                                                                         \
+  DEF_MEM_CHECKS2(name##_shared, _shared_, t, return, u32, t, s64)
+
+DEFINE_ATOMIC_WAIT(memory_atomic_wait32, u32, wasm_rt_atomic_wait32)
+DEFINE_ATOMIC_WAIT(memory_atomic_wait64, u64, wasm_rt_atomic_wait64)
+
+static inline u32 memory_atomic_notify_unchecked(wasm_rt_memory_t* mem,
+                                                 u64 addr,
+                                                 u32 count) {
+  ATOMIC_ALIGNMENT_CHECK(addr, u32);
+  u32 value;
+  wasm_rt_memcpy(&value, MEM_ADDR(mem, addr, sizeof(u32)), sizeof(u32));
+  FORCE_READ_INT(value);
+  // Nothing can be waiting on an unshared memory.
+  return 0;
+}
+DEF_MEM_CHECKS1(memory_atomic_notify, _, u32, return, u32, u32)
+
+static inline u32 memory_atomic_notify_shared_unchecked(
+    wasm_rt_shared_memory_t* mem,
+    u64 addr,
+    u32 count) {
+  ATOMIC_ALIGNMENT_CHECK(addr, u32);
+  u32 value = atomic_load_explicit(
+      (_Atomic volatile u32*)MEM_ADDR(mem, addr, sizeof(u32)),
+      memory_order_relaxed);
+  FORCE_READ_INT(value);
+  return wasm_rt_atomic_notify((volatile void*)MEM_ADDR(mem, addr, sizeof(u32)),
+                               count);
+}
+DEF_MEM_CHECKS1(memory_atomic_notify_shared, _shared_, u32, return, u32, u32)
+
 #define atomic_fence() atomic_thread_fence(memory_order_seq_cst)
@@ -337,4 +337,114 @@ DEFINE_SIMD_STORE_LANE(v128_store64_lane1, simde_wasm_v128_store64_lane, u64, 1)
 #define v128_f64x2_convert_low_i32x4 simde_wasm_f64x2_convert_low_i32x4
 #define v128_f64x2_convert_low_u32x4 simde_wasm_f64x2_convert_low_u32x4
 #endif
+
+#define v128_i8x16_popcnt simde_wasm_i8x16_popcnt
+#define v128_i16x8_q15mulr_sat simde_wasm_i16x8_q15mulr_sat
+#define v128_any_true simde_wasm_v128_any_true
+#define v128_i8x16_all_true simde_wasm_i8x16_all_true
+
+// simde's portable versions of these operations are much slower than the
+// x86 SSSE3/SSE4.1 or AArch64 NEON sequences below, so those are used when
+// simde has the native types available. Build with -DWASM_RT_SIMD_NATIVE=0 to
+// use simde for everything.
+#ifndef WASM_RT_SIMD_NATIVE
+#define WASM_RT_SIMD_NATIVE 1
+#endif
+
+#if WASM_RT_SIMD_NATIVE && !WABT_BIG_ENDIAN && defined(SIMDE_X86_SSSE3_NATIVE)
+#include <immintrin.h>
+static inline v128 v128_impl_i8x16_swizzle(v128 a, v128 b) {
+  // pshufb zeroes the lanes whose index has its top bit set. Adding 0x70 with
+  // unsigned saturation moves every index above 15 there, and keeps the low
+  // four bits of the others.
+  return _mm_shuffle_epi8(a, _mm_adds_epu8(b, _mm_set1_epi8(0x70)));
+}
+static inline v128 v128_impl_i8x16_popcnt(v128 a) {
+#if defined(SIMDE_X86_AVX512BITALG_NATIVE) && defined(SIMDE_X86_AVX512VL_NATIVE)
+  return _mm_popcnt_epi8(a);
+#else
+  // Look up the count of each nibble in a 16-entry table.
+  const __m128i counts = _mm_setr_epi8(0,1,1,2,1,2,2,3,1,2,2,3,2,3,3,4);
+  const __m128i nibble = _mm_set1_epi8(0x0f);
+  __m128i lo = _mm_shuffle_epi8(counts, _mm_and_si128(a, nibble));
+  __m128i hi = _mm_shuffle_epi8(counts, _mm_and_si128(_mm_srli_epi16(a, 4), nibble));
+  return _mm_add_epi8(lo, hi);
+#endif
+}
+static inline v128 v128_impl_i16x8_q15mulr_sat(v128 a, v128 b) {
+  // pmulhrsw rounds the same way, but wraps the one overflowing product
+  // (-32768 * -32768) to -32768 rather than saturating it to 32767.
+  __m128i r = _mm_mulhrs_epi16(a, b);
+  return _mm_xor_si128(r, _mm_cmpeq_epi16(r, _mm_set1_epi16(INT16_MIN)));
+}
+static inline u32 v128_impl_any_true(v128 a) {
+#if defined(SIMDE_X86_SSE4_1_NATIVE)
+  return !_mm_testz_si128(a, a);
+#else
+  return _mm_movemask_epi8(_mm_cmpeq_epi8(a, _mm_setzero_si128())) != 0xffff;
+#endif
+}
+static inline u32 v128_impl_i8x16_all_true(v128 a) {
+  return _mm_movemask_epi8(_mm_cmpeq_epi8(a, _mm_setzero_si128())) == 0;
+}
+static inline u32 v128_impl_i8x16_bitmask(v128 a) {
+  return (u32)_mm_movemask_epi8(a);
+}
+#define WASM_RT_SIMD_NATIVE_OPS 1
+#elif WASM_RT_SIMD_NATIVE && !WABT_BIG_ENDIAN && defined(SIMDE_ARM_NEON_A64V8_NATIVE)
+#include <arm_neon.h>
+static inline v128 v128_impl_i8x16_swizzle(v128 a, v128 b) {
+  // tbl zeroes the lanes whose index is out of range, as wasm does.
+  return vreinterpretq_s32_u8(vqtbl1q_u8(vreinterpretq_u8_s32(a), vreinterpretq_u8_s32(b)));
+}
+static inline v128 v128_impl_i8x16_popcnt(v128 a) {
+  return vreinterpretq_s32_u8(vcntq_u8(vreinterpretq_u8_s32(a)));
+}
+static inline v128 v128_impl_i16x8_q15mulr_sat(v128 a, v128 b) {
+  return vreinterpretq_s32_s16(vqrdmulhq_s16(vreinterpretq_s16_s32(a), vreinterpretq_s16_s32(b)));
+}
+static inline u32 v128_impl_any_true(v128 a) {
+  return vmaxvq_u32(vreinterpretq_u32_s32(a)) != 0;
+}
+static inline u32 v128_impl_i8x16_all_true(v128 a) {
+  return vminvq_u8(vreinterpretq_u8_s32(a)) != 0;
+}
+static inline u32 v128_impl_i8x16_bitmask(v128 a) {
+  // Keep one bit of each lane's sign at the lane's position within its half,
+  // then add up each half.
+  static const uint8_t weights[16] = {1,2,4,8,16,32,64,128,1,2,4,8,16,32,64,128};
+  uint8x16_t signs = vreinterpretq_u8_s8(vshrq_n_s8(vreinterpretq_s8_s32(a), 7));
+  uint8x16_t bits = vandq_u8(signs, vld1q_u8(weights));
+  return vaddv_u8(vget_low_u8(bits)) | ((u32)vaddv_u8(vget_high_u8(bits)) << 8);
+}
+#define WASM_RT_SIMD_NATIVE_OPS 1
+#endif
+
+#if WASM_RT_SIMD_NATIVE_OPS
+// Shuffles with constant indices, which the compiler turns into the best
+// sequence it has for each pattern (often a single unpack or palignr).
+#if defined(__clang__)
+typedef u8 v128_impl_u8x16 __attribute__((vector_size(16)));
+#define v128_impl_i8x16_shuffle(v1,v2,a,b,c,d,e,f,g,h,i,j,k,l,m,n,o,p) ((v128)__builtin_shufflevector((v128_impl_u8x16)(v1),(v128_impl_u8x16)(v2),a,b,c,d,e,f,g,h,i,j,k,l,m,n,o,p))
+#undef v128_i8x16_shuffle
+#define v128_i8x16_shuffle v128_impl_i8x16_shuffle
+#elif defined(__GNUC__)
+typedef u8 v128_impl_u8x16 __attribute__((vector_size(16)));
+#define v128_impl_i8x16_shuffle(v1,v2,a,b,c,d,e,f,g,h,i,j,k,l,m,n,o,p) ((v128)__builtin_shuffle((v128_impl_u8x16)(v1),(v128_impl_u8x16)(v2),(v128_impl_u8x16){a,b,c,d,e,f,g,h,i,j,k,l,m,n,o,p}))
+#undef v128_i8x16_shuffle
+#define v128_i8x16_shuffle v128_impl_i8x16_shuffle
+#endif
+#undef v128_i8x16_swizzle
+#undef v128_i8x16_bitmask
+#undef v128_i8x16_popcnt
+#undef v128_i16x8_q15mulr_sat
+#undef v128_any_true
+#undef v128_i8x16_all_true
+#define v128_i8x16_swizzle v128_impl_i8x16_swizzle
+#define v128_i8x16_bitmask v128_impl_i8x16_bitmask
+#define v128_i8x16_popcnt v128_impl_i8x16_popcnt
+#define v128_i16x8_q15mulr_sat v128_impl_i16x8_q15mulr_sat
+#define v128_any_true v128_impl_any_true
+#define v128_i8x16_all_true v128_impl_i8x16_all_true
+#endif
 // clang-format on
@@ -176,6 +176,31 @@ TEST_F(AllFloatsRoundtripTest, Run) {
   RunThreads();
 }
 
+class AllFloatsDecimalRoundtripTest : public ThreadedTest {
+ protected:
+  virtual void RunShard(int shard) {
+    char buffer[100];
+    FOREACH_UINT32(bits) {
+      LOG_COMPLETION(bits);
+      if (is_infinity_or_nan(bits))
+        continue;
+
+      WriteFloatDecimal(buffer, sizeof(buffer), bits);
+      int len = strlen(buffer);
+
+      uint32_t new_bits;
+      ASSERT_EQ(Result::Ok, ParseFloat(LiteralType::Float, buffer,
+                                       buffer + len, &new_bits));
+      ASSERT_EQ(new_bits, bits);
+    }
+    LOG_DONE();
+  }
+};
+
+TEST_F(AllFloatsDecimalRoundtripTest, Run) {
+  RunThreads();
+}
+
 /* doubles */
 class ManyDoublesParseTest : public ThreadedTest {
  protected:
@@ -262,3 +287,29 @@ class ManyDoublesRoundtripTest : public ThreadedTest {
 TEST_F(ManyDoublesRoundtripTest, Run) {
   RunThreads();
 }
+
+class ManyDoublesDecimalRoundtripTest : public ThreadedTest {
+ protected:
+  virtual void RunShard(int shard) {
+    char buffer[100];
+    FOREACH_UINT32(halfbits) {
+      LOG_COMPLETION(halfbits);
+      uint64_t bits = (static_cast<uint64_t>(halfbits) << 32) | halfbits;
+      if (is_infinity_or_nan(bits))
+        continue;
+
+      WriteDoubleDecimal(buffer, sizeof(buffer), bits);
+      int len = strlen(buffer);
+
+      uint64_t new_bits;
+      ASSERT_EQ(Result::Ok, ParseDouble(LiteralType::Float, buffer,
+                                        buffer + len, &new_bits));
+      ASSERT_EQ(new_bits, bits);
+    }
+    LOG_DONE();
+  }
+};
+
+TEST_F(ManyDoublesDecimalRoundtripTest, Run) {
+  RunThreads();
+}
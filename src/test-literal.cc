@@ -798,6 +798,61 @@ TEST(ParseDouble, RoundingSpec) {
   }
 }
 
+void AssertWriteFloatDecimalEquals(uint32_t bits, const char* expected) {
+  char buffer[WABT_MAX_FLOAT_DECIMAL];
+  WriteFloatDecimal(buffer, sizeof(buffer), bits);
+  ASSERT_STREQ(expected, buffer);
+}
+
+void AssertWriteDoubleDecimalEquals(uint64_t bits, const char* expected) {
+  char buffer[WABT_MAX_DOUBLE_DECIMAL];
+  WriteDoubleDecimal(buffer, sizeof(buffer), bits);
+  ASSERT_STREQ(expected, buffer);
+}
+
+TEST(WriteFloatDecimal, Basic) {
+  AssertWriteFloatDecimalEquals(0x00000000, "0.0");
+  AssertWriteFloatDecimalEquals(0x80000000, "-0.0");
+  AssertWriteFloatDecimalEquals(0x3f800000, "1.0");
+  AssertWriteFloatDecimalEquals(0xbf800000, "-1.0");
+  AssertWriteFloatDecimalEquals(0x3dcccccd, "0.1");
+  AssertWriteFloatDecimalEquals(0x42c80000, "100.0");
+  AssertWriteFloatDecimalEquals(0x3fc00000, "1.5");
+  AssertWriteFloatDecimalEquals(0x38d1b717, "0.0001");
+  AssertWriteFloatDecimalEquals(0x3727c5ac, "1e-5");
+  AssertWriteFloatDecimalEquals(0x4e6e6b28, "1e+9");
+  AssertWriteFloatDecimalEquals(0x00000001, "1e-45");
+  AssertWriteFloatDecimalEquals(0x7f7fffff, "3.4028235e+38");
+}
+
+TEST(WriteFloatDecimal, NanAndInfinity) {
+  AssertWriteFloatDecimalEquals(0x7f800000, "inf");
+  AssertWriteFloatDecimalEquals(0xff800000, "-inf");
+  AssertWriteFloatDecimalEquals(0x7fc00000, "nan");
+  AssertWriteFloatDecimalEquals(0xffa00001, "-nan:0x200001");
+}
+
+TEST(WriteDoubleDecimal, Basic) {
+  AssertWriteDoubleDecimalEquals(0x0000000000000000ull, "0.0");
+  AssertWriteDoubleDecimalEquals(0x8000000000000000ull, "-0.0");
+  AssertWriteDoubleDecimalEquals(0x3ff0000000000000ull, "1.0");
+  AssertWriteDoubleDecimalEquals(0x3fb999999999999aull, "0.1");
+  AssertWriteDoubleDecimalEquals(0x3fd5555555555555ull, "0.3333333333333333");
+  AssertWriteDoubleDecimalEquals(0x400921fb54442d18ull, "3.141592653589793");
+  AssertWriteDoubleDecimalEquals(0x4341c37937e08000ull, "1e+16");
+  AssertWriteDoubleDecimalEquals(0x3eb0c6f7a0b5ed8dull, "1e-6");
+  AssertWriteDoubleDecimalEquals(0x0000000000000001ull, "5e-324");
+  AssertWriteDoubleDecimalEquals(0x7fefffffffffffffull,
+                                 "1.7976931348623157e+308");
+}
+
+TEST(WriteDoubleDecimal, NanAndInfinity) {
+  AssertWriteDoubleDecimalEquals(0x7ff0000000000000ull, "inf");
+  AssertWriteDoubleDecimalEquals(0xfff0000000000000ull, "-inf");
+  AssertWriteDoubleDecimalEquals(0x7ff8000000000000ull, "nan");
+  AssertWriteDoubleDecimalEquals(0x7ff0000000000001ull, "nan:0x1");
+}
+
 void AssertWriteUint128Equals(const v128& value, const std::string& expected) {
   assert(expected.length() < 128);
   char buffer[128];
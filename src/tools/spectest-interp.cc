@@ -15,13 +15,17 @@
  */
 
 #include <algorithm>
+#include <atomic>
 #include <cassert>
 #include <cinttypes>
 #include <cstdio>
 #include <cstdlib>
+#include <deque>
+#include <functional>
 #include <map>
 #include <memory>
 #include <string>
+#include <thread>
 #include <vector>
 
 #include "wabt/binary-reader-ir.h"
@@ -36,6 +40,7 @@
 #include "wabt/interp/interp.h"
 #include "wabt/literal.h"
 #include "wabt/option-parser.h"
+#include "wabt/sha256.h"
 #include "wabt/stream.h"
 #include "wabt/string-util.h"
 #include "wabt/validator.h"
@@ -50,6 +55,7 @@ static std::string s_infile;
 static Thread::Options s_thread_options;
 static Stream* s_trace_stream;
 static Features s_features;
+static int s_jobs = 1;
 
 static std::unique_ptr<FileStream> s_log_stream;
 static std::unique_ptr<FileStream> s_stdout_stream;
@@ -89,6 +95,9 @@ static void ParseOptions(int argc, char** argv) {
                    });
   parser.AddOption('t', "trace", "Trace execution",
                    []() { s_trace_stream = s_stdout_stream.get(); });
+  parser.AddOption('j', "jobs", "N",
+                   "Read and check the script's modules on N threads",
+                   [](const char* argument) { s_jobs = atoi(argument); });
 
   parser.AddArgument("filename", OptionParser::ArgumentCount::One,
                      [](const char* argument) {
@@ -276,13 +285,9 @@ TypedValue GetLane(const TypedValue& tv, Type lane_type, int lane) {
   return result;
 }
 
-bool CheckIR(const std::string& filename, bool validate) {
-  std::vector<uint8_t> file_data;
-
-  if (Failed(ReadFile(filename, &file_data))) {
-    return false;
-  }
-
+bool CheckIR(const std::string& filename,
+             const std::vector<uint8_t>& file_data,
+             bool validate) {
   const bool kReadDebugNames = true;
   const bool kStopOnFirstError = true;
   const bool kFailOnCustomSectionError = true;
@@ -304,14 +309,6 @@ bool CheckIR(const std::string& filename, bool validate) {
       ValidateModule(&module, &errors, ValidateOptions{s_features}));
 }
 
-bool WellformedIR(const std::string& filename) {
-  return CheckIR(filename, false);
-}
-
-bool ValidIR(const std::string& filename) {
-  return CheckIR(filename, true);
-}
-
 class AssertReturnCommand : public CommandMixin<CommandType::AssertReturn> {
  public:
   Action action;
@@ -1204,6 +1201,45 @@ struct ActionResult {
   Trap::Ptr trap;
 };
 
+// What is known about the contents of a binary module file. None of it
+// depends on the store, so it is found for all of a script's module files
+// before its commands are run. Files with the same contents share one
+// BinaryModuleInfo.
+struct BinaryModuleInfo {
+  enum Check {
+    Interp = 1 << 0,
+    Malformed = 1 << 1,
+    WellformedIR = 1 << 2,
+    ValidIR = 1 << 3,
+  };
+
+  unsigned checks = 0;
+  std::string filename;  // The first file with these contents.
+  bool read_file = false;
+  std::vector<uint8_t> file_data;
+
+  wabt::Result interp_result = wabt::Result::Error;
+  Errors interp_errors;
+  ModuleDesc module_desc;
+  interp::Module::Ptr module;  // Created from |module_desc| when first used.
+
+  wabt::Result malformed_result = wabt::Result::Error;
+  Errors malformed_errors;
+
+  bool wellformed_ir = false;
+  bool valid_ir = false;
+};
+
+// The result of reading a text module file, kept until the errors can be
+// printed in order.
+struct TextModuleInfo {
+  bool validate = false;
+  std::vector<uint8_t> file_data;
+  std::unique_ptr<WastLexer> lexer;
+  wabt::Result result = wabt::Result::Error;
+  Errors errors;
+};
+
 class CommandRunner {
  public:
   CommandRunner();
@@ -1218,6 +1254,10 @@ class CommandRunner {
 
   void WABT_PRINTF_FORMAT(3, 4)
       PrintError(uint32_t line_number, const char* format, ...);
+  void ReadModuleFiles(const Script& script);
+  bool WellformedIR(std::string_view module_filename);
+  bool ValidIR(std::string_view module_filename);
+
   ActionResult RunAction(int line_number,
                          const Action* action,
                          RunVerbosity verbose);
@@ -1250,10 +1290,7 @@ class CommandRunner {
   void TallyCommand(wabt::Result);
 
   wabt::Result ReadTextModule(std::string_view module_filename,
-                              const std::string& header,
-                              bool validate);
-  wabt::Result ReadMalformedBinaryModule(std::string_view module_filename,
-                                         Errors* errors);
+                              const std::string& header);
   wabt::Result ReadMalformedModule(int line_number,
                                    std::string_view module_filename,
                                    ModuleType module_type,
@@ -1271,6 +1308,9 @@ class CommandRunner {
   Registry registry_;   // Used when importing.
   Registry instances_;  // Used when referencing module by name in invoke.
   ExportMap last_instance_;
+  std::deque<BinaryModuleInfo> binary_infos_;
+  std::map<std::string, BinaryModuleInfo*, std::less<>> binary_modules_;
+  std::map<std::string, TextModuleInfo, std::less<>> text_modules_;
   int passed_ = 0;
   int total_ = 0;
 
@@ -1332,6 +1372,7 @@ CommandRunner::CommandRunner() : store_(s_features) {
 
 wabt::Result CommandRunner::Run(const Script& script) {
   source_filename_ = script.filename;
+  ReadModuleFiles(script);
 
   for (const CommandPtr& command : script.commands) {
     switch (command->type) {
@@ -1444,56 +1485,252 @@ ActionResult CommandRunner::RunAction(int line_number,
   return result;
 }
 
-wabt::Result CommandRunner::ReadTextModule(std::string_view module_filename,
-                                           const std::string& header,
-                                           bool validate) {
-  std::vector<uint8_t> file_data;
-  wabt::Result result = ReadFile(module_filename, &file_data);
-  Errors errors;
-  std::unique_ptr<WastLexer> lexer = WastLexer::CreateBufferLexer(
-      module_filename, file_data.data(), file_data.size(), &errors);
+static wabt::Result ReadMalformedBinaryModule(
+    const std::vector<uint8_t>& file_data,
+    Errors* errors) {
+  const bool kReadDebugNames = true;
+  const bool kStopOnFirstError = true;
+  const bool kFailOnCustomSectionError = true;
+  ReadBinaryOptions options(s_features, s_log_stream.get(), kReadDebugNames,
+                            kStopOnFirstError, kFailOnCustomSectionError);
+
+  class BinaryReaderErrorLogging : public BinaryReaderNop {
+    Errors* errors_;
+
+   public:
+    BinaryReaderErrorLogging(Errors* errors) : errors_(errors) {}
+
+    bool OnError(const Error& error) override {
+      errors_->push_back(error);
+      return true;
+    }
+  };
+
+  BinaryReaderErrorLogging reader_delegate{errors};
+  return ReadBinary(file_data.data(), file_data.size(), &reader_delegate,
+                    options);
+}
+
+static void CheckBinaryModule(BinaryModuleInfo* info) {
+  const bool kReadDebugNames = true;
+  const bool kStopOnFirstError = true;
+  const bool kFailOnCustomSectionError = true;
+  ReadBinaryOptions options(s_features, s_log_stream.get(), kReadDebugNames,
+                            kStopOnFirstError, kFailOnCustomSectionError);
+
+  if (info->checks & BinaryModuleInfo::Interp) {
+    info->interp_result = ReadBinaryInterp(
+        info->filename, info->file_data.data(), info->file_data.size(),
+        options, &info->interp_errors, &info->module_desc);
+  }
+  if (info->checks & BinaryModuleInfo::Malformed) {
+    info->malformed_result =
+        ReadMalformedBinaryModule(info->file_data, &info->malformed_errors);
+  }
+  if (info->checks & BinaryModuleInfo::WellformedIR) {
+    info->wellformed_ir = CheckIR(info->filename, info->file_data, false);
+  }
+  if (info->checks & BinaryModuleInfo::ValidIR) {
+    info->valid_ir = CheckIR(info->filename, info->file_data, true);
+  }
+}
+
+static void ReadTextModuleFile(std::string_view module_filename,
+                               TextModuleInfo* info) {
+  wabt::Result result = ReadFile(module_filename, &info->file_data);
+  info->lexer =
+      WastLexer::CreateBufferLexer(module_filename, info->file_data.data(),
+                                   info->file_data.size(), &info->errors);
   if (Succeeded(result)) {
     std::unique_ptr<wabt::Module> module;
     WastParseOptions options(s_features);
-    result = ParseWatModule(lexer.get(), &module, &errors, &options);
+    result = ParseWatModule(info->lexer.get(), &module, &info->errors,
+                            &options);
 
-    if (validate && Succeeded(result)) {
-      result =
-          ValidateModule(module.get(), &errors, ValidateOptions{s_features});
+    if (info->validate && Succeeded(result)) {
+      result = ValidateModule(module.get(), &info->errors,
+                              ValidateOptions{s_features});
     }
   }
+  info->result = result;
+}
+
+// Runs |tasks| on up to |num_threads| threads.
+static void RunTasks(const std::vector<std::function<void()>>& tasks,
+                     int num_threads) {
+  std::atomic<size_t> next_task{0};
+  auto run = [&]() {
+    for (size_t i; (i = next_task++) < tasks.size();) {
+      tasks[i]();
+    }
+  };
+
+  num_threads = std::min<size_t>(num_threads, tasks.size());
+  if (num_threads <= 1) {
+    run();
+    return;
+  }
+
+  std::vector<std::thread> threads;
+  for (int i = 0; i < num_threads; ++i) {
+    threads.emplace_back(run);
+  }
+  for (std::thread& thread : threads) {
+    thread.join();
+  }
+}
 
-  auto line_finder = lexer->MakeLineFinder();
-  FormatErrorsToFile(errors, Location::Type::Text, line_finder.get(), stdout,
-                     header, PrintHeader::Once);
+// Reads and checks every module file used by |script|, on s_jobs threads.
+// The results are used as the commands are run, so the output is the same
+// as if each file were read by its command.
+void CommandRunner::ReadModuleFiles(const Script& script) {
+  std::map<std::string, unsigned> binary_checks;
+  auto add_text = [&](const std::string& filename, bool validate) {
+    text_modules_[filename].validate = validate;
+  };
+
+  for (const CommandPtr& command : script.commands) {
+    switch (command->type) {
+      case CommandType::Module:
+      case CommandType::ScriptModule:
+        binary_checks[cast<ModuleCommand>(command.get())->filename] |=
+            BinaryModuleInfo::Interp | BinaryModuleInfo::ValidIR;
+        break;
+
+      case CommandType::AssertMalformed: {
+        auto* assert_command = cast<AssertMalformedCommand>(command.get());
+        unsigned& checks = binary_checks[assert_command->filename];
+        if (assert_command->type == ModuleType::Text) {
+          add_text(assert_command->filename, false);
+        } else {
+          checks |= BinaryModuleInfo::Malformed;
+        }
+        checks |= BinaryModuleInfo::WellformedIR;
+        break;
+      }
+
+      case CommandType::AssertInvalid: {
+        auto* assert_command = cast<AssertInvalidCommand>(command.get());
+        unsigned& checks = binary_checks[assert_command->filename];
+        if (assert_command->type == ModuleType::Text) {
+          add_text(assert_command->filename, true);
+        } else {
+          checks |= BinaryModuleInfo::Interp;
+        }
+        checks |= BinaryModuleInfo::ValidIR;
+        break;
+      }
+
+      case CommandType::AssertUnlinkable:
+        binary_checks[cast<AssertUnlinkableCommand>(command.get())->filename] |=
+            BinaryModuleInfo::Interp | BinaryModuleInfo::ValidIR;
+        break;
+
+      case CommandType::AssertUninstantiable:
+        binary_checks[cast<AssertUninstantiableCommand>(command.get())
+                          ->filename] |=
+            BinaryModuleInfo::Interp | BinaryModuleInfo::ValidIR;
+        break;
+
+      default:
+        break;
+    }
+  }
+
+  // Files are keyed by the hash of their contents, so that modules that are
+  // used more than once are only read, checked and created once.
+  std::map<std::string, BinaryModuleInfo*> infos_by_hash;
+  for (auto& [filename, checks] : binary_checks) {
+    std::vector<uint8_t> file_data;
+    BinaryModuleInfo* info;
+    if (Succeeded(ReadFile(filename, &file_data))) {
+      std::string hash;
+      sha256({reinterpret_cast<const char*>(file_data.data()),
+              file_data.size()},
+             hash);
+      BinaryModuleInfo*& hash_info = infos_by_hash[hash];
+      if (!hash_info) {
+        hash_info = &binary_infos_.emplace_back();
+        hash_info->filename = filename;
+        hash_info->read_file = true;
+        hash_info->file_data = std::move(file_data);
+      }
+      info = hash_info;
+    } else {
+      info = &binary_infos_.emplace_back();
+      info->filename = filename;
+    }
+    info->checks |= checks;
+    binary_modules_[filename] = info;
+  }
+
+  std::vector<std::function<void()>> tasks;
+  for (BinaryModuleInfo& info : binary_infos_) {
+    if (info.read_file) {
+      tasks.push_back([info = &info]() { CheckBinaryModule(info); });
+    }
+  }
+  for (auto& [filename, info] : text_modules_) {
+    tasks.push_back([filename = std::string_view(filename), info = &info]() {
+      ReadTextModuleFile(filename, info);
+    });
+  }
+
+  // The log stream isn't shared between threads.
+  RunTasks(tasks, s_log_stream ? 1 : s_jobs);
+}
+
+// Returns |errors| as if they were found reading |module_filename|, since
+// they may have been found in another file with the same contents.
+static Errors ErrorsForFile(const Errors& errors,
+                            std::string_view module_filename) {
+  Errors result = errors;
+  for (Error& error : result) {
+    if (!error.loc.filename.empty()) {
+      error.loc.filename = module_filename;
+    }
+  }
   return result;
 }
 
+bool CommandRunner::WellformedIR(std::string_view module_filename) {
+  return binary_modules_.find(module_filename)->second->wellformed_ir;
+}
+
+bool CommandRunner::ValidIR(std::string_view module_filename) {
+  return binary_modules_.find(module_filename)->second->valid_ir;
+}
+
+wabt::Result CommandRunner::ReadTextModule(std::string_view module_filename,
+                                           const std::string& header) {
+  TextModuleInfo& info = text_modules_.find(module_filename)->second;
+  auto line_finder = info.lexer->MakeLineFinder();
+  FormatErrorsToFile(info.errors, Location::Type::Text, line_finder.get(),
+                     stdout, header, PrintHeader::Once);
+  return info.result;
+}
+
 interp::Module::Ptr CommandRunner::ReadModule(std::string_view module_filename,
                                               Errors* errors) {
-  std::vector<uint8_t> file_data;
-
-  if (Failed(ReadFile(module_filename, &file_data))) {
+  BinaryModuleInfo* info = binary_modules_.find(module_filename)->second;
+  if (!info->read_file) {
     return {};
   }
 
-  const bool kReadDebugNames = true;
-  const bool kStopOnFirstError = true;
-  const bool kFailOnCustomSectionError = true;
-  ReadBinaryOptions options(s_features, s_log_stream.get(), kReadDebugNames,
-                            kStopOnFirstError, kFailOnCustomSectionError);
-  ModuleDesc module_desc;
-  if (Failed(ReadBinaryInterp(module_filename, file_data.data(),
-                              file_data.size(), options, errors,
-                              &module_desc))) {
+  if (Failed(info->interp_result)) {
+    *errors = ErrorsForFile(info->interp_errors, module_filename);
     return {};
   }
 
+  if (!info->module) {
+    info->module = interp::Module::New(store_, std::move(info->module_desc));
+  }
+
   if (s_verbose) {
-    module_desc.istream.Disassemble(s_stdout_stream.get());
+    info->module->desc().istream.Disassemble(s_stdout_stream.get());
   }
 
-  return interp::Module::New(store_, module_desc);
+  return info->module;
 }
 
 wabt::Result CommandRunner::ReadInvalidModule(int line_number,
@@ -1505,7 +1742,7 @@ wabt::Result CommandRunner::ReadInvalidModule(int line_number,
 
   switch (module_type) {
     case ModuleType::Text: {
-      return ReadTextModule(module_filename, header, true);
+      return ReadTextModule(module_filename, header);
     }
 
     case ModuleType::Binary: {
@@ -1524,36 +1761,6 @@ wabt::Result CommandRunner::ReadInvalidModule(int line_number,
   WABT_UNREACHABLE;
 }
 
-wabt::Result CommandRunner::ReadMalformedBinaryModule(
-    std::string_view module_filename,
-    Errors* errors) {
-  std::vector<uint8_t> file_data;
-
-  CHECK_RESULT(ReadFile(module_filename, &file_data));
-
-  const bool kReadDebugNames = true;
-  const bool kStopOnFirstError = true;
-  const bool kFailOnCustomSectionError = true;
-  ReadBinaryOptions options(s_features, s_log_stream.get(), kReadDebugNames,
-                            kStopOnFirstError, kFailOnCustomSectionError);
-
-  class BinaryReaderErrorLogging : public BinaryReaderNop {
-    Errors* errors_;
-
-   public:
-    BinaryReaderErrorLogging(Errors* errors) : errors_(errors) {}
-
-    bool OnError(const Error& error) override {
-      errors_->push_back(error);
-      return true;
-    }
-  };
-
-  BinaryReaderErrorLogging reader_delegate{errors};
-  return ReadBinary(file_data.data(), file_data.size(), &reader_delegate,
-                    options);
-}
-
 wabt::Result CommandRunner::ReadMalformedModule(
     int line_number,
     std::string_view module_filename,
@@ -1564,15 +1771,18 @@ wabt::Result CommandRunner::ReadMalformedModule(
 
   switch (module_type) {
     case ModuleType::Text: {
-      return ReadTextModule(module_filename, header, false);
+      return ReadTextModule(module_filename, header);
     }
 
     case ModuleType::Binary: {
-      Errors errors;
-      wabt::Result result = ReadMalformedBinaryModule(module_filename, &errors);
+      BinaryModuleInfo* info = binary_modules_.find(module_filename)->second;
+      if (!info->read_file) {
+        return wabt::Result::Error;
+      }
+      Errors errors = ErrorsForFile(info->malformed_errors, module_filename);
       FormatErrorsToFile(errors, Location::Type::Binary, {}, stdout, header,
                          PrintHeader::Once);
-      return result;
+      return info->malformed_result;
     }
   }
 
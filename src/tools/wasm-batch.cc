@@ -0,0 +1,867 @@
+/*
+ * Copyright 2026 WebAssembly Community Group participants
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <cassert>
+#include <cinttypes>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "wabt/apply-names.h"
+#include "wabt/binary-reader-ir.h"
+#include "wabt/binary-reader.h"
+#include "wabt/binary-writer.h"
+#include "wabt/binary.h"
+#include "wabt/c-writer.h"
+#include "wabt/cast.h"
+#include "wabt/error-formatter.h"
+#include "wabt/feature.h"
+#include "wabt/filenames.h"
+#include "wabt/generate-names.h"
+#include "wabt/ir.h"
+#include "wabt/option-parser.h"
+#include "wabt/stream.h"
+#include "wabt/validator.h"
+#include "wabt/wast-lexer.h"
+#include "wabt/wast-parser.h"
+
+#if HAVE_UNISTD_H
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+using namespace wabt;
+
+static int s_jobs = 1;
+static std::string s_socket_path;
+static Features s_features;
+
+static const char s_description[] =
+    R"(  Run wabt tools on many modules in one process. Each line of input
+  is a JSON request naming an input file and the steps to run on it; the
+  file is read once and the steps share the module. Each request is
+  answered by a line of JSON with the same id, as soon as it is done.
+
+  Steps are "wat2wasm" (options "output", "debug-names", "relocatable",
+  "no-check"), "wasm-validate", "wasm2c" (options "output", "num-outputs",
+  "module-name") and "wasm-strip" (option "output"). The input may be in
+  the text or binary format. A request can also "enable" or "disable" a
+  list of features, on top of the ones given on the command line.
+
+  Like wasm2c on the output of wat2wasm, the wasm2c step only keeps the
+  names of a text input if a wat2wasm step wrote them with "debug-names".
+
+examples:
+  # convert test.wat to test.wasm, and to C in test.c and test.h
+  $ echo '{"id": 1, "input": "test.wat", "steps": [
+      {"tool": "wat2wasm", "output": "test.wasm"},
+      {"tool": "wasm2c", "output": "test.c"}]}' | tr -d '\n' | wasm-batch
+  {"id": 1, "ok": true}
+
+  # answer requests from clients of a Unix socket, on 8 threads
+  $ wasm-batch --socket=/tmp/wabt.sock --jobs=8
+)";
+
+static void ParseOptions(int argc, char** argv) {
+  OptionParser parser("wasm-batch", s_description);
+
+  s_features.AddOptions(&parser);
+  parser.AddOption('j', "jobs", "N", "Run up to N requests at once",
+                   [](const char* argument) { s_jobs = atoi(argument); });
+#if HAVE_UNISTD_H
+  parser.AddOption(0, "socket", "PATH",
+                   "Read requests from clients of a Unix socket at PATH, "
+                   "instead of stdin",
+                   [](const char* argument) { s_socket_path = argument; });
+#endif
+  parser.Parse(argc, argv);
+}
+
+// Just enough JSON to read the requests.
+struct JSONValue {
+  enum class Type {
+    Null,
+    Bool,
+    Number,
+    String,
+    Array,
+    Object,
+  };
+
+  const JSONValue* Find(std::string_view key) const {
+    for (const auto& [name, value] : members) {
+      if (name == key) {
+        return &value;
+      }
+    }
+    return nullptr;
+  }
+
+  Type type = Type::Null;
+  bool bool_value = false;
+  std::string text;  // A string's contents, or a number's literal text.
+  std::vector<JSONValue> elements;
+  std::vector<std::pair<std::string, JSONValue>> members;
+};
+
+class JSONParser {
+ public:
+  explicit JSONParser(std::string_view input) : input_(input) {}
+
+  Result ParseDocument(JSONValue* out_value) {
+    CHECK_RESULT(ParseValue(out_value, 0));
+    SkipWhitespace();
+    return pos_ == input_.size() ? Result::Ok : Result::Error;
+  }
+
+ private:
+  static constexpr int kMaxDepth = 64;
+
+  void SkipWhitespace() {
+    while (pos_ < input_.size() &&
+           std::string_view(" \t\r\n").find(input_[pos_]) !=
+               std::string_view::npos) {
+      pos_++;
+    }
+  }
+
+  bool Match(std::string_view s) {
+    SkipWhitespace();
+    if (input_.substr(pos_, s.size()) != s) {
+      return false;
+    }
+    pos_ += s.size();
+    return true;
+  }
+
+  Result ParseString(std::string* out_string) {
+    if (!Match("\"")) {
+      return Result::Error;
+    }
+    while (pos_ < input_.size()) {
+      char c = input_[pos_++];
+      if (c == '"') {
+        return Result::Ok;
+      }
+      if (c != '\\') {
+        *out_string += c;
+        continue;
+      }
+      if (pos_ == input_.size()) {
+        return Result::Error;
+      }
+      switch (char escape = input_[pos_++]) {
+        case 'b': *out_string += '\b'; break;
+        case 'f': *out_string += '\f'; break;
+        case 'n': *out_string += '\n'; break;
+        case 'r': *out_string += '\r'; break;
+        case 't': *out_string += '\t'; break;
+        case 'u': {
+          // Only code points in the Basic Multilingual Plane are supported.
+          std::string digits(input_.substr(pos_, 4));
+          char* end;
+          unsigned long code = strtoul(digits.c_str(), &end, 16);
+          if (digits.size() != 4 || *end) {
+            return Result::Error;
+          }
+          pos_ += 4;
+          if (code < 0x80) {
+            *out_string += static_cast<char>(code);
+          } else if (code < 0x800) {
+            *out_string += static_cast<char>(0xc0 | (code >> 6));
+            *out_string += static_cast<char>(0x80 | (code & 0x3f));
+          } else {
+            *out_string += static_cast<char>(0xe0 | (code >> 12));
+            *out_string += static_cast<char>(0x80 | ((code >> 6) & 0x3f));
+            *out_string += static_cast<char>(0x80 | (code & 0x3f));
+          }
+          break;
+        }
+        default:
+          *out_string += escape;
+          break;
+      }
+    }
+    return Result::Error;
+  }
+
+  Result ParseValue(JSONValue* out_value, int depth) {
+    if (depth > kMaxDepth) {
+      return Result::Error;
+    }
+
+    SkipWhitespace();
+    if (pos_ == input_.size()) {
+      return Result::Error;
+    }
+
+    char c = input_[pos_];
+    if (c == '"') {
+      out_value->type = JSONValue::Type::String;
+      return ParseString(&out_value->text);
+    }
+
+    if (c == '[') {
+      pos_++;
+      out_value->type = JSONValue::Type::Array;
+      if (Match("]")) {
+        return Result::Ok;
+      }
+      do {
+        CHECK_RESULT(
+            ParseValue(&out_value->elements.emplace_back(), depth + 1));
+      } while (Match(","));
+      return Match("]") ? Result::Ok : Result::Error;
+    }
+
+    if (c == '{') {
+      pos_++;
+      out_value->type = JSONValue::Type::Object;
+      if (Match("}")) {
+        return Result::Ok;
+      }
+      do {
+        auto& [name, value] = out_value->members.emplace_back();
+        CHECK_RESULT(ParseString(&name));
+        if (!Match(":")) {
+          return Result::Error;
+        }
+        CHECK_RESULT(ParseValue(&value, depth + 1));
+      } while (Match(","));
+      return Match("}") ? Result::Ok : Result::Error;
+    }
+
+    if (Match("true") || Match("false")) {
+      out_value->type = JSONValue::Type::Bool;
+      out_value->bool_value = c == 't';
+      return Result::Ok;
+    }
+
+    if (Match("null")) {
+      return Result::Ok;
+    }
+
+    size_t end = input_.find_first_not_of("+-0123456789.eE", pos_);
+    if (end == pos_) {
+      return Result::Error;
+    }
+    out_value->type = JSONValue::Type::Number;
+    out_value->text = input_.substr(pos_, end - pos_);
+    pos_ = end == input_.npos ? input_.size() : end;
+    return Result::Ok;
+  }
+
+  std::string_view input_;
+  size_t pos_ = 0;
+};
+
+static std::string JSONString(std::string_view s) {
+  std::string result = "\"";
+  for (char c : s) {
+    if (c == '"' || c == '\\') {
+      result += '\\';
+      result += c;
+    } else if (c == '\n') {
+      result += "\\n";
+    } else if (static_cast<unsigned char>(c) < 0x20) {
+      char buffer[8];
+      snprintf(buffer, sizeof(buffer), "\\u%04x", c);
+      result += buffer;
+    } else {
+      result += c;
+    }
+  }
+  return result + "\"";
+}
+
+static std::string ToJSON(const JSONValue& value) {
+  switch (value.type) {
+    case JSONValue::Type::Null:
+      return "null";
+    case JSONValue::Type::Bool:
+      return value.bool_value ? "true" : "false";
+    case JSONValue::Type::Number:
+      return value.text;
+    case JSONValue::Type::String:
+      return JSONString(value.text);
+    case JSONValue::Type::Array: {
+      std::string result = "[";
+      for (const JSONValue& element : value.elements) {
+        result += (result.size() > 1 ? ", " : "") + ToJSON(element);
+      }
+      return result + "]";
+    }
+    case JSONValue::Type::Object: {
+      std::string result = "{";
+      for (const auto& [name, member] : value.members) {
+        result += (result.size() > 1 ? ", " : "") + JSONString(name) + ": " +
+                  ToJSON(member);
+      }
+      return result + "}";
+    }
+  }
+  WABT_UNREACHABLE;
+}
+
+// Removes the code metadata in |exprs| and the blocks nested in it. The
+// binary writer writes it as "metadata.code.*" custom sections.
+static void RemoveCodeMetadata(ExprList* exprs) {
+  for (auto iter = exprs->begin(); iter != exprs->end();) {
+    switch (iter->type()) {
+      case ExprType::CodeMetadata:
+        iter = exprs->erase(iter);
+        continue;
+      case ExprType::Block:
+        RemoveCodeMetadata(&cast<BlockExpr>(&*iter)->block.exprs);
+        break;
+      case ExprType::Loop:
+        RemoveCodeMetadata(&cast<LoopExpr>(&*iter)->block.exprs);
+        break;
+      case ExprType::If: {
+        auto* if_expr = cast<IfExpr>(&*iter);
+        RemoveCodeMetadata(&if_expr->true_.exprs);
+        RemoveCodeMetadata(&if_expr->false_);
+        break;
+      }
+      case ExprType::Try: {
+        auto* try_expr = cast<TryExpr>(&*iter);
+        RemoveCodeMetadata(&try_expr->block.exprs);
+        for (Catch& catch_ : try_expr->catches) {
+          RemoveCodeMetadata(&catch_.exprs);
+        }
+        break;
+      }
+      case ExprType::TryTable:
+        RemoveCodeMetadata(&cast<TryTableExpr>(&*iter)->block.exprs);
+        break;
+      default:
+        break;
+    }
+    ++iter;
+  }
+}
+
+// A request that is being run: the module that its steps share, and the
+// errors found so far.
+class Request {
+ public:
+  explicit Request(const JSONValue& request) : request_(request) {}
+
+  Result Run();
+  std::string Response(Result result) const;
+
+ private:
+  void WABT_PRINTF_FORMAT(2, 3) Error(const char* format, ...);
+  std::string GetString(const JSONValue& object,
+                        std::string_view key,
+                        std::string_view default_value = {});
+  bool GetBool(const JSONValue& object, std::string_view key);
+  Result SetFeatures(std::string_view key, bool enabled);
+  Result ReadInput();
+  Result Validate();
+  Result WriteBinary(const std::string& filename,
+                     const WriteBinaryOptions& options);
+  Result ReadBinaryWithoutNames(Module* out_module);
+  Result RunStep(const JSONValue& step);
+  Result RunWat2Wasm(const JSONValue& step);
+  Result RunWasm2C(const JSONValue& step);
+  Result RunWasmStrip(const JSONValue& step);
+
+  const JSONValue& request_;
+  std::string input_;
+  Features features_ = s_features;
+  std::vector<uint8_t> file_data_;
+  std::unique_ptr<WastLexer> lexer_;  // For text inputs only.
+  std::unique_ptr<Module> module_;
+  // Whether the binary format of the module, as read or last written, has
+  // its names.
+  bool names_in_binary_ = false;
+  bool validated_ = false;
+  Errors errors_;
+  std::string messages_;  // Errors in the request itself.
+};
+
+void Request::Error(const char* format, ...) {
+  WABT_SNPRINTF_ALLOCA(buffer, length, format);
+  messages_ += buffer;
+  messages_ += '\n';
+}
+
+std::string Request::GetString(const JSONValue& object,
+                               std::string_view key,
+                               std::string_view default_value) {
+  const JSONValue* value = object.Find(key);
+  if (!value) {
+    return std::string(default_value);
+  }
+  if (value->type != JSONValue::Type::String &&
+      value->type != JSONValue::Type::Number) {
+    Error("expected \"" PRIstringview "\" to be a string",
+          WABT_PRINTF_STRING_VIEW_ARG(key));
+    return std::string(default_value);
+  }
+  return value->text;
+}
+
+bool Request::GetBool(const JSONValue& object, std::string_view key) {
+  const JSONValue* value = object.Find(key);
+  return value && value->type == JSONValue::Type::Bool && value->bool_value;
+}
+
+Result Request::SetFeatures(std::string_view key, bool enabled) {
+  const JSONValue* names = request_.Find(key);
+  if (!names) {
+    return Result::Ok;
+  }
+
+  Result result = Result::Ok;
+  for (const JSONValue& name : names->elements) {
+    bool found = false;
+#define WABT_FEATURE(variable, flag, default_, help) \
+  if (name.text == flag) {                           \
+    features_.set_##variable##_enabled(enabled);     \
+    found = true;                                    \
+  }
+#include "wabt/feature.def"
+#undef WABT_FEATURE
+    if (!found) {
+      Error("unknown feature: %s", name.text.c_str());
+      result = Result::Error;
+    }
+  }
+  return result;
+}
+
+Result Request::ReadInput() {
+  if (Failed(ReadFile(input_, &file_data_))) {
+    Error("unable to read file: %s", input_.c_str());
+    return Result::Error;
+  }
+
+  module_ = std::make_unique<Module>();
+  if (file_data_.size() >= 4 &&
+      memcmp(file_data_.data(), "\0asm", 4) == 0) {
+    const bool kReadDebugNames = true;
+    const bool kStopOnFirstError = true;
+    const bool kFailOnCustomSectionError = true;
+    ReadBinaryOptions options(features_, nullptr, kReadDebugNames,
+                              kStopOnFirstError, kFailOnCustomSectionError);
+    names_in_binary_ = true;
+    return ReadBinaryIr(input_.c_str(), file_data_.data(), file_data_.size(),
+                        options, &errors_, module_.get());
+  }
+
+  lexer_ = WastLexer::CreateBufferLexer(input_, file_data_.data(),
+                                        file_data_.size(), &errors_);
+  WastParseOptions options(features_);
+  return ParseWatModule(lexer_.get(), &module_, &errors_, &options);
+}
+
+Result Request::Validate() {
+  if (!validated_) {
+    CHECK_RESULT(ValidateModule(module_.get(), &errors_,
+                                ValidateOptions(features_)));
+    validated_ = true;
+  }
+  return Result::Ok;
+}
+
+Result Request::WriteBinary(const std::string& filename,
+                            const WriteBinaryOptions& options) {
+  MemoryStream stream;
+  CHECK_RESULT(WriteBinaryModule(&stream, module_.get(), options));
+  if (Failed(stream.output_buffer().WriteToFile(filename))) {
+    Error("unable to write file: %s", filename.c_str());
+    return Result::Error;
+  }
+  return Result::Ok;
+}
+
+// Reads the module back from its binary format without a name section, as
+// wasm2c would read the output of wat2wasm without --debug-names.
+Result Request::ReadBinaryWithoutNames(Module* out_module) {
+  MemoryStream stream;
+  WriteBinaryOptions write_options;
+  write_options.features = features_;
+  CHECK_RESULT(WriteBinaryModule(&stream, module_.get(), write_options));
+  const std::vector<uint8_t>& data = stream.output_buffer().data;
+  const bool kReadDebugNames = true;
+  const bool kStopOnFirstError = true;
+  const bool kFailOnCustomSectionError = true;
+  ReadBinaryOptions read_options(features_, nullptr, kReadDebugNames,
+                                 kStopOnFirstError, kFailOnCustomSectionError);
+  return ReadBinaryIr(input_.c_str(), data.data(), data.size(), read_options,
+                      &errors_, out_module);
+}
+
+Result Request::RunWat2Wasm(const JSONValue& step) {
+  if (!GetBool(step, "no-check")) {
+    CHECK_RESULT(Validate());
+  }
+
+  std::string default_output(StripExtension(GetBasename(input_)));
+  default_output += kWasmExtension;
+  WriteBinaryOptions options;
+  options.features = features_;
+  options.relocatable = GetBool(step, "relocatable");
+  options.write_debug_names = GetBool(step, "debug-names");
+  CHECK_RESULT(WriteBinary(GetString(step, "output", default_output), options));
+  names_in_binary_ = options.write_debug_names;
+  return Result::Ok;
+}
+
+Result Request::RunWasm2C(const JSONValue& step) {
+  std::string output = GetString(step, "output");
+  if (output.empty()) {
+    Error("wasm2c needs an \"output\"");
+    return Result::Error;
+  }
+  int num_outputs = atoi(GetString(step, "num-outputs", "1").c_str());
+  if (num_outputs < 1) {
+    Error("Number of output files must be positive.");
+    return Result::Error;
+  }
+  if (!AreCWriterFeaturesSupported(features_)) {
+    Error("wasm2c currently only supports a limited set of features.");
+    return Result::Error;
+  }
+
+  CHECK_RESULT(Validate());
+  // wasm2c names the C symbols after the names in the binary it reads, so
+  // names that the binary doesn't have, e.g. those of a text input, must not
+  // reach the C output.
+  Module* module = module_.get();
+  Module module_without_names;
+  if (!names_in_binary_) {
+    CHECK_RESULT(ReadBinaryWithoutNames(&module_without_names));
+    module = &module_without_names;
+  }
+  CHECK_RESULT(GenerateNames(module));
+  ApplyNames(module);
+
+  std::string module_name = GetString(step, "module-name", module->name);
+  if (module_name.empty()) {
+    module_name = StripExtension(GetBasename(input_));
+  }
+  WriteCOptions options;
+  options.features = features_;
+  options.module_name = module_name;
+
+  std::string output_prefix(StripExtension(output));
+  std::vector<std::string> filenames;
+  if (num_outputs == 1) {
+    filenames.push_back(output);
+  } else {
+    for (int i = 0; i < num_outputs; i++) {
+      filenames.push_back(output_prefix + "_" + std::to_string(i) + ".c");
+    }
+  }
+  std::vector<MemoryStream> streams(filenames.size());
+  std::vector<Stream*> c_stream_ptrs;
+  for (MemoryStream& stream : streams) {
+    c_stream_ptrs.push_back(&stream);
+  }
+
+  std::string header_name_full = output_prefix + ".h";
+  std::string header_impl_name_full = output_prefix + "-impl.h";
+  std::string header_name(GetBasename(header_name_full));
+  std::string header_impl_name(GetBasename(header_impl_name_full));
+  MemoryStream h_stream;
+  MemoryStream h_impl_stream;
+  if (num_outputs == 1) {
+    CHECK_RESULT(WriteC(std::move(c_stream_ptrs), &h_stream, c_stream_ptrs[0],
+                        header_name.c_str(), "", module, options));
+  } else {
+    CHECK_RESULT(WriteC(std::move(c_stream_ptrs), &h_stream, &h_impl_stream,
+                        header_name.c_str(), header_impl_name.c_str(),
+                        module, options));
+    filenames.push_back(header_impl_name_full);
+    streams.push_back(std::move(h_impl_stream));
+  }
+  filenames.push_back(header_name_full);
+  streams.push_back(std::move(h_stream));
+
+  // As with wasm2c, outputs that haven't changed are left alone.
+  for (size_t i = 0; i < filenames.size(); i++) {
+    if (Failed(streams[i].output_buffer().WriteToFileIfChanged(
+            filenames[i]))) {
+      Error("unable to write file: %s", filenames[i].c_str());
+      return Result::Error;
+    }
+  }
+  return Result::Ok;
+}
+
+Result Request::RunWasmStrip(const JSONValue& step) {
+  // Like wasm-strip, a binary input is overwritten by default.
+  std::string output = GetString(step, "output", lexer_ ? "" : input_);
+  if (output.empty()) {
+    Error("wasm-strip needs an \"output\" for a text input");
+    return Result::Error;
+  }
+
+  // Like wasm-strip, every custom section is removed, including the code
+  // metadata and the names. Later steps don't see them either.
+  module_->customs.clear();
+  for (Func* func : module_->funcs) {
+    RemoveCodeMetadata(&func->exprs);
+  }
+  WriteBinaryOptions options;
+  options.features = features_;
+  CHECK_RESULT(WriteBinary(output, options));
+  names_in_binary_ = false;
+  return Result::Ok;
+}
+
+Result Request::RunStep(const JSONValue& step) {
+  std::string tool = GetString(step, "tool");
+  if (tool == "wat2wasm") {
+    return RunWat2Wasm(step);
+  } else if (tool == "wasm-validate") {
+    return Validate();
+  } else if (tool == "wasm2c") {
+    return RunWasm2C(step);
+  } else if (tool == "wasm-strip") {
+    return RunWasmStrip(step);
+  }
+  Error("unknown tool: \"%s\"", tool.c_str());
+  return Result::Error;
+}
+
+Result Request::Run() {
+  if (request_.type != JSONValue::Type::Object) {
+    Error("expected a request object");
+    return Result::Error;
+  }
+
+  input_ = GetString(request_, "input");
+  if (input_.empty()) {
+    Error("expected an \"input\"");
+    return Result::Error;
+  }
+  CHECK_RESULT(SetFeatures("enable", true));
+  CHECK_RESULT(SetFeatures("disable", false));
+  CHECK_RESULT(ReadInput());
+
+  if (const JSONValue* steps = request_.Find("steps")) {
+    for (const JSONValue& step : steps->elements) {
+      CHECK_RESULT(RunStep(step));
+    }
+  }
+  return Result::Ok;
+}
+
+std::string Request::Response(Result result) const {
+  std::string response = "{";
+  if (const JSONValue* id = request_.Find("id")) {
+    response += "\"id\": " + ToJSON(*id) + ", ";
+  }
+  response += Succeeded(result) ? "\"ok\": true" : "\"ok\": false";
+
+  std::string errors = messages_;
+  if (lexer_) {
+    auto line_finder = lexer_->MakeLineFinder();
+    errors +=
+        FormatErrorsToString(errors_, Location::Type::Text, line_finder.get());
+  } else {
+    errors += FormatErrorsToString(errors_, Location::Type::Binary);
+  }
+  if (!errors.empty()) {
+    response += ", \"errors\": " + JSONString(errors);
+  }
+  return response + "}\n";
+}
+
+static std::string RunRequest(std::string_view line) {
+  JSONValue value;
+  JSONParser parser(line);
+  if (Failed(parser.ParseDocument(&value))) {
+    return "{\"ok\": false, \"errors\": \"unable to parse request\\n\"}\n";
+  }
+
+  Request request(value);
+  Result result = request.Run();
+  return request.Response(result);
+}
+
+// Runs tasks on a fixed set of threads, in the order they are added.
+class ThreadPool {
+ public:
+  explicit ThreadPool(int num_threads) {
+    for (int i = 0; i < std::max(num_threads, 1); ++i) {
+      threads_.emplace_back([this]() { RunTasks(); });
+    }
+  }
+
+  // Waits for the tasks that have been added to finish.
+  ~ThreadPool() {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      done_ = true;
+    }
+    cv_.notify_all();
+    for (std::thread& thread : threads_) {
+      thread.join();
+    }
+  }
+
+  void Add(std::function<void()> task) {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      tasks_.push_back(std::move(task));
+    }
+    cv_.notify_one();
+  }
+
+ private:
+  void RunTasks() {
+    while (true) {
+      std::function<void()> task;
+      {
+        std::unique_lock<std::mutex> lock(mutex_);
+        cv_.wait(lock, [this]() { return done_ || !tasks_.empty(); });
+        if (tasks_.empty()) {
+          return;
+        }
+        task = std::move(tasks_.front());
+        tasks_.pop_front();
+      }
+      task();
+    }
+  }
+
+  std::vector<std::thread> threads_;
+  std::mutex mutex_;
+  std::condition_variable cv_;
+  std::deque<std::function<void()>> tasks_;
+  bool done_ = false;
+};
+
+// Where requests are read from and answered to. It is closed once the
+// input has ended and every request has been answered.
+class Connection {
+ public:
+  Connection(FILE* in, FILE* out) : in_(in), out_(out) {}
+
+  ~Connection() {
+    if (in_ != stdin) {
+      fclose(in_);
+      fclose(out_);
+    }
+  }
+
+  bool ReadLine(std::string* out_line) {
+    out_line->clear();
+    char buffer[4096];
+    while (fgets(buffer, sizeof(buffer), in_)) {
+      *out_line += buffer;
+      if (out_line->back() == '\n') {
+        return true;
+      }
+    }
+    return !out_line->empty();
+  }
+
+  void Write(const std::string& response) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    fwrite(response.data(), 1, response.size(), out_);
+    fflush(out_);
+  }
+
+ private:
+  FILE* in_;
+  FILE* out_;
+  std::mutex mutex_;
+};
+
+static void Serve(ThreadPool& pool, std::shared_ptr<Connection> connection) {
+  std::string line;
+  while (connection->ReadLine(&line)) {
+    if (line.find_first_not_of(" \t\r\n") == line.npos) {
+      continue;
+    }
+    pool.Add([connection, line]() { connection->Write(RunRequest(line)); });
+  }
+}
+
+#if HAVE_UNISTD_H
+static int ServeSocket(ThreadPool& pool) {
+  sockaddr_un addr{};
+  addr.sun_family = AF_UNIX;
+  if (s_socket_path.size() >= sizeof(addr.sun_path)) {
+    fprintf(stderr, "socket path is too long: %s\n", s_socket_path.c_str());
+    return 1;
+  }
+  strcpy(addr.sun_path, s_socket_path.c_str());
+
+  int listen_fd = socket(AF_UNIX, SOCK_STREAM, 0);
+  unlink(s_socket_path.c_str());
+  if (listen_fd < 0 ||
+      bind(listen_fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0 ||
+      listen(listen_fd, SOMAXCONN) < 0) {
+    perror(s_socket_path.c_str());
+    return 1;
+  }
+
+  while (true) {
+    int fd = accept(listen_fd, nullptr, nullptr);
+    if (fd < 0) {
+      continue;
+    }
+    int out_fd = dup(fd);
+    FILE* in = fdopen(fd, "r");
+    FILE* out = out_fd >= 0 ? fdopen(out_fd, "w") : nullptr;
+    if (!in || !out) {
+      in ? fclose(in) : close(fd);
+      out ? fclose(out) : (out_fd >= 0 ? close(out_fd) : 0);
+      continue;
+    }
+    std::thread([&pool, in, out]() {
+      Serve(pool, std::make_shared<Connection>(in, out));
+    }).detach();
+  }
+}
+#endif
+
+int ProgramMain(int argc, char** argv) {
+  InitStdio();
+  ParseOptions(argc, argv);
+
+  ThreadPool pool(s_jobs);
+#if HAVE_UNISTD_H
+  if (!s_socket_path.empty()) {
+    return ServeSocket(pool);
+  }
+#endif
+
+  Serve(pool, std::make_shared<Connection>(stdin, stdout));
+  return 0;
+}
+
+int main(int argc, char** argv) {
+  WABT_TRY
+  return ProgramMain(argc, argv);
+  WABT_CATCH_BAD_ALLOC_AND_EXIT
+}
@@ -100,10 +100,10 @@ int ProgramMain(int argc, char** argv) {
         WABT_USE(dummy_result);
       }
       if (Succeeded(result)) {
-        auto s = Decompile(module, decompile_options);
         FileStream stream(!outfile.empty() ? FileStream(outfile)
                                            : FileStream(stdout));
-        stream.WriteData(s.data(), s.size());
+        result = Decompile(module, decompile_options, &stream);
+        result |= stream.Close();
       }
     }
     FormatErrorsToFile(errors, Location::Type::Binary);
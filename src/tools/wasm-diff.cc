@@ -0,0 +1,164 @@
+/*
+ * Copyright 2026 WebAssembly Community Group participants
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <cstdio>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "wabt/binary-reader-hash.h"
+#include "wabt/binary-reader.h"
+#include "wabt/option-parser.h"
+#include "wabt/stream.h"
+
+using namespace wabt;
+
+static std::vector<std::string> s_infiles;
+static const char* s_outfile;
+static Features s_features;
+
+static const char s_description[] =
+    R"(  Hash each function body, data segment and section of a wasm binary
+  file. Given two files, report the items that were changed, added or
+  removed between them.
+
+  Functions and data segments are matched by their names from the name
+  section, else functions by their export or import name, else by index.
+  The hash of a function body does not change when only the indices of the
+  functions it calls were renumbered.
+
+  Exits with 0 if the files have the same items, 1 if they differ, and 2 on
+  error.
+
+examples:
+  # print the hash of every item in test.wasm
+  $ wasm-diff test.wasm
+
+  # list the items that differ between old.wasm and new.wasm
+  $ wasm-diff old.wasm new.wasm
+)";
+
+static void ParseOptions(int argc, char** argv) {
+  OptionParser parser("wasm-diff", s_description);
+
+  s_features.AddOptions(&parser);
+  parser.AddOption('o', "output", "FILENAME",
+                   "Output file for the report, by default use stdout",
+                   [](const char* argument) { s_outfile = argument; });
+  parser.AddArgument("filename", OptionParser::ArgumentCount::OneOrMore,
+                     [](const char* argument) {
+                       s_infiles.emplace_back(argument);
+                     });
+  parser.Parse(argc, argv);
+
+  if (s_infiles.size() > 2) {
+    fprintf(stderr, "wasm-diff: expected one or two files\n");
+    exit(2);
+  }
+}
+
+static Result ReadHashes(const std::string& filename,
+                         std::vector<BinaryItemHash>* items) {
+  std::vector<uint8_t> file_data;
+  CHECK_RESULT(ReadFile(filename.c_str(), &file_data));
+  const bool kReadDebugNames = true;
+  const bool kStopOnFirstError = true;
+  const bool kFailOnCustomSectionError = false;
+  ReadBinaryOptions options(s_features, nullptr, kReadDebugNames,
+                            kStopOnFirstError, kFailOnCustomSectionError);
+  return ReadBinaryHashes(file_data.data(), file_data.size(), options, items);
+}
+
+static std::string GetItemName(const BinaryItemHash& item) {
+  return std::string(GetBinaryItemKindName(item.kind)) + " " + item.key;
+}
+
+static void WriteHashes(Stream& stream,
+                        const std::vector<BinaryItemHash>& items) {
+  for (const BinaryItemHash& item : items) {
+    for (unsigned char c : item.digest) {
+      stream.Writef("%02x", c);
+    }
+    stream.Writef(" %s\n", GetItemName(item).c_str());
+  }
+}
+
+// Writes the changed and removed items in the order of the old module, then
+// the added items in the order of the new one. Returns whether any item
+// differs.
+static bool WriteDiff(Stream& stream,
+                      const std::vector<BinaryItemHash>& old_items,
+                      const std::vector<BinaryItemHash>& new_items) {
+  std::unordered_map<std::string, const BinaryItemHash*> new_by_name;
+  for (const BinaryItemHash& item : new_items) {
+    new_by_name.emplace(GetItemName(item), &item);
+  }
+
+  bool differ = false;
+  for (const BinaryItemHash& item : old_items) {
+    std::string name = GetItemName(item);
+    auto iter = new_by_name.find(name);
+    if (iter == new_by_name.end()) {
+      stream.Writef("removed %s\n", name.c_str());
+      differ = true;
+      continue;
+    }
+    if (iter->second->digest != item.digest) {
+      stream.Writef("changed %s\n", name.c_str());
+      differ = true;
+    }
+    new_by_name.erase(iter);
+  }
+
+  for (const BinaryItemHash& item : new_items) {
+    std::string name = GetItemName(item);
+    if (new_by_name.count(name)) {
+      stream.Writef("added %s\n", name.c_str());
+      differ = true;
+    }
+  }
+  return differ;
+}
+
+int ProgramMain(int argc, char** argv) {
+  InitStdio();
+  ParseOptions(argc, argv);
+
+  std::vector<std::vector<BinaryItemHash>> modules(s_infiles.size());
+  for (size_t i = 0; i < s_infiles.size(); ++i) {
+    if (Failed(ReadHashes(s_infiles[i], &modules[i]))) {
+      return 2;
+    }
+  }
+
+  FileStream stream(s_outfile ? FileStream(s_outfile) : FileStream(stdout));
+  bool differ = false;
+  if (modules.size() == 1) {
+    WriteHashes(stream, modules[0]);
+  } else {
+    differ = WriteDiff(stream, modules[0], modules[1]);
+  }
+  if (Failed(stream.Close())) {
+    return 2;
+  }
+  return differ ? 1 : 0;
+}
+
+int main(int argc, char** argv) {
+  WABT_TRY
+  return ProgramMain(argc, argv);
+  WABT_CATCH_BAD_ALLOC_AND_EXIT
+}
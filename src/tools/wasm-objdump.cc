@@ -51,6 +51,19 @@ static void ParseOptions(int argc, char** argv) {
                    []() { s_objdump_options.raw = true; });
   parser.AddOption('d', "disassemble", "Disassemble function bodies",
                    []() { s_objdump_options.disassemble = true; });
+  parser.AddOption(
+      0, "func", "FUNCTION",
+      "Disassemble just this function, given by name or index. Implies -d; "
+      "may be repeated",
+      [](const char* argument) {
+        s_objdump_options.disassemble = true;
+        s_objdump_options.functions.push_back(argument);
+      });
+  parser.AddOption(0, "jobs", "N",
+                   "Disassemble function bodies on N threads",
+                   [](const char* argument) {
+                     s_objdump_options.jobs = atoi(argument);
+                   });
   parser.AddOption("debug", "Print extra debug information", []() {
     s_objdump_options.debug = true;
     s_log_stream = FileStream::CreateStderr();
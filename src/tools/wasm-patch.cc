@@ -0,0 +1,114 @@
+/*
+ * Copyright 2026 WebAssembly Community Group participants
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "wabt/binary-patch.h"
+#include "wabt/binary-reader.h"
+#include "wabt/error-formatter.h"
+#include "wabt/option-parser.h"
+#include "wabt/stream.h"
+
+using namespace wabt;
+
+static std::vector<std::string> s_infiles;
+static std::string s_outfile;
+static bool s_create;
+static Features s_features;
+
+static const char s_description[] =
+    R"(  Create a patch that turns one version of a wasm binary file into
+  another, or apply such a patch.
+
+  The patch holds the function bodies, data segments and sections that
+  changed, and a table that maps the indices of the old functions to the new
+  ones; everything else is taken from the old module. Applying the patch
+  gives the new module bit for bit.
+
+examples:
+  # create update.patch, which turns old.wasm into new.wasm
+  $ wasm-patch --create old.wasm new.wasm -o update.patch
+
+  # apply update.patch to old.wasm, writing new.wasm
+  $ wasm-patch old.wasm update.patch -o new.wasm
+)";
+
+static void ParseOptions(int argc, char** argv) {
+  OptionParser parser("wasm-patch", s_description);
+
+  s_features.AddOptions(&parser);
+  parser.AddOption("create",
+                   "Create a patch from the first file to the second, instead "
+                   "of applying the patch in the second file",
+                   []() { s_create = true; });
+  parser.AddOption('o', "output", "FILENAME",
+                   "Output file for the patch or the patched module",
+                   [](const char* argument) { s_outfile = argument; });
+  parser.AddArgument("old-file", OptionParser::ArgumentCount::One,
+                     [](const char* argument) {
+                       s_infiles.emplace_back(argument);
+                     });
+  parser.AddArgument("file", OptionParser::ArgumentCount::One,
+                     [](const char* argument) {
+                       s_infiles.emplace_back(argument);
+                     });
+  parser.Parse(argc, argv);
+
+  if (s_outfile.empty()) {
+    fprintf(stderr, "wasm-patch: an output file is required (-o)\n");
+    exit(1);
+  }
+}
+
+int ProgramMain(int argc, char** argv) {
+  InitStdio();
+  ParseOptions(argc, argv);
+
+  std::vector<uint8_t> old_data;
+  std::vector<uint8_t> file_data;
+  if (Failed(ReadFile(s_infiles[0], &old_data)) ||
+      Failed(ReadFile(s_infiles[1], &file_data))) {
+    return 1;
+  }
+
+  const bool kReadDebugNames = true;
+  const bool kStopOnFirstError = true;
+  const bool kFailOnCustomSectionError = false;
+  ReadBinaryOptions options(s_features, nullptr, kReadDebugNames,
+                            kStopOnFirstError, kFailOnCustomSectionError);
+  Errors errors;
+  std::vector<uint8_t> output;
+  Result result =
+      s_create ? CreateBinaryPatch(old_data, file_data, options, &output,
+                                   &errors)
+               : ApplyBinaryPatch(old_data, file_data, options, &output,
+                                  &errors);
+  FormatErrorsToFile(errors, Location::Type::Binary);
+  if (Succeeded(result)) {
+    FileStream stream(s_outfile);
+    stream.WriteData(output.data(), output.size());
+    result = stream.Close();
+  }
+  return result != Result::Ok;
+}
+
+int main(int argc, char** argv) {
+  WABT_TRY
+  return ProgramMain(argc, argv);
+  WABT_CATCH_BAD_ALLOC_AND_EXIT
+}
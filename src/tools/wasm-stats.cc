@@ -20,8 +20,9 @@
 #include <cinttypes>
 #include <cstdio>
 #include <cstdlib>
-#include <iterator>
+#include <cstring>
 #include <map>
+#include <string>
 #include <vector>
 
 #include "wabt/binary-reader-stats.h"
@@ -34,22 +35,36 @@
 
 using namespace wabt;
 
+enum class OutputFormat {
+  Text,
+  Json,
+  Csv,
+};
+
 static int s_verbose;
-static const char* s_infile;
+static std::vector<std::string> s_infiles;
 static const char* s_outfile;
+static const char* s_weights_file;
 static size_t s_cutoff = 0;
 static const char* s_separator = ": ";
+static OutputFormat s_format = OutputFormat::Text;
+static bool s_per_function;
+static bool s_pairs;
 
 static ReadBinaryOptions s_read_binary_options;
 static std::unique_ptr<FileStream> s_log_stream;
 static Features s_features;
 
 static const char s_description[] =
-    R"(  Read a file in the wasm binary format, and output stats.
+    R"(  Read files in the wasm binary format, and output stats.
 
 examples:
   # parse binary file test.wasm and write opcode dist file test.dist
   $ wasm-stats test.wasm -o test.dist
+
+  # write the counts of opcodes and opcode pairs in a set of modules as JSON,
+  # weighting each function by its execution count
+  $ wasm-stats --format=json --pairs --weights=profile.txt *.wasm
 )";
 
 static void ParseOptions(int argc, char** argv) {
@@ -71,72 +86,345 @@ static void ParseOptions(int argc, char** argv) {
       's', "separator", "SEPARATOR",
       "Separator text between element and count when reporting counts",
       [](const char* argument) { s_separator = argument; });
+  parser.AddOption(
+      0, "format", "FORMAT", "Output format: text (the default), json or csv",
+      [](const char* argument) {
+        if (strcmp(argument, "text") == 0) {
+          s_format = OutputFormat::Text;
+        } else if (strcmp(argument, "json") == 0) {
+          s_format = OutputFormat::Json;
+        } else if (strcmp(argument, "csv") == 0) {
+          s_format = OutputFormat::Csv;
+        } else {
+          fprintf(stderr, "unknown output format: %s\n", argument);
+          exit(1);
+        }
+      });
+  parser.AddOption("per-function", "Also report the counts of each function",
+                   []() { s_per_function = true; });
+  parser.AddOption("pairs",
+                   "Also report how often each opcode is followed by each "
+                   "other opcode",
+                   []() { s_pairs = true; });
+  parser.AddOption(
+      0, "weights", "FILENAME",
+      "Weight each function's counts by its execution count, read from "
+      "FILENAME. Each line is \"[MODULE] FUNCTION_INDEX COUNT\"; functions "
+      "that aren't listed are weighted 0",
+      [](const char* argument) { s_weights_file = argument; });
   parser.AddArgument("filename", OptionParser::ArgumentCount::OneOrMore,
-                     [](const char* argument) { s_infile = argument; });
+                     [](const char* argument) {
+                       s_infiles.emplace_back(argument);
+                     });
   parser.Parse(argc, argv);
 }
 
+// Function weights, by module filename. The weights with an empty filename
+// apply to every module.
+using FunctionWeights = std::map<std::string, std::map<Index, uint64_t>>;
+
+static Result ReadWeights(const char* filename, FunctionWeights* weights) {
+  std::vector<uint8_t> file_data;
+  CHECK_RESULT(ReadFile(filename, &file_data));
+  std::string_view contents(reinterpret_cast<const char*>(file_data.data()),
+                            file_data.size());
+  int line_number = 0;
+  while (!contents.empty()) {
+    size_t eol = contents.find('\n');
+    std::string line(contents.substr(0, eol));
+    contents.remove_prefix(eol == contents.npos ? contents.size() : eol + 1);
+    line_number++;
+    line = line.substr(0, line.find('#'));
+
+    std::vector<std::string> fields;
+    size_t pos = 0;
+    while ((pos = line.find_first_not_of(" \t\r", pos)) != line.npos) {
+      size_t field_end = line.find_first_of(" \t\r", pos);
+      fields.push_back(line.substr(pos, field_end - pos));
+      pos = field_end;
+    }
+    if (fields.empty()) {
+      continue;
+    }
+
+    char* end;
+    uint64_t func_index = 0;
+    uint64_t count = 0;
+    bool valid = fields.size() == 2 || fields.size() == 3;
+    if (valid) {
+      const std::string& index_field = fields[fields.size() - 2];
+      const std::string& count_field = fields[fields.size() - 1];
+      func_index = strtoull(index_field.c_str(), &end, 10);
+      valid = *end == 0 && func_index <= kInvalidIndex;
+      count = strtoull(count_field.c_str(), &end, 10);
+      valid = valid && *end == 0;
+    }
+    if (!valid) {
+      fprintf(stderr, "%s:%d: expected \"[MODULE] FUNCTION_INDEX COUNT\"\n",
+              filename, line_number);
+      return Result::Error;
+    }
+    std::string module = fields.size() == 3 ? fields[0] : std::string();
+    (*weights)[module][func_index] += count;
+  }
+  return Result::Ok;
+}
+
+static std::string JsonString(std::string_view s) {
+  std::string result = "\"";
+  for (char c : s) {
+    if (c == '"' || c == '\\') {
+      result += '\\';
+      result += c;
+    } else if (static_cast<unsigned char>(c) < 0x20) {
+      char buffer[8];
+      snprintf(buffer, sizeof(buffer), "\\u%04x", c);
+      result += buffer;
+    } else {
+      result += c;
+    }
+  }
+  return result + "\"";
+}
+
+static std::string CsvField(std::string_view s) {
+  if (s.find_first_of(",\"\r\n") == s.npos) {
+    return std::string(s);
+  }
+  std::string result = "\"";
+  for (char c : s) {
+    if (c == '"') {
+      result += '"';
+    }
+    result += c;
+  }
+  return result + "\"";
+}
+
+static std::string GetImmediates(OpcodeInfo& info) {
+  MemoryStream stream;
+  info.WriteImmediates(stream);
+  const std::vector<uint8_t>& data = stream.output_buffer().data;
+  // Drop the space before the first immediate.
+  return data.empty() ? std::string()
+                      : std::string(data.begin() + 1, data.end());
+}
+
 template <typename T>
-struct SortByCountDescending {
-  bool operator()(const T& lhs, const T& rhs) const {
+static void SortByCountDescending(std::vector<std::pair<T, uint64_t>>* v) {
+  // Elements with the same count are kept in their original order.
+  std::stable_sort(v->begin(), v->end(), [](const auto& lhs, const auto& rhs) {
     return lhs.second > rhs.second;
+  });
+}
+
+// Starts each JSON array element on its own line, separated by commas.
+class JsonArray {
+ public:
+  JsonArray(Stream& stream, const char* indent)
+      : stream_(stream), indent_(indent) {}
+
+  void Element() {
+    stream_.Writef("%s\n%s", first_ ? "" : ",", indent_);
+    first_ = false;
   }
-};
 
-template <typename T>
-struct WithinCutoff {
-  bool operator()(const T& pair) const { return pair.second >= s_cutoff; }
+  void End() {
+    if (!first_) {
+      stream_.Writef("\n%s", indent_ + 2);
+    }
+  }
+
+ private:
+  Stream& stream_;
+  const char* indent_;
+  bool first_ = true;
 };
 
-static size_t SumCounts(const OpcodeInfoCounts& info_counts) {
-  size_t sum = 0;
-  for (auto& [info, count] : info_counts) {
-    sum += count;
+static void WriteFunctions(Stream& stream,
+                           std::string_view filename,
+                           const std::vector<FunctionOpcodeCounts>& functions,
+                           JsonArray* json_functions) {
+  for (const FunctionOpcodeCounts& func : functions) {
+    std::vector<std::pair<Opcode, uint64_t>> sorted;
+    uint64_t total = 0;
+    for (auto [opcode, count] : func.counts) {
+      total += count * func.weight;
+      if (count * func.weight >= s_cutoff) {
+        sorted.emplace_back(opcode, count * func.weight);
+      }
+    }
+    SortByCountDescending(&sorted);
+
+    switch (s_format) {
+      case OutputFormat::Text:
+        stream.Writef(PRIstringview " func[%" PRIindex "]",
+                      WABT_PRINTF_STRING_VIEW_ARG(filename), func.func_index);
+        if (!func.name.empty()) {
+          stream.Writef(" <%s>", func.name.c_str());
+        }
+        stream.Writef("%s%" PRIu64 "\n", s_separator, total);
+        for (auto [opcode, count] : sorted) {
+          stream.Writef("  %s%s%" PRIu64 "\n", opcode.GetName(), s_separator,
+                        count);
+        }
+        break;
+
+      case OutputFormat::Json: {
+        json_functions->Element();
+        stream.Writef("{\"module\": %s, \"index\": %" PRIindex,
+                      JsonString(filename).c_str(), func.func_index);
+        if (!func.name.empty()) {
+          stream.Writef(", \"name\": %s", JsonString(func.name).c_str());
+        }
+        stream.Writef(", \"size\": %" PRIzd ", \"weight\": %" PRIu64
+                      ", \"total\": %" PRIu64 ", \"opcodes\": {",
+                      func.size, func.weight, total);
+        for (size_t i = 0; i < sorted.size(); ++i) {
+          stream.Writef("%s\"%s\": %" PRIu64, i == 0 ? "" : ", ",
+                        sorted[i].first.GetName(), sorted[i].second);
+        }
+        stream.Writef("}}");
+        break;
+      }
+
+      case OutputFormat::Csv:
+        for (auto [opcode, count] : sorted) {
+          stream.Writef("function,%s,%" PRIindex ",%s,%s,%" PRIu64 "\n",
+                        CsvField(filename).c_str(), func.func_index,
+                        opcode.GetName(), CsvField(func.name).c_str(), count);
+        }
+        break;
+    }
   }
-  return sum;
 }
 
-void WriteCounts(Stream& stream, const OpcodeInfoCounts& info_counts) {
-  using OpcodeCountPair = std::pair<Opcode, size_t>;
+static void WriteStats(Stream& stream, OpcodeStats& stats) {
+  std::vector<std::pair<Opcode, uint64_t>> counts;
+  for (size_t i = 0; i < kOpcodeCount; ++i) {
+    uint64_t count = stats.counts[i];
+    if (count > 0 && count >= s_cutoff) {
+      counts.emplace_back(static_cast<Opcode::Enum>(i), count);
+    }
+  }
+  SortByCountDescending(&counts);
+
+  std::vector<std::pair<OpcodeInfo, uint64_t>> counts_with_immediates;
+  for (size_t i = 0; i < kOpcodeCount; ++i) {
+    uint64_t count = stats.bare_counts[i];
+    if (count > 0 && count >= s_cutoff) {
+      counts_with_immediates.emplace_back(
+          OpcodeInfo(static_cast<Opcode::Enum>(i), OpcodeInfo::Kind::Bare),
+          count);
+    }
+  }
+  for (auto& [info, count] : stats.counts_with_immediates) {
+    if (count >= s_cutoff) {
+      counts_with_immediates.emplace_back(info, count);
+    }
+  }
+  // Sort in opcode info order first, so that is the order of elements with
+  // the same count.
+  std::sort(counts_with_immediates.begin(), counts_with_immediates.end(),
+            [](const auto& lhs, const auto& rhs) { return lhs.first < rhs.first; });
+  SortByCountDescending(&counts_with_immediates);
 
-  std::map<Opcode, size_t> counts;
-  for (auto& [info, count] : info_counts) {
-    Opcode opcode = info.opcode();
-    counts[opcode] += count;
+  std::vector<std::pair<size_t, uint64_t>> pair_counts;
+  for (size_t i = 0; i < stats.pair_counts.size(); ++i) {
+    uint64_t count = stats.pair_counts[i];
+    if (count > 0 && count >= s_cutoff) {
+      pair_counts.emplace_back(i, count);
+    }
   }
+  SortByCountDescending(&pair_counts);
+  auto pair_opcodes = [](size_t pair) {
+    return std::make_pair(Opcode(static_cast<Opcode::Enum>(pair / kOpcodeCount)),
+                          Opcode(static_cast<Opcode::Enum>(pair % kOpcodeCount)));
+  };
 
-  std::vector<OpcodeCountPair> sorted;
-  std::copy_if(counts.begin(), counts.end(), std::back_inserter(sorted),
-               WithinCutoff<OpcodeCountPair>());
+  switch (s_format) {
+    case OutputFormat::Text:
+      stream.Writef("Total opcodes: %" PRIu64 "\n\n", stats.total);
 
-  // Use a stable sort to keep the elements with the same count in opcode
-  // order (since the Opcode map is sorted).
-  std::stable_sort(sorted.begin(), sorted.end(),
-                   SortByCountDescending<OpcodeCountPair>());
+      stream.Writef("Opcode counts:\n");
+      for (auto& [opcode, count] : counts) {
+        stream.Writef("%s%s%" PRIu64 "\n", opcode.GetName(), s_separator,
+                      count);
+      }
 
-  for (auto& [opcode, count] : sorted) {
-    stream.Writef("%s%s%" PRIzd "\n", opcode.GetName(), s_separator, count);
-  }
-}
+      stream.Writef("\nOpcode counts with immediates:\n");
+      for (auto& [info, count] : counts_with_immediates) {
+        info.Write(stream);
+        stream.Writef("%s%" PRIu64 "\n", s_separator, count);
+      }
 
-void WriteCountsWithImmediates(Stream& stream, const OpcodeInfoCounts& counts) {
-  // Remove const from the key type so we can sort below.
-  using OpcodeInfoCountPair =
-      std::pair<std::remove_const<OpcodeInfoCounts::key_type>::type,
-                OpcodeInfoCounts::mapped_type>;
+      if (s_pairs) {
+        stream.Writef("\nOpcode pair counts:\n");
+        for (auto& [pair, count] : pair_counts) {
+          auto [first, second] = pair_opcodes(pair);
+          stream.Writef("%s %s%s%" PRIu64 "\n", first.GetName(),
+                        second.GetName(), s_separator, count);
+        }
+      }
+      break;
 
-  std::vector<OpcodeInfoCountPair> sorted;
-  std::copy_if(counts.begin(), counts.end(), std::back_inserter(sorted),
-               WithinCutoff<OpcodeInfoCountPair>());
+    case OutputFormat::Json: {
+      stream.Writef("  \"total\": %" PRIu64 ",\n", stats.total);
 
-  // Use a stable sort to keep the elements with the same count in opcode info
-  // order (since the OpcodeInfoCounts map is sorted).
-  std::stable_sort(sorted.begin(), sorted.end(),
-                   SortByCountDescending<OpcodeInfoCountPair>());
+      stream.Writef("  \"opcodes\": {");
+      JsonArray json_counts(stream, "    ");
+      for (auto& [opcode, count] : counts) {
+        json_counts.Element();
+        stream.Writef("\"%s\": %" PRIu64, opcode.GetName(), count);
+      }
+      json_counts.End();
+      stream.Writef("},\n");
 
-  for (auto& [info, count] : sorted) {
-    info.Write(stream);
-    stream.Writef("%s%" PRIzd "\n", s_separator, count);
+      stream.Writef("  \"immediates\": [");
+      JsonArray json_immediates(stream, "    ");
+      for (auto& [info, count] : counts_with_immediates) {
+        json_immediates.Element();
+        stream.Writef("{\"opcode\": \"%s\", \"immediates\": %s, "
+                      "\"count\": %" PRIu64 "}",
+                      info.opcode().GetName(),
+                      JsonString(GetImmediates(info)).c_str(), count);
+      }
+      json_immediates.End();
+      stream.Writef("]");
+
+      if (s_pairs) {
+        stream.Writef(",\n  \"pairs\": [");
+        JsonArray json_pairs(stream, "    ");
+        for (auto& [pair, count] : pair_counts) {
+          auto [first, second] = pair_opcodes(pair);
+          json_pairs.Element();
+          stream.Writef("{\"first\": \"%s\", \"second\": \"%s\", "
+                        "\"count\": %" PRIu64 "}",
+                        first.GetName(), second.GetName(), count);
+        }
+        json_pairs.End();
+        stream.Writef("]");
+      }
+      stream.Writef("\n}\n");
+      break;
+    }
+
+    case OutputFormat::Csv:
+      stream.Writef("total,,,,,%" PRIu64 "\n", stats.total);
+      for (auto& [opcode, count] : counts) {
+        stream.Writef("opcode,,,%s,,%" PRIu64 "\n", opcode.GetName(), count);
+      }
+      for (auto& [info, count] : counts_with_immediates) {
+        stream.Writef("immediates,,,%s,%s,%" PRIu64 "\n",
+                      info.opcode().GetName(),
+                      CsvField(GetImmediates(info)).c_str(), count);
+      }
+      for (auto& [pair, count] : pair_counts) {
+        auto [first, second] = pair_opcodes(pair);
+        stream.Writef("pair,,,%s,%s,%" PRIu64 "\n", first.GetName(),
+                      second.GetName(), count);
+      }
+      break;
   }
 }
 
@@ -144,31 +432,71 @@ int ProgramMain(int argc, char** argv) {
   InitStdio();
   ParseOptions(argc, argv);
 
-  std::vector<uint8_t> file_data;
-  Result result = ReadFile(s_infile, &file_data);
-  if (Failed(result)) {
-    const char* input_name = s_infile ? s_infile : "stdin";
-    ERROR("Unable to parse: %s", input_name);
+  FunctionWeights weights;
+  if (s_weights_file && Failed(ReadWeights(s_weights_file, &weights))) {
     return 1;
   }
 
   FileStream stream(s_outfile ? FileStream(s_outfile) : FileStream(stdout));
+  switch (s_format) {
+    case OutputFormat::Text:
+      break;
+    case OutputFormat::Json:
+      stream.Writef("{\n");
+      if (s_per_function) {
+        stream.Writef("  \"functions\": [");
+      }
+      break;
+    case OutputFormat::Csv:
+      stream.Writef("kind,module,function,opcode,detail,count\n");
+      break;
+  }
 
-  if (Succeeded(result)) {
-    OpcodeInfoCounts counts;
-    s_read_binary_options.features = s_features;
-    result = ReadBinaryOpcnt(file_data.data(), file_data.size(),
-                             s_read_binary_options, &counts);
-    if (Succeeded(result)) {
-      stream.Writef("Total opcodes: %" PRIzd "\n\n", SumCounts(counts));
+  // The per-function counts are written as each module is read, so that they
+  // don't have to be kept for the whole set.
+  Result result = Result::Ok;
+  OpcodeStats stats;
+  JsonArray json_functions(stream, "    ");
+  s_read_binary_options.features = s_features;
+  s_read_binary_options.read_debug_names = s_per_function;
+  for (const std::string& infile : s_infiles) {
+    std::vector<uint8_t> file_data;
+    if (Failed(ReadFile(infile.c_str(), &file_data))) {
+      ERROR("Unable to parse: %s", infile.c_str());
+      return 1;
+    }
 
-      stream.Writef("Opcode counts:\n");
-      WriteCounts(stream, counts);
+    std::map<Index, uint64_t> module_weights;
+    ReadOpcntOptions opcnt_options;
+    opcnt_options.count_pairs = s_pairs;
+    if (s_weights_file) {
+      module_weights = weights[""];
+      for (auto& [func_index, count] : weights[infile]) {
+        module_weights[func_index] = count;
+      }
+      opcnt_options.function_weights = &module_weights;
+    }
+    std::vector<FunctionOpcodeCounts> functions;
+    if (s_per_function) {
+      opcnt_options.functions = &functions;
+    }
 
-      stream.Writef("\nOpcode counts with immediates:\n");
-      WriteCountsWithImmediates(stream, counts);
+    result = ReadBinaryOpcnt(file_data.data(), file_data.size(),
+                             s_read_binary_options, opcnt_options, &stats);
+    if (Failed(result)) {
+      break;
     }
+    WriteFunctions(stream, infile, functions, &json_functions);
+  }
+
+  if (s_format == OutputFormat::Json && s_per_function) {
+    json_functions.End();
+    stream.Writef("],\n");
+  }
+  if (Succeeded(result)) {
+    WriteStats(stream, stats);
   }
+  result |= stream.Close();
 
   return result != Result::Ok;
 }
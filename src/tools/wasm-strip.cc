@@ -13,22 +13,32 @@
  * See the License for the specific language governing permissions and
  * limitations under the License.
  */
+#include <algorithm>
+#include <cerrno>
 #include <set>
 
 #include "wabt/binary-reader-nop.h"
 #include "wabt/binary-reader.h"
 #include "wabt/binary.h"
+#include "wabt/config.h"
 #include "wabt/error-formatter.h"
 #include "wabt/leb128.h"
 #include "wabt/option-parser.h"
 #include "wabt/stream.h"
 
+#if HAVE_UNISTD_H
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
 using namespace wabt;
 
 static std::string s_filename;
 static std::string s_outfile;
 static std::set<std::string_view> v_sections_to_keep{};
 static std::set<std::string_view> v_sections_to_remove{};
+static bool s_no_check = false;
 
 static const char s_description[] =
     R"(  Remove sections of a WebAssembly binary file.
@@ -58,9 +68,23 @@ static void ParseOptions(int argc, char** argv) {
                    [](const char* value) {
                      v_sections_to_remove.insert(std::string_view{value});
                    });
+  parser.AddOption("no-check",
+                   "Only read the section headers, without checking the "
+                   "sections that are kept, and copy those sections without "
+                   "loading them into memory",
+                   []() { s_no_check = true; });
   parser.Parse(argc, argv);
 }
 
+static bool KeepCustomSection(const std::set<std::string_view>& to_keep,
+                              const std::set<std::string_view>& to_remove,
+                              std::string_view section_name) {
+  if (to_remove.count(section_name) > 0) {
+    return false;
+  }
+  return to_keep.count(section_name) > 0 || !to_remove.empty();
+}
+
 class BinaryReaderStrip : public BinaryReaderNop {
  public:
   explicit BinaryReaderStrip(std::set<std::string_view> sections_to_keep,
@@ -99,12 +123,8 @@ class BinaryReaderStrip : public BinaryReaderNop {
   Result BeginCustomSection(Index section_index,
                             Offset size,
                             std::string_view section_name) override {
-    if (sections_to_remove_.count(section_name) > 0) {
-      return Result::Ok;
-    }
-
-    if (sections_to_keep_.count(section_name) > 0 ||
-        !sections_to_remove_.empty()) {
+    if (KeepCustomSection(sections_to_keep_, sections_to_remove_,
+                          section_name)) {
       stream_.WriteU8Enum(BinarySection::Custom, "section code");
       WriteU32Leb128(&stream_, size, "section size");
       stream_.WriteData(state->data + section_start_, size, "section data");
@@ -120,12 +140,285 @@ class BinaryReaderStrip : public BinaryReaderNop {
   Offset section_start_;
 };
 
+#if HAVE_UNISTD_H
+
+// With --no-check, the file is never read into memory. Only the section
+// headers are read, and the kept sections are copied from the input file to
+// the output file, by the kernel where possible. When the output is the input
+// file, the kept sections are moved down in place, and the file truncated; if
+// only trailing sections are removed, nothing but the truncation is needed.
+
+struct SectionHeader {
+  BinarySection code;
+  Offset offset;          // Of the section code.
+  Offset payload_offset;  // Of the contents, after the section size.
+  Offset size;
+};
+
+static const size_t kCopyBufferSize = 1 << 20;
+
+static bool PreadAll(int fd, void* data, size_t size, Offset offset) {
+  while (size > 0) {
+    ssize_t n = pread(fd, data, size, offset);
+    if (n < 0 && errno == EINTR) {
+      continue;
+    }
+    if (n <= 0) {
+      return false;
+    }
+    data = static_cast<uint8_t*>(data) + n;
+    size -= n;
+    offset += n;
+  }
+  return true;
+}
+
+static bool PwriteAll(int fd, const void* data, size_t size, Offset offset) {
+  while (size > 0) {
+    ssize_t n = pwrite(fd, data, size, offset);
+    if (n < 0 && errno == EINTR) {
+      continue;
+    }
+    if (n <= 0) {
+      return false;
+    }
+    data = static_cast<const uint8_t*>(data) + n;
+    size -= n;
+    offset += n;
+  }
+  return true;
+}
+
+// Copies |size| bytes from |src| in |in_fd| to |dst| in |out_fd|. The two may
+// be the same file, as long as |dst| <= |src|.
+static bool CopyRange(int in_fd,
+                      Offset src,
+                      int out_fd,
+                      Offset dst,
+                      Offset size) {
+#if HAVE_COPY_FILE_RANGE
+  // copy_file_range doesn't support overlapping ranges in one file.
+  if (in_fd != out_fd || src - dst >= size) {
+    while (size > 0) {
+      off_t in_offset = src;
+      off_t out_offset = dst;
+      ssize_t n =
+          copy_file_range(in_fd, &in_offset, out_fd, &out_offset, size, 0);
+      if (n < 0 && errno == EINTR) {
+        continue;
+      }
+      if (n <= 0) {
+        // Not supported for these files; copy the rest below.
+        break;
+      }
+      src += n;
+      dst += n;
+      size -= n;
+    }
+  }
+#endif
+  // Copying in increasing order is safe for overlapping ranges, since each
+  // chunk is read before it can be overwritten.
+  std::vector<uint8_t> buffer(std::min<Offset>(size, kCopyBufferSize));
+  while (size > 0) {
+    size_t n = std::min<Offset>(size, buffer.size());
+    if (!PreadAll(in_fd, buffer.data(), n, src) ||
+        !PwriteAll(out_fd, buffer.data(), n, dst)) {
+      return false;
+    }
+    src += n;
+    dst += n;
+    size -= n;
+  }
+  return true;
+}
+
+static Result ReadSectionHeaders(int fd,
+                                 Offset file_size,
+                                 std::vector<SectionHeader>* sections,
+                                 Errors* errors) {
+  auto error = [&](Offset offset, const char* message) {
+    errors->emplace_back(ErrorLevel::Error, Location(offset), message);
+    return Result::Error;
+  };
+
+  uint8_t header[8];
+  if (file_size < sizeof(header) ||
+      !PreadAll(fd, header, sizeof(header), 0)) {
+    return error(0, "unable to read magic");
+  }
+  uint32_t magic = header[0] | header[1] << 8 | header[2] << 16 |
+                   static_cast<uint32_t>(header[3]) << 24;
+  if (magic != WABT_BINARY_MAGIC) {
+    return error(4, "bad magic value");
+  }
+  uint16_t version = header[4] | header[5] << 8;
+  uint16_t layer = header[6] | header[7] << 8;
+  if (version != WABT_BINARY_VERSION || layer != WABT_BINARY_LAYER_MODULE) {
+    return error(8, "bad wasm file version");
+  }
+
+  Offset offset = sizeof(header);
+  while (offset < file_size) {
+    // The section code, size and custom section name length.
+    uint8_t data[11];
+    size_t data_size = std::min<Offset>(sizeof(data), file_size - offset);
+    if (!PreadAll(fd, data, data_size, offset)) {
+      return error(offset, "unable to read section header");
+    }
+    if (data[0] >= kBinarySectionCount) {
+      return error(offset, "invalid section code");
+    }
+    uint32_t size;
+    size_t size_length = ReadU32Leb128(data + 1, data + data_size, &size);
+    if (size_length == 0) {
+      return error(offset + 1, "unable to read section size");
+    }
+
+    SectionHeader section;
+    section.code = static_cast<BinarySection>(data[0]);
+    section.offset = offset;
+    section.payload_offset = offset + 1 + size_length;
+    section.size = size;
+    if (section.size > file_size - section.payload_offset) {
+      return error(offset, "invalid section size: extends past end");
+    }
+    sections->push_back(section);
+    offset = section.payload_offset + section.size;
+  }
+  return Result::Ok;
+}
+
+static Result ReadCustomSectionName(int fd,
+                                    const SectionHeader& section,
+                                    std::string* name,
+                                    Errors* errors) {
+  uint8_t data[5];
+  size_t data_size = std::min<Offset>(sizeof(data), section.size);
+  uint32_t name_size;
+  size_t name_size_length = 0;
+  if (PreadAll(fd, data, data_size, section.payload_offset)) {
+    name_size_length = ReadU32Leb128(data, data + data_size, &name_size);
+  }
+  if (name_size_length != 0 && name_size <= section.size - name_size_length) {
+    name->resize(name_size);
+    if (PreadAll(fd, &(*name)[0], name_size,
+                 section.payload_offset + name_size_length)) {
+      return Result::Ok;
+    }
+  }
+  errors->emplace_back(ErrorLevel::Error, Location(section.payload_offset),
+                       "unable to read section name");
+  return Result::Error;
+}
+
+static Result StripWithoutLoading(Errors* errors) {
+  struct stat in_stat;
+  struct stat out_stat;
+  if (stat(s_filename.c_str(), &in_stat) != 0) {
+    fprintf(stderr, "unable to read file: %s\n", s_filename.c_str());
+    return Result::Error;
+  }
+  bool in_place = stat(s_outfile.c_str(), &out_stat) == 0 &&
+                  out_stat.st_dev == in_stat.st_dev &&
+                  out_stat.st_ino == in_stat.st_ino;
+
+  int fd = open(s_filename.c_str(), in_place ? O_RDWR : O_RDONLY);
+  if (fd < 0) {
+    fprintf(stderr, "unable to open file: %s\n", s_filename.c_str());
+    return Result::Error;
+  }
+
+  Result result = Result::Ok;
+  int out_fd = fd;
+  std::vector<SectionHeader> sections;
+  result = ReadSectionHeaders(fd, in_stat.st_size, &sections, errors);
+
+  // Every section to keep is known before anything is written, since writing
+  // in place overwrites the input. Like ReadBinary with
+  // kFailOnCustomSectionError unset, a custom section whose name can't be
+  // read is reported and removed, without failing.
+  std::vector<SectionHeader> kept_sections;
+  for (const SectionHeader& section : sections) {
+    if (Failed(result)) {
+      break;
+    }
+    if (section.code == BinarySection::Custom) {
+      std::string name;
+      if (Failed(ReadCustomSectionName(fd, section, &name, errors)) ||
+          !KeepCustomSection(v_sections_to_keep, v_sections_to_remove, name)) {
+        continue;
+      }
+    }
+    kept_sections.push_back(section);
+  }
+
+  if (Succeeded(result) && !in_place) {
+    out_fd = open(s_outfile.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0666);
+    if (out_fd < 0) {
+      fprintf(stderr, "unable to open file: %s\n", s_outfile.c_str());
+      result = Result::Error;
+    } else if (!CopyRange(fd, 0, out_fd, 0, 8)) {
+      result = Result::Error;
+    }
+  }
+
+  Offset out_offset = 8;
+  for (const SectionHeader& section : kept_sections) {
+    if (Failed(result)) {
+      break;
+    }
+
+    // The section size is rewritten with its shortest encoding, as
+    // BinaryReaderStrip does.
+    uint8_t header[1 + 5];
+    header[0] = static_cast<uint8_t>(section.code);
+    size_t header_size =
+        1 + WriteU32Leb128Raw(header + 1, header + sizeof(header), section.size);
+    if (!in_place || out_offset != section.offset ||
+        section.payload_offset - section.offset != header_size) {
+      if (!PwriteAll(out_fd, header, header_size, out_offset) ||
+          !CopyRange(fd, section.payload_offset, out_fd,
+                     out_offset + header_size, section.size)) {
+        fprintf(stderr, "unable to write file: %s\n", s_outfile.c_str());
+        result = Result::Error;
+      }
+    }
+    out_offset += header_size + section.size;
+  }
+
+  if (Succeeded(result) && in_place && ftruncate(fd, out_offset) != 0) {
+    fprintf(stderr, "unable to truncate file: %s\n", s_outfile.c_str());
+    result = Result::Error;
+  }
+  if (out_fd >= 0 && out_fd != fd) {
+    close(out_fd);
+  }
+  close(fd);
+  return result;
+}
+
+#endif
+
 int ProgramMain(int argc, char** argv) {
   Result result;
 
   InitStdio();
   ParseOptions(argc, argv);
 
+  if (s_outfile.empty()) {
+    s_outfile = s_filename;
+  }
+
+#if HAVE_UNISTD_H
+  if (s_no_check) {
+    Errors errors;
+    result = StripWithoutLoading(&errors);
+    FormatErrorsToFile(errors, Location::Type::Binary);
+    return result;
+  }
+#endif
+
   std::vector<uint8_t> file_data;
   result = ReadFile(s_filename.c_str(), &file_data);
   if (Failed(result)) {
@@ -148,9 +441,6 @@ int ProgramMain(int argc, char** argv) {
     return Result::Error;
   }
 
-  if (s_outfile.empty()) {
-    s_outfile = s_filename;
-  }
   return reader.WriteToFile(s_outfile);
 }
 
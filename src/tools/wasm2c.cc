@@ -18,6 +18,7 @@
 #include <cinttypes>
 #include <cstdio>
 #include <cstdlib>
+#include <cstring>
 
 #include "wabt/apply-names.h"
 #include "wabt/binary-reader-ir.h"
@@ -43,6 +44,8 @@ static std::string s_outfile;
 static unsigned int s_num_outputs = 1;
 static WriteCOptions s_write_c_options;
 static bool s_read_debug_names = true;
+static bool s_report_bounds_checks = false;
+static BoundsCheckStats s_bounds_check_stats;
 static std::unique_ptr<FileStream> s_log_stream;
 
 static const char s_description[] =
@@ -57,16 +60,6 @@ examples:
   $ wasm2c test.wasm --no-debug-names -o test.c
 )";
 
-static const std::string supported_features[] = {
-    "multi-memory", "multi-value", "sign-extension", "saturating-float-to-int",
-    "exceptions",   "memory64",    "extended-const", "simd",
-    "threads",      "tail-call"};
-
-static bool IsFeatureSupported(const std::string& feature) {
-  return std::find(std::begin(supported_features), std::end(supported_features),
-                   feature) != std::end(supported_features);
-};
-
 static void ParseOptions(int argc, char** argv) {
   OptionParser parser("wasm2c", s_description);
 
@@ -92,8 +85,34 @@ static void ParseOptions(int argc, char** argv) {
       "file is used as the default.\n",
       [](const char* argument) { s_write_c_options.module_name = argument; });
   s_write_c_options.features.AddOptions(&parser);
+  parser.AddOption("shortest-floats",
+                   "Write float constants as shortest round-trip decimals",
+                   []() { s_write_c_options.shortest_floats = true; });
+  parser.AddOption(
+      '\0', "exception-lowering", "MODE",
+      "How to implement exception handling: \"setjmp\" (the default) saves\n"
+      "an unwind target in each try block, \"checked\" tests a\n"
+      "pending-exception flag after each call",
+      [](const char* argument) {
+        if (strcmp(argument, "setjmp") == 0) {
+          s_write_c_options.exception_lowering = ExceptionLowering::Setjmp;
+        } else if (strcmp(argument, "checked") == 0) {
+          s_write_c_options.exception_lowering = ExceptionLowering::Checked;
+        } else {
+          fprintf(stderr, "Unknown exception lowering: %s\n", argument);
+          exit(1);
+        }
+      });
   parser.AddOption("no-debug-names", "Ignore debug names in the binary file",
                    []() { s_read_debug_names = false; });
+  parser.AddOption("report-bounds-checks",
+                   "Print how many loads and stores were proven in bounds\n"
+                   "and are written without a bounds check",
+                   []() {
+                     s_report_bounds_checks = true;
+                     s_write_c_options.bounds_check_stats =
+                         &s_bounds_check_stats;
+                   });
   parser.AddArgument("filename", OptionParser::ArgumentCount::One,
                      [](const char* argument) {
                        s_infile = argument;
@@ -101,16 +120,7 @@ static void ParseOptions(int argc, char** argv) {
                      });
   parser.Parse(argc, argv);
 
-  bool any_non_supported_feature = false;
-#define WABT_FEATURE(variable, flag, default_, help)                   \
-  any_non_supported_feature |=                                         \
-      (s_write_c_options.features.variable##_enabled() != default_) && \
-      s_write_c_options.features.variable##_enabled() &&               \
-      !IsFeatureSupported(flag);
-#include "wabt/feature.def"
-#undef WABT_FEATURE
-
-  if (any_non_supported_feature) {
+  if (!AreCWriterFeaturesSupported(s_write_c_options.features)) {
     fprintf(stderr,
             "wasm2c currently only supports a limited set of features.\n");
     exit(1);
@@ -143,20 +153,21 @@ Result Wasm2cMain(Errors& errors) {
   if (!s_outfile.empty()) {
     std::string header_name_full =
         std::string(wabt::StripExtension(s_outfile)) + ".h";
-    std::vector<FileStream> c_streams;
+    std::vector<std::string> c_filenames;
     if (s_num_outputs == 1) {
-      c_streams.emplace_back(s_outfile.c_str());
+      c_filenames.push_back(s_outfile);
     } else {
       std::string output_prefix{wabt::StripExtension(s_outfile)};
       for (unsigned int i = 0; i < s_num_outputs; i++) {
-        c_streams.emplace_back(output_prefix + "_" + std::to_string(i) + ".c");
+        c_filenames.push_back(output_prefix + "_" + std::to_string(i) + ".c");
       }
     }
+    std::vector<MemoryStream> c_streams(c_filenames.size());
     std::vector<Stream*> c_stream_ptrs;
     for (auto& s : c_streams) {
       c_stream_ptrs.emplace_back(&s);
     }
-    FileStream h_stream(header_name_full);
+    MemoryStream h_stream;
     std::string_view header_name = GetBasename(header_name_full);
     if (s_write_c_options.module_name.empty()) {
       s_write_c_options.module_name = module.name;
@@ -172,12 +183,21 @@ Result Wasm2cMain(Errors& errors) {
     } else {
       std::string header_impl_name_full =
           std::string(wabt::StripExtension(s_outfile)) + "-impl.h";
-      FileStream h_impl_stream(header_impl_name_full);
+      MemoryStream h_impl_stream;
       std::string_view header_impl_name = GetBasename(header_impl_name_full);
       CHECK_RESULT(WriteC(std::move(c_stream_ptrs), &h_stream, &h_impl_stream,
                           std::string(header_name).c_str(),
                           std::string(header_impl_name).c_str(), &module,
                           s_write_c_options));
+      CHECK_RESULT(h_impl_stream.output_buffer().WriteToFileIfChanged(
+          header_impl_name_full));
+    }
+    // Outputs that haven't changed are left alone, so that a build only
+    // recompiles the ones that have.
+    CHECK_RESULT(h_stream.output_buffer().WriteToFileIfChanged(header_name_full));
+    for (size_t i = 0; i < c_filenames.size(); i++) {
+      CHECK_RESULT(
+          c_streams[i].output_buffer().WriteToFileIfChanged(c_filenames[i]));
     }
   } else {
     FileStream stream(stdout);
@@ -185,6 +205,16 @@ Result Wasm2cMain(Errors& errors) {
                         s_write_c_options));
   }
 
+  if (s_report_bounds_checks) {
+    size_t accesses = s_bounds_check_stats.accesses;
+    size_t unchecked = s_bounds_check_stats.unchecked;
+    fprintf(stderr,
+            "%" PRIzd " of %" PRIzd
+            " loads and stores written without a bounds check (%.1f%%)\n",
+            unchecked, accesses,
+            accesses ? 100.0 * unchecked / accesses : 0.0);
+  }
+
   return Result::Ok;
 }
 
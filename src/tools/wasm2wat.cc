@@ -42,6 +42,7 @@ static bool s_generate_names;
 static bool s_fold_exprs;
 static bool s_inline_import;
 static bool s_inline_export;
+static bool s_decimal_floats;
 static bool s_read_debug_names = true;
 static bool s_fail_on_custom_section_error = true;
 static std::unique_ptr<FileStream> s_log_stream;
@@ -80,6 +81,10 @@ static void ParseOptions(int argc, char** argv) {
                    []() { s_inline_export = true; });
   parser.AddOption("inline-imports", "Write all imports inline",
                    []() { s_inline_import = true; });
+  parser.AddOption("decimal-floats",
+                   "Write float constants as shortest round-trip decimals "
+                   "instead of hexfloats",
+                   []() { s_decimal_floats = true; });
   parser.AddOption("no-debug-names", "Ignore debug names in the binary file",
                    []() { s_read_debug_names = false; });
   parser.AddOption("ignore-custom-section-errors",
@@ -138,9 +143,11 @@ int ProgramMain(int argc, char** argv) {
         wat_options.fold_exprs = s_fold_exprs;
         wat_options.inline_import = s_inline_import;
         wat_options.inline_export = s_inline_export;
+        wat_options.decimal_floats = s_decimal_floats;
         FileStream stream(!s_outfile.empty() ? FileStream(s_outfile)
                                              : FileStream(stdout));
         result = WriteWat(&stream, &module, wat_options);
+        result |= stream.Close();
       }
     }
     FormatErrorsToFile(errors, Location::Type::Binary);
@@ -20,6 +20,7 @@
 #include <cstdio>
 #include <cstdlib>
 #include <string>
+#include <vector>
 
 #include "wabt/config.h"
 
@@ -44,6 +45,7 @@ static int s_verbose;
 static WriteBinaryOptions s_write_binary_options;
 static bool s_validate = true;
 static bool s_debug_parsing;
+static bool s_stream;
 static Features s_features;
 
 static std::unique_ptr<FileStream> s_log_stream;
@@ -93,6 +95,10 @@ static void ParseOptions(int argc, char* argv[]) {
                    []() { s_write_binary_options.write_debug_names = true; });
   parser.AddOption("no-check", "Don't check for invalid modules",
                    []() { s_validate = false; });
+  parser.AddOption("stream",
+                   "Parse, check and write one function body at a time, "
+                   "rather than holding the whole module in memory",
+                   []() { s_stream = true; });
   parser.AddArgument("filename", OptionParser::ArgumentCount::One,
                      [](const char* argument) { s_infile = argument; });
 
@@ -118,6 +124,86 @@ static void WriteBufferToFile(std::string_view filename,
   }
 }
 
+// Parses each deferred function body as the binary writer reaches it, checks
+// it, and frees it again once it has been written.
+class WatFuncBodySource : public FuncBodySource {
+ public:
+  WatFuncBodySource(WastLexer* lexer,
+                    Module* module,
+                    const std::vector<WastFuncBody>& bodies,
+                    StreamingModuleValidator* validator,
+                    Errors* errors,
+                    WastParseOptions* options)
+      : lexer_(lexer),
+        module_(module),
+        bodies_(bodies),
+        validator_(validator),
+        errors_(errors),
+        options_(options) {}
+
+  Result BeginFuncBody(Index func_index) override {
+    Func* func = module_->funcs[func_index];
+    const WastFuncBody& body = bodies_[func_index - module_->num_func_imports];
+    CHECK_RESULT(
+        ParseWatFuncBody(lexer_, body, module_, func, errors_, options_));
+    if (validator_) {
+      result_ |= validator_->CheckFuncBody(func);
+    }
+    return Result::Ok;
+  }
+
+  void EndFuncBody(Index func_index) override {
+    module_->funcs[func_index]->exprs.clear();
+  }
+
+  // Whether every body checked so far was valid.
+  Result result() const { return result_; }
+
+ private:
+  WastLexer* lexer_;
+  Module* module_;
+  const std::vector<WastFuncBody>& bodies_;
+  StreamingModuleValidator* validator_;
+  Errors* errors_;
+  WastParseOptions* options_;
+  Result result_ = Result::Ok;
+};
+
+static Result WriteModuleStreaming(WastLexer* lexer,
+                                   Module* module,
+                                   const std::vector<WastFuncBody>& bodies,
+                                   Errors* errors,
+                                   WastParseOptions* parse_wast_options,
+                                   Stream* stream) {
+  std::unique_ptr<StreamingModuleValidator> validator;
+  Result result = Result::Ok;
+  if (s_validate) {
+    ValidateOptions options(s_features);
+    validator =
+        std::make_unique<StreamingModuleValidator>(errors, module, options);
+    result |= validator->BeginModule();
+  }
+
+  WatFuncBodySource func_bodies(lexer, module, bodies, validator.get(), errors,
+                                parse_wast_options);
+  if (Succeeded(result)) {
+    CHECK_RESULT(WriteBinaryModule(stream, module, s_write_binary_options,
+                                   &func_bodies));
+  } else {
+    // The declarations are invalid, so the module can't be written; just
+    // check the bodies to report any errors in them too.
+    for (Index i = module->num_func_imports; i < module->funcs.size(); ++i) {
+      CHECK_RESULT(func_bodies.BeginFuncBody(i));
+      func_bodies.EndFuncBody(i);
+    }
+  }
+  result |= func_bodies.result();
+  if (validator) {
+    result |= validator->EndModule();
+  }
+  return result;
+}
+
 static std::string DefaultOuputName(std::string_view input_name) {
   // Strip existing extension and add .wasm
   std::string result(StripExtension(GetBasename(input_name)));
@@ -141,10 +227,16 @@ int ProgramMain(int argc, char** argv) {
   }
 
   std::unique_ptr<Module> module;
+  std::vector<WastFuncBody> func_bodies;
   WastParseOptions parse_wast_options(s_features);
+  if (s_stream) {
+    parse_wast_options.deferred_func_bodies = &func_bodies;
+  }
   result = ParseWatModule(lexer.get(), &module, &errors, &parse_wast_options);
 
-  if (Succeeded(result) && s_validate) {
+  // Modules given in binary form have no deferred bodies.
+  bool streaming = Succeeded(result) && !func_bodies.empty();
+  if (Succeeded(result) && s_validate && !streaming) {
     ValidateOptions options(s_features);
     result = ValidateModule(module.get(), &errors, options);
   }
@@ -152,7 +244,12 @@ int ProgramMain(int argc, char** argv) {
   if (Succeeded(result)) {
     MemoryStream stream(s_log_stream.get());
     s_write_binary_options.features = s_features;
-    result = WriteBinaryModule(&stream, module.get(), s_write_binary_options);
+    if (streaming) {
+      result = WriteModuleStreaming(lexer.get(), module.get(), func_bodies,
+                                    &errors, &parse_wast_options, &stream);
+    } else {
+      result = WriteBinaryModule(&stream, module.get(), s_write_binary_options);
+    }
 
     if (Succeeded(result)) {
       if (s_outfile.empty()) {
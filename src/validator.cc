@@ -93,6 +93,13 @@ class Validator : public ExprVisitor::Delegate {
 
   Result CheckModule();
 
+  // CheckModule, split up so that function bodies can be checked one at a
+  // time: BeginModule checks everything before the code section, and
+  // EndModule everything after it.
+  Result BeginModule();
+  Result CheckFuncBody(const Func* func, Index func_index);
+  Result EndModule();
+
   Result OnBinaryExpr(BinaryExpr*) override;
   Result BeginBlockExpr(BlockExpr*) override;
   Result EndBlockExpr(BlockExpr*) override;
@@ -697,6 +704,19 @@ Validator::Validator(Errors* errors,
       current_module_(module) {}
 
 Result Validator::CheckModule() {
+  BeginModule();
+
+  Index func_index = current_module_->num_func_imports;
+  for (const ModuleField& field : current_module_->fields) {
+    if (auto* f = dyn_cast<FuncModuleField>(&field)) {
+      CheckFuncBody(&f->func, func_index++);
+    }
+  }
+
+  return EndModule();
+}
+
+Result Validator::BeginModule() {
   const Module* module = current_module_;
 
   // Type section.
@@ -878,25 +898,28 @@ Result Validator::CheckModule() {
   // DataCount section.
   validator_.OnDataCount(module->data_segments.size());
 
-  // Code section.
-  Index func_index = module->num_func_imports;
-  for (const ModuleField& field : module->fields) {
-    if (auto* f = dyn_cast<FuncModuleField>(&field)) {
-      const Location& body_start = f->func.loc;
-      const Location& body_end =
-          f->func.exprs.empty() ? body_start : f->func.exprs.back().loc;
-      result_ |= validator_.BeginFunctionBody(body_start, func_index++);
+  return result_;
+}
 
-      for (auto&& decl : f->func.local_types.decls()) {
-        result_ |= validator_.OnLocalDecl(body_start, decl.second, decl.first);
-      }
+Result Validator::CheckFuncBody(const Func* func, Index func_index) {
+  const Location& body_start = func->loc;
+  const Location& body_end =
+      func->exprs.empty() ? body_start : func->exprs.back().loc;
+  result_ |= validator_.BeginFunctionBody(body_start, func_index);
 
-      ExprVisitor visitor(this);
-      result_ |= visitor.VisitExprList(const_cast<ExprList&>(f->func.exprs));
-      result_ |= validator_.EndFunctionBody(body_end);
-    }
+  for (auto&& decl : func->local_types.decls()) {
+    result_ |= validator_.OnLocalDecl(body_start, decl.second, decl.first);
   }
 
+  ExprVisitor visitor(this);
+  result_ |= visitor.VisitExprList(const_cast<ExprList&>(func->exprs));
+  result_ |= validator_.EndFunctionBody(body_end);
+  return result_;
+}
+
+Result Validator::EndModule() {
+  const Module* module = current_module_;
+
   // Data segment section.
   for (const ModuleField& field : module->fields) {
     if (auto* f = dyn_cast<DataSegmentModuleField>(&field)) {
@@ -1106,4 +1129,33 @@ Result ValidateModule(const Module* module,
   return validator.CheckModule();
 }
 
+struct StreamingModuleValidator::Impl {
+  Impl(Errors* errors, const Module* module, const ValidateOptions& options)
+      : options(options), validator(errors, module, this->options) {}
+
+  ValidateOptions options;
+  Validator validator;
+};
+
+StreamingModuleValidator::StreamingModuleValidator(
+    Errors* errors,
+    const Module* module,
+    const ValidateOptions& options)
+    : impl_(std::make_unique<Impl>(errors, module, options)),
+      func_index_(module->num_func_imports) {}
+
+StreamingModuleValidator::~StreamingModuleValidator() = default;
+
+Result StreamingModuleValidator::BeginModule() {
+  return impl_->validator.BeginModule();
+}
+
+Result StreamingModuleValidator::CheckFuncBody(const Func* func) {
+  return impl_->validator.CheckFuncBody(func, func_index_++);
+}
+
+Result StreamingModuleValidator::EndModule() {
+  return impl_->validator.EndModule();
+}
+
 }  // namespace wabt
@@ -21,6 +21,13 @@
 
 #include "wabt/config.h"
 
+#if defined(__SSE2__) || defined(_M_X64) || \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#elif (defined(__ARM_NEON) && !defined(__ARM_BIG_ENDIAN)) || defined(_M_ARM64)
+#include <arm_neon.h>
+#endif
+
 #include "wabt/lexer-source.h"
 
 #define ERROR(...) Error(GetLocation(), __VA_ARGS__)
@@ -38,6 +45,148 @@ namespace {
 #pragma clang diagnostic pop
 #endif
 
+// Most of the input is made up of runs of bytes that the lexer skips over
+// without looking at them individually: indentation, comment text, string
+// contents and identifier characters. These are scanned 16 bytes at a time
+// when SIMD is available. Each character set below provides a scalar Stop
+// test, and a vector version that returns a mask of the lanes to stop at.
+
+#if defined(__SSE2__) || defined(_M_X64) || \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define WABT_LEXER_SSE2 1
+#elif (defined(__ARM_NEON) && !defined(__ARM_BIG_ENDIAN)) || defined(_M_ARM64)
+#define WABT_LEXER_NEON 1
+#endif
+
+#if WABT_LEXER_SSE2
+
+using Vec = __m128i;
+
+Vec Load(const char* p) {
+  return _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+}
+Vec Eq(Vec v, char c) {
+  return _mm_cmpeq_epi8(v, _mm_set1_epi8(c));
+}
+Vec InRange(Vec v, char lo, char hi) {  // Unsigned, inclusive.
+  return _mm_and_si128(
+      _mm_cmpeq_epi8(_mm_max_epu8(v, _mm_set1_epi8(lo)), v),
+      _mm_cmpeq_epi8(_mm_min_epu8(v, _mm_set1_epi8(hi)), v));
+}
+Vec Or(Vec a, Vec b) {
+  return _mm_or_si128(a, b);
+}
+Vec Not(Vec v) {
+  return _mm_xor_si128(v, _mm_set1_epi8(-1));
+}
+// Returns the index of the first lane set in |mask|, or -1 if there is none.
+int FindFirst(Vec mask) {
+  unsigned bits = _mm_movemask_epi8(mask);
+  return bits ? Ctz(bits) : -1;
+}
+
+#elif WABT_LEXER_NEON
+
+using Vec = uint8x16_t;
+
+Vec Load(const char* p) {
+  return vld1q_u8(reinterpret_cast<const uint8_t*>(p));
+}
+Vec Eq(Vec v, char c) {
+  return vceqq_u8(v, vdupq_n_u8(c));
+}
+Vec InRange(Vec v, char lo, char hi) {  // Unsigned, inclusive.
+  return vandq_u8(vcgeq_u8(v, vdupq_n_u8(lo)), vcleq_u8(v, vdupq_n_u8(hi)));
+}
+Vec Or(Vec a, Vec b) {
+  return vorrq_u8(a, b);
+}
+Vec Not(Vec v) {
+  return vmvnq_u8(v);
+}
+// Returns the index of the first lane set in |mask|, or -1 if there is none.
+int FindFirst(Vec mask) {
+  // Narrow each lane to 4 bits, giving a 64-bit mask.
+  uint64_t bits = vget_lane_u64(
+      vreinterpret_u64_u8(vshrn_n_u16(vreinterpretq_u16_u8(mask), 4)), 0);
+  return bits ? Ctz(bits) / 4 : -1;
+}
+
+#endif
+
+// Stops at anything other than ' ', '\t' or '\r'; newlines are handled by the
+// caller, since they update the line number.
+struct NonBlankChars {
+  static bool Stop(uint8_t c) { return c != ' ' && c != '\t' && c != '\r'; }
+#if WABT_LEXER_SSE2 || WABT_LEXER_NEON
+  static Vec Stop(Vec v) {
+    return Not(Or(Or(Eq(v, ' '), Eq(v, '\t')), Eq(v, '\r')));
+  }
+#endif
+};
+
+struct LineCommentEndChars {
+  static bool Stop(uint8_t c) { return c == '\n' || c == '\r'; }
+#if WABT_LEXER_SSE2 || WABT_LEXER_NEON
+  static Vec Stop(Vec v) { return Or(Eq(v, '\n'), Eq(v, '\r')); }
+#endif
+};
+
+// ';' may start ";)", '(' may start "(;", and '\n' starts a new line.
+struct BlockCommentSpecialChars {
+  static bool Stop(uint8_t c) { return c == ';' || c == '(' || c == '\n'; }
+#if WABT_LEXER_SSE2 || WABT_LEXER_NEON
+  static Vec Stop(Vec v) {
+    return Or(Or(Eq(v, ';'), Eq(v, '(')), Eq(v, '\n'));
+  }
+#endif
+};
+
+struct StringSpecialChars {
+  static bool Stop(uint8_t c) { return c == '"' || c == '\\' || c == '\n'; }
+#if WABT_LEXER_SSE2 || WABT_LEXER_NEON
+  static Vec Stop(Vec v) {
+    return Or(Or(Eq(v, '"'), Eq(v, '\\')), Eq(v, '\n'));
+  }
+#endif
+};
+
+// Must match WastLexer::IsIdChar: '!'..'~', except for '"(),;[]{}'.
+struct NonIdChars {
+  static bool Stop(uint8_t c) {
+    return c < '!' || c > '~' || c == '"' || c == '(' || c == ')' ||
+           c == ',' || c == ';' || c == '[' || c == ']' || c == '{' ||
+           c == '}';
+  }
+#if WABT_LEXER_SSE2 || WABT_LEXER_NEON
+  static Vec Stop(Vec v) {
+    Vec reserved = Or(Or(Eq(v, '"'), Eq(v, '(')), Or(Eq(v, ')'), Eq(v, ',')));
+    reserved = Or(reserved, Or(Or(Eq(v, ';'), Eq(v, '[')), Eq(v, ']')));
+    reserved = Or(reserved, Or(Eq(v, '{'), Eq(v, '}')));
+    return Or(Not(InRange(v, '!', '~')), reserved);
+  }
+#endif
+};
+
+// Returns a pointer to the first byte in [p, end) that the character set
+// stops at, or |end| if there is none.
+template <typename CharSet>
+const char* ScanTo(const char* p, const char* end) {
+#if WABT_LEXER_SSE2 || WABT_LEXER_NEON
+  while (end - p >= static_cast<ptrdiff_t>(sizeof(Vec))) {
+    int index = FindFirst(CharSet::Stop(Load(p)));
+    if (index >= 0) {
+      return p + index;
+    }
+    p += sizeof(Vec);
+  }
+#endif
+  while (p < end && !CharSet::Stop(static_cast<uint8_t>(*p))) {
+    ++p;
+  }
+  return p;
+}
+
 }  // namespace
 
 WastLexer::WastLexer(std::unique_ptr<LexerSource> source,
@@ -186,6 +335,21 @@ Token WastLexer::GetToken() {
   }
 }
 
+WastLexer::Position WastLexer::GetPosition() const {
+  Position pos;
+  pos.offset = cursor_ - buffer_;
+  pos.line_start = line_start_ - buffer_;
+  pos.line = line_;
+  return pos;
+}
+
+void WastLexer::Seek(const Position& pos) {
+  assert(pos.offset <= static_cast<size_t>(buffer_end_ - buffer_));
+  cursor_ = token_start_ = buffer_ + pos.offset;
+  line_start_ = buffer_ + pos.line_start;
+  line_ = pos.line;
+}
+
 Location WastLexer::GetLocation() {
   auto column = [this](const char* p) {
     return std::max(1, static_cast<int>(p - line_start_ + 1));
@@ -255,6 +419,7 @@ void WastLexer::Newline() {
 bool WastLexer::ReadBlockComment() {
   int nesting = 1;
   while (true) {
+    cursor_ = ScanTo<BlockCommentSpecialChars>(cursor_, buffer_end_);
     switch (ReadChar()) {
       case kEof:
         ERROR("EOF in block comment");
@@ -280,42 +445,33 @@ bool WastLexer::ReadBlockComment() {
 }
 
 bool WastLexer::ReadLineComment() {
-  while (true) {
-    switch (ReadChar()) {
-      case kEof:
-        return false;
+  cursor_ = ScanTo<LineCommentEndChars>(cursor_, buffer_end_);
+  switch (ReadChar()) {
+    case kEof:
+      return false;
 
-      case '\r':
-        if (PeekChar() == '\n') {
-          ReadChar();
-        }
-        Newline();
-        return true;
+    case '\r':
+      if (PeekChar() == '\n') {
+        ReadChar();
+      }
+      Newline();
+      return true;
 
-      case '\n':
-        Newline();
-        return true;
-    }
+    case '\n':
+      Newline();
+      return true;
   }
+  WABT_UNREACHABLE;
 }
 
 void WastLexer::ReadWhitespace() {
   while (true) {
-    switch (PeekChar()) {
-      case ' ':
-      case '\t':
-      case '\r':
-        ReadChar();
-        break;
-
-      case '\n':
-        ReadChar();
-        Newline();
-        break;
-
-      default:
-        return;
+    cursor_ = ScanTo<NonBlankChars>(cursor_, buffer_end_);
+    if (PeekChar() != '\n') {
+      return;
     }
+    ReadChar();
+    Newline();
   }
 }
 
@@ -325,6 +481,7 @@ Token WastLexer::GetStringToken() {
   bool in_string = true;
   ReadChar();
   while (in_string) {
+    cursor_ = ScanTo<StringSpecialChars>(cursor_, buffer_end_);
     switch (ReadChar()) {
       case kEof:
         return BareToken(TokenType::Eof);
@@ -490,13 +647,13 @@ bool WastLexer::ReadHexNum() {
 WastLexer::ReservedChars WastLexer::ReadReservedChars() {
   ReservedChars ret{ReservedChars::None};
   while (true) {
-    auto peek = PeekChar();
-    if (IsIdChar(peek)) {
-      ReadChar();
+    const char* idchars_end = ScanTo<NonIdChars>(cursor_, buffer_end_);
+    if (idchars_end != cursor_) {
+      cursor_ = idchars_end;
       if (ret == ReservedChars::None) {
         ret = ReservedChars::Id;
       }
-    } else if (peek == '"') {
+    } else if (PeekChar() == '"') {
       GetStringToken();
       ret = ReservedChars::Some;
     } else {
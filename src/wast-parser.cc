@@ -507,8 +507,74 @@ class ResolveFuncTypesExprVisitorDelegate : public ExprVisitor::DelegateNop {
   Errors* errors_;
 };
 
-Result ResolveFuncTypes(Module* module, Errors* errors) {
+// Records the block types and call_indirect signatures of a function body that
+// ResolveFuncTypesExprVisitorDelegate may define implicitly, so the types can
+// still be resolved in order after the body itself has been discarded.
+class CollectTypeUsesExprVisitorDelegate : public ExprVisitor::DelegateNop {
+ public:
+  explicit CollectTypeUsesExprVisitorDelegate(WastFuncBody* body)
+      : body_(body) {}
+
+  Result BeginBlockExpr(BlockExpr* expr) override {
+    AddBlockDeclaration(expr->loc, expr->block.decl);
+    return Result::Ok;
+  }
+
+  Result BeginIfExpr(IfExpr* expr) override {
+    AddBlockDeclaration(expr->loc, expr->true_.decl);
+    return Result::Ok;
+  }
+
+  Result BeginLoopExpr(LoopExpr* expr) override {
+    AddBlockDeclaration(expr->loc, expr->block.decl);
+    return Result::Ok;
+  }
+
+  Result BeginTryExpr(TryExpr* expr) override {
+    AddBlockDeclaration(expr->loc, expr->block.decl);
+    return Result::Ok;
+  }
+
+  Result OnCallIndirectExpr(CallIndirectExpr* expr) override {
+    AddTypeUse(expr->loc, expr->decl);
+    return Result::Ok;
+  }
+
+  Result OnReturnCallIndirectExpr(ReturnCallIndirectExpr* expr) override {
+    AddTypeUse(expr->loc, expr->decl);
+    return Result::Ok;
+  }
+
+ private:
+  void AddBlockDeclaration(const Location& loc, const BlockDeclaration& decl) {
+    if (!IsInlinableFuncSignature(decl.sig)) {
+      AddTypeUse(loc, decl);
+    }
+  }
+
+  void AddTypeUse(const Location& loc, const FuncDeclaration& decl) {
+    if (decl.has_func_type) {
+      return;
+    }
+    // Only the first use of a signature can define a new type.
+    for (const auto& [use_loc, use] : body_->type_uses) {
+      if (use.sig == decl.sig &&
+          use.sig.param_type_names == decl.sig.param_type_names &&
+          use.sig.result_type_names == decl.sig.result_type_names) {
+        return;
+      }
+    }
+    body_->type_uses.emplace_back(loc, decl);
+  }
+
+  WastFuncBody* body_;
+};
+
+Result ResolveFuncTypes(Module* module,
+                        Errors* errors,
+                        std::vector<WastFuncBody>* deferred_func_bodies) {
   Result result = Result::Ok;
+  Index defined_func_index = 0;
   for (ModuleField& field : module->fields) {
     Func* func = nullptr;
     FuncDeclaration* decl = nullptr;
@@ -556,6 +622,19 @@ Result ResolveFuncTypes(Module* module, Errors* errors) {
         }
       }
 
+      if (deferred_func_bodies) {
+        // The body has been discarded; define the types it needs in the same
+        // order the visitor below would have.
+        WastFuncBody& body = (*deferred_func_bodies)[defined_func_index++];
+        for (auto& [loc, use] : body.type_uses) {
+          ResolveTypeNames(*module, &use);
+          ResolveImplicitlyDefinedFunctionType(loc, module, use);
+        }
+        body.type_uses.clear();
+        body.type_uses.shrink_to_fit();
+        continue;
+      }
+
       ResolveFuncTypesExprVisitorDelegate delegate(module, errors);
       ExprVisitor visitor(&delegate);
       result |= visitor.VisitFunc(func);
@@ -591,7 +670,8 @@ void WastParser::Error(Location loc, const char* format, ...) {
 
 Token WastParser::GetToken() {
   if (tokens_.empty()) {
-    tokens_.push_back(lexer_->GetToken());
+    WastLexer::Position pos = lexer_->GetPosition();
+    tokens_.push_back(lexer_->GetToken(), pos);
   }
   return tokens_.front();
 }
@@ -603,22 +683,23 @@ Location WastParser::GetLocation() {
 TokenType WastParser::Peek(size_t n) {
   assert(n <= 1);
   while (tokens_.size() <= n) {
+    WastLexer::Position pos = lexer_->GetPosition();
     Token cur = lexer_->GetToken();
     if (cur.token_type() != TokenType::LparAnn) {
-      tokens_.push_back(cur);
+      tokens_.push_back(cur, pos);
     } else {
       // Custom annotation. For now, discard until matching Rpar, unless it is
       // a code metadata annotation or custom section. In those cases, we know
       // how to parse it.
       if (!options_->features.annotations_enabled()) {
         Error(cur.loc, "annotations not enabled: %s", cur.to_string().c_str());
-        tokens_.push_back(Token(cur.loc, TokenType::Invalid));
+        tokens_.push_back(Token(cur.loc, TokenType::Invalid), pos);
         continue;
       }
       if ((options_->features.code_metadata_enabled() &&
            cur.text().find("metadata.code.") == 0) ||
           cur.text() == "custom") {
-        tokens_.push_back(cur);
+        tokens_.push_back(cur, pos);
         continue;
       }
       int indent = 1;
@@ -1268,6 +1349,22 @@ Result WastParser::ParseScript(std::unique_ptr<Script>* out_script) {
   }
 }
 
+Result WastParser::ParseFuncBody(const WastFuncBody& body,
+                                 Module* module,
+                                 Func* func) {
+  WABT_TRACE(ParseFuncBody);
+  lexer_->Seek(body.position);
+  CHECK_RESULT(ParseTerminatingInstrList(&func->exprs));
+  EXPECT(Rpar);
+
+  // All of the types the body needs were defined when the module was parsed,
+  // so this only fills in block and call_indirect signatures.
+  ResolveFuncTypesExprVisitorDelegate delegate(module, errors_);
+  ExprVisitor visitor(&delegate);
+  CHECK_RESULT(visitor.VisitFunc(func));
+  return ResolveNamesFuncBody(module, func, errors_);
+}
+
 Result WastParser::ParseCustomSectionAnnotation(Module* module) {
   WABT_TRACE(ParseCustomSectionAnnotation);
   Location loc = GetLocation();
@@ -1335,7 +1432,8 @@ Result WastParser::ParseModuleFieldList(Module* module) {
       CHECK_RESULT(Synchronize(IsModuleField));
     }
   }
-  CHECK_RESULT(ResolveFuncTypes(module, errors_));
+  CHECK_RESULT(
+      ResolveFuncTypes(module, errors_, options_->deferred_func_bodies));
   CHECK_RESULT(ResolveNamesModule(module, errors_));
   return Result::Ok;
 }
@@ -1544,7 +1642,19 @@ Result WastParser::ParseFuncModuleField(Module* module) {
         TokenType::Local, &local_types, &func.bindings,
         &func.decl.sig.param_type_names, func.GetNumParams()));
     func.local_types.Set(local_types);
-    CHECK_RESULT(ParseTerminatingInstrList(&func.exprs));
+    if (options_->deferred_func_bodies) {
+      WastFuncBody body;
+      GetToken();
+      body.position = tokens_.front_position();
+      CHECK_RESULT(ParseTerminatingInstrList(&func.exprs));
+      CollectTypeUsesExprVisitorDelegate delegate(&body);
+      ExprVisitor visitor(&delegate);
+      visitor.VisitFunc(&func);
+      func.exprs.clear();
+      options_->deferred_func_bodies->push_back(std::move(body));
+    } else {
+      CHECK_RESULT(ParseTerminatingInstrList(&func.exprs));
+    }
     module->AppendField(std::move(field));
   }
 
@@ -3805,9 +3915,11 @@ bool WastParser::HasError() const {
   });
 }
 
-void WastParser::TokenQueue::push_back(Token t) {
+void WastParser::TokenQueue::push_back(Token t,
+                                       const WastLexer::Position& pos) {
   assert(!tokens[!i]);
   tokens[!i] = t;
+  positions[!i] = pos;
   if (empty()) {
     i = !i;
   }
@@ -3828,6 +3940,11 @@ const Token& WastParser::TokenQueue::front() const {
   return at(0);
 }
 
+const WastLexer::Position& WastParser::TokenQueue::front_position() const {
+  assert(tokens[i]);
+  return positions[i];
+}
+
 bool WastParser::TokenQueue::empty() const {
   return !tokens[i];
 }
@@ -3859,4 +3976,17 @@ Result ParseWastScript(WastLexer* lexer,
   return Result::Ok;
 }
 
+Result ParseWatFuncBody(WastLexer* lexer,
+                        const WastFuncBody& body,
+                        Module* module,
+                        Func* func,
+                        Errors* errors,
+                        WastParseOptions* options) {
+  assert(func->exprs.empty());
+  assert(options != nullptr);
+  WastParser parser(lexer, errors, options);
+  CHECK_RESULT(parser.ParseFuncBody(body, module, func));
+  return Result::Ok;
+}
+
 }  // namespace wabt
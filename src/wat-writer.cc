@@ -486,9 +486,14 @@ void WatWriter::WriteConst(const Const& const_) {
     case Type::F32: {
       WritePutsSpace(Opcode::F32Const_Opcode.GetName());
       char buffer[128];
-      WriteFloatHex(buffer, 128, const_.f32_bits());
-      WritePutsSpace(buffer);
-      Writef("(;=%g;)", Bitcast<float>(const_.f32_bits()));
+      if (options_.decimal_floats) {
+        WriteFloatDecimal(buffer, 128, const_.f32_bits());
+        WritePutsSpace(buffer);
+      } else {
+        WriteFloatHex(buffer, 128, const_.f32_bits());
+        WritePutsSpace(buffer);
+        Writef("(;=%g;)", Bitcast<float>(const_.f32_bits()));
+      }
       WriteNewline(NO_FORCE_NEWLINE);
       break;
     }
@@ -496,9 +501,14 @@ void WatWriter::WriteConst(const Const& const_) {
     case Type::F64: {
       WritePutsSpace(Opcode::F64Const_Opcode.GetName());
       char buffer[128];
-      WriteDoubleHex(buffer, 128, const_.f64_bits());
-      WritePutsSpace(buffer);
-      Writef("(;=%g;)", Bitcast<double>(const_.f64_bits()));
+      if (options_.decimal_floats) {
+        WriteDoubleDecimal(buffer, 128, const_.f64_bits());
+        WritePutsSpace(buffer);
+      } else {
+        WriteDoubleHex(buffer, 128, const_.f64_bits());
+        WritePutsSpace(buffer);
+        Writef("(;=%g;)", Bitcast<double>(const_.f64_bits()));
+      }
       WriteNewline(NO_FORCE_NEWLINE);
       break;
     }
@@ -26,7 +26,8 @@ REPO_ROOT_DIR = os.path.dirname(SCRIPT_DIR)
 EXECUTABLES = [
     'wat2wasm', 'wast2json', 'wasm2wat', 'wasm-objdump', 'wasm-interp',
     'wasm-stats', 'wat-desugar', 'spectest-interp', 'wasm-validate',
-    'wasm2c', 'wasm-strip', 'wasm-decompile'
+    'wasm2c', 'wasm-strip', 'wasm-decompile', 'wasm-batch', 'wasm-diff',
+    'wasm-patch'
 ]
 
 
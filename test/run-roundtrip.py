@@ -121,6 +121,7 @@ def main(args):
     parser.add_argument('--inline-exports', action='store_true',
                         help="write exports inline and skip end-to-end roundtrip check")
     parser.add_argument('--inline-imports', action='store_true')
+    parser.add_argument('--decimal-floats', action='store_true')
     parser.add_argument('--reloc', action='store_true')
     parser.add_argument('file', help='test file.')
     options = parser.parse_args(args)
@@ -169,6 +170,7 @@ def main(args):
         '--enable-custom-page-sizes': options.enable_custom_page_sizes,
         '--inline-exports': options.inline_exports,
         '--inline-imports': options.inline_imports,
+        '--decimal-floats': options.decimal_floats,
         '--no-debug-names': not options.debug_names,
         '--generate-names': options.generate_names,
         '--no-check': options.no_check,
@@ -124,7 +124,7 @@ def IsModuleCommand(command):
 
 class CWriter(object):
 
-    def __init__(self, spec_json, prefix, out_file, out_dir):
+    def __init__(self, spec_json, prefix, out_file, out_dir, share_code=False):
         self.source_filename = os.path.basename(spec_json['source_filename'])
         self.commands = spec_json['commands']
         self.out_file = out_file
@@ -135,6 +135,8 @@ class CWriter(object):
         self.module_prefix_map = {}
         self.unmangled_names = {}
         self.idx_to_module_name = {}
+        self.share_code = share_code
+        self.module_code_idx = {}
         self._MaybeWriteDummyModule()
         self._CacheModulePrefixes()
 
@@ -159,6 +161,12 @@ class CWriter(object):
     def GetModuleFilenames(self):
         return [c['filename'] for c in self.commands if IsModuleCommand(c)]
 
+    def GetModuleCodeFilenames(self):
+        """Returns the index and filename of each module that has its own code."""
+        return [(idx, filename)
+                for idx, filename in enumerate(self.GetModuleFilenames())
+                if self.module_code_idx[idx] == idx]
+
     def GetModulePrefix(self, idx_or_name=None):
         if idx_or_name is None:
             idx_or_name = self.module_idx - 1
@@ -168,15 +176,32 @@ class CWriter(object):
         return self.unmangled_names[idx]
 
     def GetModuleInstanceName(self, idx_or_name=None):
-        return self.GetModulePrefix(idx_or_name) + '_instance'
+        if idx_or_name is None:
+            idx_or_name = self.module_idx - 1
+        idx = self.module_name_to_idx.get(idx_or_name, idx_or_name)
+        if self.module_code_idx[idx] != idx:
+            return '%s_instance_%d' % (self.GetModulePrefix(idx), idx)
+        return self.GetModulePrefix(idx) + '_instance'
 
     def _CacheModulePrefixes(self):
         idx = 0
+        code_by_data = {}
         for command in self.commands:
             if IsModuleCommand(command):
-                name = os.path.basename(command['filename'])
-                name = re.sub(r'[^a-zA-Z0-9_]', '_', name)
-                name = os.path.splitext(name)[0]
+                # With share_code, a module identical to an earlier one is
+                # another instance of the earlier module's code.
+                code_idx = idx
+                if self.share_code and command['type'] == 'module':
+                    filename = os.path.join(self.out_dir, command['filename'])
+                    with open(filename, 'rb') as wasm_file:
+                        code_idx = code_by_data.setdefault(wasm_file.read(), idx)
+                self.module_code_idx[idx] = code_idx
+                if code_idx != idx:
+                    name = self.unmangled_names[code_idx]
+                else:
+                    name = os.path.basename(command['filename'])
+                    name = re.sub(r'[^a-zA-Z0-9_]', '_', name)
+                    name = os.path.splitext(name)[0]
                 self.unmangled_names[idx] = name
                 name = MangleModuleName(name)
 
@@ -195,6 +220,9 @@ class CWriter(object):
                     name_idx = self.module_name_to_idx[command['name']]
                 else:
                     name_idx = idx - 1
+                if list(self.module_code_idx.values()).count(
+                        self.module_code_idx[name_idx]) > 1:
+                    raise Error('a module that shares code can\'t be registered')
 
                 if name_idx in self.idx_to_module_name:
                     self.module_prefix_map[self.idx_to_module_name[name_idx]] = name
@@ -202,7 +230,9 @@ class CWriter(object):
                 self.unmangled_names[name_idx] = command['as']
 
     def _WriteModuleInitCall(self, command, uninstantiable):
-        header_filename = utils.ChangeExt(command['filename'], '.h')
+        code_idx = self.module_code_idx[self.module_idx - 1]
+        header_filename = utils.ChangeExt(
+            self.GetModuleFilenames()[code_idx], '.h')
         with open(os.path.join(self.out_dir, header_filename), encoding='utf-8') as f:
             imported_modules = set()
             for line in f:
@@ -214,7 +244,7 @@ class CWriter(object):
         if uninstantiable:
             self.out_file.write('ASSERT_TRAP(')
 
-        self.out_file.write('wasm2c_%s_instantiate(&%s_instance' % (self.GetModulePrefix(), self.GetModulePrefix()))
+        self.out_file.write('wasm2c_%s_instantiate(&%s' % (self.GetModulePrefix(), self.GetModuleInstanceName()))
         for imported_module in sorted(imported_modules):
             self.out_file.write(', &%s_instance' % imported_module)
         self.out_file.write(')')
@@ -238,11 +268,9 @@ class CWriter(object):
         self.out_file.write('#line {line:d} "{name:s}"\n'.format(name=self.source_filename, line=command['line']))
 
     def _WriteIncludes(self):
-        idx = 0
-        for filename in self.GetModuleFilenames():
+        for _, filename in self.GetModuleCodeFilenames():
             header = os.path.splitext(filename)[0] + '.h'
             self.out_file.write("#include \"%s\"\n" % header)
-            idx += 1
 
     def _WriteCommand(self, command):
         command_funcs = {
@@ -437,16 +465,17 @@ class CWriter(object):
         action = command['action']
         type_ = action['type']
         mangled_module_name = self.GetModulePrefix(action.get('module'))
+        instance_name = self.GetModuleInstanceName(action.get('module'))
         field = "w2c_" + mangled_module_name + '_' + MangleName(action['field'])
         if type_ == 'invoke':
             args = self._ConstantList(action.get('args', []))
             if len(args) == 0:
-                args = f'&{mangled_module_name}_instance'
+                args = f'&{instance_name}'
             else:
-                args = f'&{mangled_module_name}_instance, {args}'
+                args = f'&{instance_name}, {args}'
             return '%s(%s)' % (field, args)
         elif type_ == 'get':
-            return '*%s(%s)' % (field, '&' + mangled_module_name + '_instance')
+            return '*%s(%s)' % (field, '&' + instance_name)
         else:
             raise Error('Unexpected action type: %s' % type_)
 
@@ -557,6 +586,11 @@ def main(args):
     parser.add_argument('--num-outputs', metavar='COUNT',
                         help='number of output c files for wasm2c', dest='num_outputs',
                         default=1, type=int, action='store')
+    parser.add_argument('--share-module-code',
+                        help='compile identical modules once, and create an '
+                        'instance of that code for each', action='store_true')
+    parser.add_argument('--exception-lowering', metavar='MODE',
+                        help='exception lowering for wasm2c')
     options = parser.parse_args(args)
 
     with utils.TempDirectory(options.out_dir, 'run-spec-wasm2c-') as out_dir:
@@ -591,7 +625,8 @@ def main(args):
             '--enable-extended-const': options.enable_extended_const,
             '--enable-threads': options.enable_threads,
             '--enable-tail-call': options.enable_tail_call,
-            '--enable-multi-memory': options.enable_multi_memory})
+            '--enable-multi-memory': options.enable_multi_memory,
+            '--exception-lowering': options.exception_lowering})
 
         options.cflags += shlex.split(os.environ.get('WASM2C_CFLAGS', ''))
         cc = utils.Executable(options.cc, *options.cflags, forward_stderr=True,
@@ -607,7 +642,8 @@ def main(args):
                 prefix = prefix_file.read() + '\n'
 
         output = io.StringIO()
-        cwriter = CWriter(spec_json, prefix, output, out_dir)
+        cwriter = CWriter(spec_json, prefix, output, out_dir,
+                          options.share_module_code)
 
         o_filenames = []
         cflags = ['-I%s' % options.wasmrt_dir, '-I%s' % options.simde_dir]
@@ -618,7 +654,7 @@ def main(args):
 
         use_c11 = options.enable_threads
 
-        for i, wasm_filename in enumerate(cwriter.GetModuleFilenames()):
+        for i, wasm_filename in cwriter.GetModuleCodeFilenames():
             wasm_filename = os.path.join(out_dir, wasm_filename)
             c_filename_input = utils.ChangeExt(wasm_filename, '.c')
             c_filenames = []
@@ -0,0 +1,54 @@
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "simd.h"
+
+#define REPS 2000
+
+typedef u32 (*kernel_t)(w2c_simd*, u32);
+
+static const struct {
+  const char* name;
+  kernel_t kernel;
+} kernels[] = {
+    {"popcnt", w2c_simd_popcnt},   {"swizzle", w2c_simd_swizzle},
+    {"shuffle", w2c_simd_shuffle}, {"q15mulr", w2c_simd_q15mulr},
+    {"search", w2c_simd_search},
+};
+
+static double now(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+int main(int argc, char** argv) {
+  w2c_simd simd;
+  wasm_rt_init();
+  wasm2c_simd_instantiate(&simd);
+
+  wasm_rt_memory_t* memory = w2c_simd_memory(&simd);
+  uint32_t seed = 1;
+  for (uint32_t i = 0; i < 65536; i++) {
+    seed = seed * 1103515245 + 12345;
+    memory->data[i] = seed >> 16;
+  }
+
+  for (size_t i = 0; i < sizeof(kernels) / sizeof(kernels[0]); i++) {
+    if (argc > 1 && strcmp(argv[1], kernels[i].name) != 0) {
+      continue;
+    }
+    double start = now();
+    u32 checksum = kernels[i].kernel(&simd, REPS);
+    double elapsed = now() - start;
+    printf("%-8s %8.3f ms  %6.2f GB/s  checksum %08x\n", kernels[i].name,
+           elapsed * 1e3, REPS * 65536.0 / elapsed / 1e9, checksum);
+  }
+
+  wasm2c_simd_free(&simd);
+  wasm_rt_free();
+  return 0;
+}
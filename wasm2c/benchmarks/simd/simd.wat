@@ -0,0 +1,86 @@
+;; SIMD microbenchmarks for wasm2c. Each exported kernel makes $reps passes
+;; over the first 64KiB of memory, which main.c fills with random bytes, and
+;; returns a checksum so the simde and native builds can be compared.
+(module
+  (memory (export "memory") 2)
+
+  (func (export "popcnt") (param $reps i32) (result i32)
+    (local $i i32) (local $acc v128)
+    (loop $rep
+      (local.set $i (i32.const 0))
+      (loop $l
+        (local.set $acc
+          (i16x8.add (local.get $acc)
+            (i16x8.extadd_pairwise_i8x16_u
+              (i8x16.popcnt (v128.load (local.get $i))))))
+        (br_if $l (i32.lt_u (local.tee $i (i32.add (local.get $i) (i32.const 16)))
+                            (i32.const 65536))))
+      (br_if $rep (local.tee $reps (i32.sub (local.get $reps) (i32.const 1)))))
+    (i32x4.extract_lane 0 (i32x4.extadd_pairwise_i16x8_u (local.get $acc))))
+
+  ;; A 16-entry byte table lookup, as in hex encoding or base64.
+  (func (export "swizzle") (param $reps i32) (result i32)
+    (local $i i32) (local $acc v128)
+    (loop $rep
+      (local.set $i (i32.const 0))
+      (loop $l
+        (local.set $acc
+          (v128.xor (local.get $acc)
+            (i8x16.swizzle
+              (v128.const i8x16 48 49 50 51 52 53 54 55 56 57 97 98 99 100 101 102)
+              (v128.and (v128.load (local.get $i)) (v128.const i8x16 31 31 31 31 31 31 31 31 31 31 31 31 31 31 31 31)))))
+        (br_if $l (i32.lt_u (local.tee $i (i32.add (local.get $i) (i32.const 16)))
+                            (i32.const 65536))))
+      (br_if $rep (local.tee $reps (i32.sub (local.get $reps) (i32.const 1)))))
+    (i32x4.extract_lane 0 (local.get $acc)))
+
+  ;; Interleaves and reverses bytes of neighbouring vectors.
+  (func (export "shuffle") (param $reps i32) (result i32)
+    (local $i i32) (local $acc v128)
+    (loop $rep
+      (local.set $i (i32.const 0))
+      (loop $l
+        (local.set $acc
+          (i8x16.add (local.get $acc)
+            (i8x16.shuffle 0 16 1 17 2 18 3 19 15 14 13 12 27 26 25 24
+              (v128.load (local.get $i))
+              (v128.load offset=16 (local.get $i)))))
+        (br_if $l (i32.lt_u (local.tee $i (i32.add (local.get $i) (i32.const 16)))
+                            (i32.const 65520))))
+      (br_if $rep (local.tee $reps (i32.sub (local.get $reps) (i32.const 1)))))
+    (i32x4.extract_lane 0 (local.get $acc)))
+
+  ;; Fixed-point multiplies, as in audio and image filters.
+  (func (export "q15mulr") (param $reps i32) (result i32)
+    (local $i i32) (local $acc v128)
+    (loop $rep
+      (local.set $i (i32.const 0))
+      (loop $l
+        (local.set $acc
+          (i16x8.add_sat_s (local.get $acc)
+            (i16x8.q15mulr_sat_s (v128.load (local.get $i))
+                                 (v128.load offset=16 (local.get $i)))))
+        (br_if $l (i32.lt_u (local.tee $i (i32.add (local.get $i) (i32.const 16)))
+                            (i32.const 65520))))
+      (br_if $rep (local.tee $reps (i32.sub (local.get $reps) (i32.const 1)))))
+    (i32x4.extract_lane 0 (local.get $acc)))
+
+  ;; Searches for a byte, as in memchr and strlen.
+  (func (export "search") (param $reps i32) (result i32)
+    (local $i i32) (local $v v128) (local $acc i32)
+    (loop $rep
+      (local.set $i (i32.const 0))
+      (loop $l
+        (local.set $v (i8x16.eq (v128.load (local.get $i)) (i8x16.splat (i32.const 0))))
+        (if (v128.any_true (local.get $v))
+          (then
+            (local.set $acc
+              (i32.add (local.get $acc)
+                (i32.ctz (i8x16.bitmask (local.get $v)))))))
+        (local.set $acc
+          (i32.add (local.get $acc)
+            (i8x16.all_true (v128.load (local.get $i)))))
+        (br_if $l (i32.lt_u (local.tee $i (i32.add (local.get $i) (i32.const 16)))
+                            (i32.const 65536))))
+      (br_if $rep (local.tee $reps (i32.sub (local.get $reps) (i32.const 1)))))
+    (local.get $acc)))
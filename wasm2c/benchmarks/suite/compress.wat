@@ -0,0 +1,170 @@
+;; LZ77-style compression. Each iteration compresses 64KiB of low-entropy text
+;; with a greedy single-probe hash matcher, decompresses it again and folds the
+;; compressed size and the Adler-32 of the round trip into the checksum.
+;;
+;; Memory layout:
+;;   0x00000  input (64KiB)
+;;   0x10000  hash table (4096 x i32)
+;;   0x20000  compressed output
+;;   0x40000  decompressed output (64KiB)
+;;
+;; Compressed format: a control byte c < 0x80 is followed by c + 1 literal
+;; bytes; c >= 0x80 is a match of (c & 0x7f) + 4 bytes at the 16-bit offset
+;; that follows it.
+(module
+  (memory 5)
+
+  (func $fill
+    (local $i i32) (local $seed i32)
+    (local.set $seed (i32.const 1))
+    (loop $l
+      (local.set $seed
+        (i32.add (i32.mul (local.get $seed) (i32.const 1103515245))
+                 (i32.const 12345)))
+      (i32.store8 (local.get $i)
+        (i32.add (i32.const 97)
+                 (i32.and (i32.shr_u (local.get $seed) (i32.const 16))
+                          (i32.const 7))))
+      (br_if $l (i32.lt_u (local.tee $i (i32.add (local.get $i) (i32.const 1)))
+                          (i32.const 0x10000)))))
+
+  ;; Writes $n literal bytes starting at $lit, returning the new output
+  ;; position.
+  (func $flush (param $out i32) (param $lit i32) (param $n i32) (result i32)
+    (local $k i32)
+    (block $done
+      (loop $l
+        (br_if $done (i32.eqz (local.get $n)))
+        (local.set $k
+          (select (i32.const 128) (local.get $n)
+                  (i32.gt_u (local.get $n) (i32.const 128))))
+        (i32.store8 (local.get $out) (i32.sub (local.get $k) (i32.const 1)))
+        (memory.copy (i32.add (local.get $out) (i32.const 1))
+                     (local.get $lit) (local.get $k))
+        (local.set $out (i32.add (local.get $out)
+                                 (i32.add (local.get $k) (i32.const 1))))
+        (local.set $lit (i32.add (local.get $lit) (local.get $k)))
+        (local.set $n (i32.sub (local.get $n) (local.get $k)))
+        (br $l)))
+    (local.get $out))
+
+  ;; Returns the compressed size.
+  (func $compress (result i32)
+    (local $i i32) (local $lit i32) (local $out i32) (local $h i32)
+    (local $cand i32) (local $len i32) (local $max i32)
+    (memory.fill (i32.const 0x10000) (i32.const 0xff) (i32.const 0x4000))
+    (local.set $out (i32.const 0x20000))
+    (block $done
+      (loop $l
+        (br_if $done (i32.gt_u (local.get $i) (i32.const 0xfffc)))
+        (local.set $h
+          (i32.shl
+            (i32.shr_u (i32.mul (i32.load (local.get $i))
+                                (i32.const 0x9e3779b1))
+                       (i32.const 20))
+            (i32.const 2)))
+        (local.set $cand (i32.load offset=0x10000 (local.get $h)))
+        (i32.store offset=0x10000 (local.get $h) (local.get $i))
+        (block $literal
+          (br_if $literal (i32.lt_s (local.get $cand) (i32.const 0)))
+          (br_if $literal (i32.ne (i32.load (local.get $cand))
+                                  (i32.load (local.get $i))))
+          (local.set $out
+            (call $flush (local.get $out) (local.get $lit)
+                         (i32.sub (local.get $i) (local.get $lit))))
+          (local.set $max (i32.sub (i32.const 0x10000) (local.get $i)))
+          (if (i32.gt_u (local.get $max) (i32.const 131))
+            (then (local.set $max (i32.const 131))))
+          (local.set $len (i32.const 4))
+          (block $end
+            (loop $extend
+              (br_if $end (i32.ge_u (local.get $len) (local.get $max)))
+              (br_if $end
+                (i32.ne
+                  (i32.load8_u (i32.add (local.get $cand) (local.get $len)))
+                  (i32.load8_u (i32.add (local.get $i) (local.get $len)))))
+              (local.set $len (i32.add (local.get $len) (i32.const 1)))
+              (br $extend)))
+          (i32.store8 (local.get $out)
+            (i32.or (i32.const 0x80) (i32.sub (local.get $len) (i32.const 4))))
+          (i32.store16 offset=1 (local.get $out)
+            (i32.sub (local.get $i) (local.get $cand)))
+          (local.set $out (i32.add (local.get $out) (i32.const 3)))
+          (local.set $i (i32.add (local.get $i) (local.get $len)))
+          (local.set $lit (local.get $i))
+          (br $l))
+        (local.set $i (i32.add (local.get $i) (i32.const 1)))
+        (br $l)))
+    (local.set $out
+      (call $flush (local.get $out) (local.get $lit)
+                   (i32.sub (i32.const 0x10000) (local.get $lit))))
+    (i32.sub (local.get $out) (i32.const 0x20000)))
+
+  ;; Returns the decompressed size.
+  (func $decompress (param $size i32) (result i32)
+    (local $in i32) (local $end i32) (local $out i32) (local $c i32)
+    (local $n i32) (local $src i32)
+    (local.set $in (i32.const 0x20000))
+    (local.set $end (i32.add (local.get $in) (local.get $size)))
+    (local.set $out (i32.const 0x40000))
+    (block $done
+      (loop $l
+        (br_if $done (i32.ge_u (local.get $in) (local.get $end)))
+        (local.set $c (i32.load8_u (local.get $in)))
+        (if (i32.lt_u (local.get $c) (i32.const 0x80))
+          (then
+            (local.set $n (i32.add (local.get $c) (i32.const 1)))
+            (memory.copy (local.get $out) (i32.add (local.get $in) (i32.const 1))
+                         (local.get $n))
+            (local.set $in (i32.add (local.get $in)
+                                    (i32.add (local.get $n) (i32.const 1))))
+            (local.set $out (i32.add (local.get $out) (local.get $n))))
+          (else
+            ;; Matches may overlap their own output, so copy a byte at a time.
+            (local.set $n (i32.sub (local.get $c) (i32.const 124)))
+            (local.set $src (i32.sub (local.get $out)
+                                     (i32.load16_u offset=1 (local.get $in))))
+            (loop $copy
+              (i32.store8 (local.get $out) (i32.load8_u (local.get $src)))
+              (local.set $src (i32.add (local.get $src) (i32.const 1)))
+              (local.set $out (i32.add (local.get $out) (i32.const 1)))
+              (br_if $copy (local.tee $n (i32.sub (local.get $n) (i32.const 1)))))
+            (local.set $in (i32.add (local.get $in) (i32.const 3)))))
+        (br $l)))
+    (i32.sub (local.get $out) (i32.const 0x40000)))
+
+  (func $adler32 (param $p i32) (param $n i32) (result i32)
+    (local $a i32) (local $b i32) (local $end i32)
+    (local.set $a (i32.const 1))
+    (local.set $end (i32.add (local.get $p) (local.get $n)))
+    (block $done
+      (loop $l
+        (br_if $done (i32.ge_u (local.get $p) (local.get $end)))
+        (local.set $a (i32.rem_u (i32.add (local.get $a)
+                                          (i32.load8_u (local.get $p)))
+                                 (i32.const 65521)))
+        (local.set $b (i32.rem_u (i32.add (local.get $b) (local.get $a))
+                                 (i32.const 65521)))
+        (local.set $p (i32.add (local.get $p) (i32.const 1)))
+        (br $l)))
+    (i32.or (i32.shl (local.get $b) (i32.const 16)) (local.get $a)))
+
+  (func (export "run") (param $n i32) (result i32)
+    (local $i i32) (local $acc i32) (local $size i32)
+    (call $fill)
+    (block $done
+      (loop $l
+        (br_if $done (i32.ge_u (local.get $i) (local.get $n)))
+        ;; Perturb the input so no two iterations are the same.
+        (i32.store8 (i32.and (i32.mul (local.get $i) (i32.const 4099))
+                             (i32.const 0xffff))
+                    (local.get $i))
+        (local.set $size (call $compress))
+        (local.set $acc
+          (i32.add (i32.rotl (local.get $acc) (i32.const 5))
+                   (i32.xor (local.get $size)
+                            (call $adler32 (i32.const 0x40000)
+                                           (call $decompress (local.get $size))))))
+        (local.set $i (i32.add (local.get $i) (i32.const 1)))
+        (br $l)))
+    (local.get $acc)))
@@ -0,0 +1,101 @@
+;; A bytecode interpreter in "threaded" style: every handler executes one
+;; instruction and tail calls the handler of the next one through a table, so
+;; the dispatch loop is made entirely of return_call_indirect. Each iteration
+;; runs the program below once.
+;;
+;; Instructions are one opcode byte and one immediate byte; the interpreter
+;; state is the program counter, an accumulator, a second register and a loop
+;; counter.
+(module
+  (type $handler (func (param i32 i32 i32 i32) (result i32)))
+  (memory 1)
+  (table $handlers 8 funcref)
+  (elem (table $handlers) (i32.const 0) func
+    $op_add $op_mul $op_xor $op_rot $op_swap $op_loop $op_halt $op_load)
+
+  ;;  0: add 7      acc += 7
+  ;;  2: mul 33     acc *= 33
+  ;;  4: swap       acc, x = x, acc
+  ;;  6: xor 0x5a   acc ^= 0x5a
+  ;;  8: load 3     acc += mem[64 + (acc & 0xff) * 4 + 3]
+  ;; 10: rot 13     acc = rotl(acc, 13)
+  ;; 12: add 1      acc += 1
+  ;; 14: loop 0     if --count != 0 goto 0
+  ;; 16: halt       return acc ^ x
+  (data (i32.const 0)
+    "\00\07\01\21\04\00\02\5a\07\03\03\0d\00\01\05\00\06\00")
+
+  (func $dispatch (type $handler)
+    (param $pc i32) (param $acc i32) (param $x i32) (param $count i32)
+    (result i32)
+    (return_call_indirect $handlers (type $handler)
+      (local.get $pc) (local.get $acc) (local.get $x) (local.get $count)
+      (i32.load8_u (local.get $pc))))
+
+  (func $op_add (type $handler)
+    (param $pc i32) (param $acc i32) (param $x i32) (param $count i32)
+    (result i32)
+    (return_call $dispatch
+      (i32.add (local.get $pc) (i32.const 2))
+      (i32.add (local.get $acc) (i32.load8_u offset=1 (local.get $pc)))
+      (local.get $x) (local.get $count)))
+  (func $op_mul (type $handler)
+    (param $pc i32) (param $acc i32) (param $x i32) (param $count i32)
+    (result i32)
+    (return_call $dispatch
+      (i32.add (local.get $pc) (i32.const 2))
+      (i32.mul (local.get $acc) (i32.load8_u offset=1 (local.get $pc)))
+      (local.get $x) (local.get $count)))
+  (func $op_xor (type $handler)
+    (param $pc i32) (param $acc i32) (param $x i32) (param $count i32)
+    (result i32)
+    (return_call $dispatch
+      (i32.add (local.get $pc) (i32.const 2))
+      (i32.xor (local.get $acc) (i32.load8_u offset=1 (local.get $pc)))
+      (local.get $x) (local.get $count)))
+  (func $op_rot (type $handler)
+    (param $pc i32) (param $acc i32) (param $x i32) (param $count i32)
+    (result i32)
+    (return_call $dispatch
+      (i32.add (local.get $pc) (i32.const 2))
+      (i32.rotl (local.get $acc) (i32.load8_u offset=1 (local.get $pc)))
+      (local.get $x) (local.get $count)))
+  (func $op_swap (type $handler)
+    (param $pc i32) (param $acc i32) (param $x i32) (param $count i32)
+    (result i32)
+    (return_call $dispatch
+      (i32.add (local.get $pc) (i32.const 2))
+      (local.get $x) (local.get $acc) (local.get $count)))
+  (func $op_loop (type $handler)
+    (param $pc i32) (param $acc i32) (param $x i32) (param $count i32)
+    (result i32)
+    (local.set $count (i32.sub (local.get $count) (i32.const 1)))
+    (return_call $dispatch
+      (select (i32.load8_u offset=1 (local.get $pc))
+              (i32.add (local.get $pc) (i32.const 2))
+              (local.get $count))
+      (local.get $acc) (local.get $x) (local.get $count)))
+  (func $op_halt (type $handler)
+    (param $pc i32) (param $acc i32) (param $x i32) (param $count i32)
+    (result i32)
+    (i32.xor (local.get $acc) (local.get $x)))
+  (func $op_load (type $handler)
+    (param $pc i32) (param $acc i32) (param $x i32) (param $count i32)
+    (result i32)
+    (return_call $dispatch
+      (i32.add (local.get $pc) (i32.const 2))
+      (i32.add (local.get $acc)
+               (i32.load8_u offset=64
+                 (i32.add (i32.shl (i32.and (local.get $acc) (i32.const 0xff))
+                                   (i32.const 2))
+                          (i32.load8_u offset=1 (local.get $pc)))))
+      (local.get $x) (local.get $count)))
+
+  (func (export "run") (param $n i32) (result i32)
+    (local $i i32)
+    (loop $l
+      (i32.store8 offset=64 (local.get $i) (i32.mul (local.get $i) (i32.const 37)))
+      (br_if $l (i32.lt_u (local.tee $i (i32.add (local.get $i) (i32.const 1)))
+                          (i32.const 1024))))
+    (if (i32.eqz (local.get $n)) (then (return (i32.const 0))))
+    (call $dispatch (i32.const 0) (i32.const 1) (i32.const 2) (local.get $n))))
@@ -0,0 +1,35 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+/* Every module in the suite is translated with `wasm2c -n bench`. */
+#include "bench.h"
+
+static double now(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+int main(int argc, char** argv) {
+  if (argc != 2) {
+    fprintf(stderr, "usage: %s ITERATIONS\n", argv[0]);
+    return 1;
+  }
+  u32 iterations = strtoul(argv[1], NULL, 0);
+
+  w2c_bench bench;
+  wasm_rt_init();
+  wasm2c_bench_instantiate(&bench);
+
+  double start = now();
+  u32 checksum = w2c_bench_run(&bench, iterations);
+  double elapsed = now() - start;
+
+  /* Read by run.py: checksum, then seconds spent in `run`. */
+  printf("%08x %.9f\n", checksum, elapsed);
+
+  wasm2c_bench_free(&bench);
+  wasm_rt_free();
+  return 0;
+}
@@ -0,0 +1,55 @@
+;; Moving data between memories, as a module that keeps private state apart
+;; from a buffer it shares with its host does. Each iteration transforms 64KiB
+;; from $shared into $private word by word, folds $private into a checksum and
+;; copies part of it back with memory.copy.
+(module
+  (memory $shared 1)
+  (memory $private 2)
+
+  (func $fill
+    (local $i i32) (local $seed i32)
+    (local.set $seed (i32.const 3))
+    (loop $l
+      (local.set $seed
+        (i32.add (i32.mul (local.get $seed) (i32.const 1103515245))
+                 (i32.const 12345)))
+      (i32.store $shared (local.get $i) (local.get $seed))
+      (br_if $l (i32.lt_u (local.tee $i (i32.add (local.get $i) (i32.const 4)))
+                          (i32.const 0x10000)))))
+
+  (func $transform (param $key i32)
+    (local $i i32) (local $w i32)
+    (loop $l
+      (local.set $w (i32.load $shared (local.get $i)))
+      (i32.store $private (local.get $i)
+        (i32.xor (i32.rotl (local.get $w) (i32.const 7)) (local.get $key)))
+      (i32.store16 $private offset=0x10000 (i32.shr_u (local.get $i) (i32.const 1))
+        (i32.add (local.get $w) (i32.shr_u (local.get $w) (i32.const 16))))
+      (br_if $l (i32.lt_u (local.tee $i (i32.add (local.get $i) (i32.const 4)))
+                          (i32.const 0x10000)))))
+
+  (func $checksum (result i32)
+    (local $i i64) (local $acc i64)
+    (loop $l
+      (local.set $acc
+        (i64.add (i64.rotl (local.get $acc) (i64.const 3))
+                 (i64.load $private (i32.wrap_i64 (local.get $i)))))
+      (br_if $l (i64.lt_u (local.tee $i (i64.add (local.get $i) (i64.const 8)))
+                          (i64.const 0x18000))))
+    (i32.wrap_i64 (i64.xor (local.get $acc)
+                           (i64.shr_u (local.get $acc) (i64.const 32)))))
+
+  (func (export "run") (param $n i32) (result i32)
+    (local $i i32) (local $acc i32)
+    (call $fill)
+    (block $done
+      (loop $l
+        (br_if $done (i32.ge_u (local.get $i) (local.get $n)))
+        (call $transform (local.get $i))
+        (local.set $acc (i32.add (local.get $acc) (call $checksum)))
+        (memory.copy $shared $private
+          (i32.and (i32.mul (local.get $i) (i32.const 256)) (i32.const 0x7fff))
+          (i32.const 0x10000) (i32.const 0x8000))
+        (local.set $i (i32.add (local.get $i) (i32.const 1)))
+        (br $l)))
+    (local.get $acc)))
@@ -0,0 +1,127 @@
+;; The shape of compiled C++: virtual calls through vtables in a table, small
+;; methods that load and store object fields, and exceptions thrown on a rare
+;; error path and caught by a try around each unit of work. Each iteration
+;; updates all 1024 objects once.
+;;
+;; An object is 16 bytes: a vtable index (the first table slot of its class),
+;; then three i32 fields.
+(module
+  (type $method (func (param i32 i32) (result i32)))
+  (tag $error (param i32))
+  (memory 1)
+  (table $vtables 12 funcref)
+  (elem (table $vtables) (i32.const 0) func
+    $point_area $point_scale $point_check
+    $rect_area $rect_scale $rect_check
+    $circle_area $circle_scale $circle_check
+    $poly_area $poly_scale $poly_check)
+
+  (func $point_area (type $method)
+    (i32.add (i32.load offset=4 (local.get 0)) (local.get 1)))
+  (func $point_scale (type $method)
+    (i32.store offset=4 (local.get 0)
+      (i32.add (i32.load offset=4 (local.get 0)) (local.get 1)))
+    (local.get 1))
+  (func $point_check (type $method)
+    (local.get 1))
+
+  (func $rect_area (type $method)
+    (i32.add (i32.mul (i32.load offset=4 (local.get 0))
+                      (i32.load offset=8 (local.get 0)))
+             (local.get 1)))
+  (func $rect_scale (type $method)
+    (i32.store offset=4 (local.get 0)
+      (i32.and (i32.add (i32.load offset=4 (local.get 0)) (local.get 1))
+               (i32.const 0xffff)))
+    (i32.store offset=8 (local.get 0)
+      (i32.and (i32.sub (i32.load offset=8 (local.get 0)) (local.get 1))
+               (i32.const 0xffff)))
+    (local.get 1))
+  (func $rect_check (type $method)
+    (if (i32.eqz (i32.and (i32.load offset=4 (local.get 0)) (i32.const 0x3ff)))
+      (then (throw $error (local.get 0))))
+    (local.get 1))
+
+  (func $circle_area (type $method)
+    (local $r i32)
+    (local.set $r (i32.load offset=4 (local.get 0)))
+    (i32.add (i32.shr_u (i32.mul (i32.mul (local.get $r) (local.get $r))
+                                 (i32.const 201))
+                        (i32.const 6))
+             (local.get 1)))
+  (func $circle_scale (type $method)
+    (i32.store offset=4 (local.get 0)
+      (i32.and (i32.xor (i32.load offset=4 (local.get 0)) (local.get 1))
+               (i32.const 0xfff)))
+    (local.get 1))
+  (func $circle_check (type $method)
+    (if (i32.eq (i32.load offset=4 (local.get 0)) (local.get 1))
+      (then (throw $error (local.get 1))))
+    (local.get 1))
+
+  (func $poly_area (type $method)
+    (i32.add (i32.add (i32.load offset=4 (local.get 0))
+                      (i32.load offset=8 (local.get 0)))
+             (i32.add (i32.load offset=12 (local.get 0)) (local.get 1))))
+  (func $poly_scale (type $method)
+    (i32.store offset=12 (local.get 0)
+      (i32.load offset=8 (local.get 0)))
+    (i32.store offset=8 (local.get 0)
+      (i32.load offset=4 (local.get 0)))
+    (i32.store offset=4 (local.get 0)
+      (i32.add (i32.load offset=12 (local.get 0)) (local.get 1)))
+    (local.get 1))
+  (func $poly_check (type $method)
+    (local.get 1))
+
+  (func $init
+    (local $p i32) (local $seed i32)
+    (local.set $seed (i32.const 7))
+    (loop $l
+      (local.set $seed
+        (i32.add (i32.mul (local.get $seed) (i32.const 1103515245))
+                 (i32.const 12345)))
+      (i32.store (local.get $p)
+        (i32.mul (i32.and (i32.shr_u (local.get $seed) (i32.const 16))
+                          (i32.const 3))
+                 (i32.const 3)))
+      (i32.store offset=4 (local.get $p) (i32.shr_u (local.get $seed) (i32.const 20)))
+      (i32.store offset=8 (local.get $p) (i32.shr_u (local.get $seed) (i32.const 24)))
+      (i32.store offset=12 (local.get $p) (i32.const 1))
+      (br_if $l (i32.lt_u (local.tee $p (i32.add (local.get $p) (i32.const 16)))
+                          (i32.const 0x4000)))))
+
+  ;; Checks, scales and measures one object, returning the error code if a
+  ;; check threw.
+  (func $update (param $obj i32) (param $k i32) (result i32)
+    (local $vtable i32)
+    (local.set $vtable (i32.load (local.get $obj)))
+    (block $caught (result i32)
+      (try_table (result i32) (catch $error $caught)
+        (drop (call_indirect $vtables (type $method)
+                (local.get $obj) (local.get $k) (i32.add (local.get $vtable) (i32.const 2))))
+        (drop (call_indirect $vtables (type $method)
+                (local.get $obj) (local.get $k) (i32.add (local.get $vtable) (i32.const 1))))
+        (call_indirect $vtables (type $method)
+          (local.get $obj) (local.get $k) (local.get $vtable))))
+    ;; Whether or not a check threw, the object is left in a valid state.
+    (i32.store offset=4 (local.get $obj)
+      (i32.add (i32.load offset=4 (local.get $obj)) (i32.const 1))))
+
+  (func (export "run") (param $n i32) (result i32)
+    (local $i i32) (local $p i32) (local $acc i32)
+    (call $init)
+    (block $done
+      (loop $l
+        (br_if $done (i32.ge_u (local.get $i) (local.get $n)))
+        (local.set $p (i32.const 0))
+        (loop $object
+          (local.set $acc
+            (i32.add (i32.rotl (local.get $acc) (i32.const 1))
+                     (call $update (local.get $p) (i32.and (local.get $i) (i32.const 0xff)))))
+          (br_if $object
+            (i32.lt_u (local.tee $p (i32.add (local.get $p) (i32.const 16)))
+                      (i32.const 0x4000))))
+        (local.set $i (i32.add (local.get $i) (i32.const 1)))
+        (br $l)))
+    (local.get $acc)))
@@ -0,0 +1,256 @@
+#!/usr/bin/env python3
+#
+# Copyright 2026 WebAssembly Community Group participants
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+
+"""Build the wasm2c benchmark suite in each runtime configuration and time it.
+
+Every module is translated once with wasm2c, then compiled and run with each
+set of WASM_RT_* flags. The results (best time of --repeat runs, throughput,
+and the code size of the translated module) are written as JSON or CSV.
+
+  $ wasm2c/benchmarks/suite/run.py --bindir bin -o results.json
+"""
+
+import argparse
+import csv
+import json
+import os
+import platform
+import shutil
+import subprocess
+import sys
+import tempfile
+
+SCRIPT_DIR = os.path.dirname(os.path.abspath(__file__))
+REPO_ROOT_DIR = os.path.dirname(os.path.dirname(os.path.dirname(SCRIPT_DIR)))
+WASM2C_DIR = os.path.join(REPO_ROOT_DIR, 'wasm2c')
+IS_WINDOWS = sys.platform == 'win32'
+
+# name: (features, iterations, units per iteration, unit)
+MODULES = {
+    'chacha20': ([], 2000, 65536, 'bytes'),
+    'compress': ([], 100, 65536, 'bytes'),
+    'interp': (['--enable-tail-call'], 20000000, 8, 'instructions'),
+    'multimem': (['--enable-multi-memory'], 2000, 65536, 'bytes'),
+    'objects': (['--enable-exceptions'], 10000, 1024, 'objects'),
+}
+
+# name: extra compiler flags. The first configuration is the baseline that the
+# others are compared against.
+CONFIGS = [
+    ('guard-pages', ['-DWASM_RT_MEMCHECK_GUARD_PAGES=1']),
+    ('bounds-checks', ['-DWASM_RT_MEMCHECK_BOUNDS_CHECK=1']),
+    ('stack-depth-count', ['-DWASM_RT_STACK_DEPTH_COUNT=1']),
+]
+# Segue needs clang and x86-64 Linux; elsewhere the flag is accepted but has no
+# effect, see wasm2c/README.md.
+if platform.machine() in ('x86_64', 'AMD64'):
+    CONFIGS.append(('segue', ['-DWASM_RT_ALLOW_SEGUE=1', '-mfsgsbase']))
+
+RUNTIME = ['wasm-rt-impl.c', 'wasm-rt-exceptions-impl.c', 'wasm-rt-mem-impl.c']
+
+FIELDS = ['module', 'config', 'iterations', 'seconds', 'throughput', 'unit',
+          'code_size', 'checksum']
+
+
+class Error(Exception):
+    pass
+
+
+def Run(*cmd):
+    try:
+        return subprocess.check_output(cmd, stderr=subprocess.STDOUT,
+                                       universal_newlines=True)
+    except OSError as e:
+        raise Error('%s: %s' % (cmd[0], e))
+    except subprocess.CalledProcessError as e:
+        raise Error('command failed: %s\n%s' % (' '.join(cmd), e.output))
+
+
+def Exe(bindir, name):
+    exe = os.path.join(bindir, name)
+    if IS_WINDOWS:
+        exe += '.exe'
+    if not os.path.exists(exe):
+        raise Error('executable not found: %s' % exe)
+    return exe
+
+
+def TextSize(obj):
+    """Returns the size of the code in an object file, or None."""
+    size = shutil.which('size')
+    if not size:
+        return None
+    try:
+        lines = Run(size, obj).splitlines()
+    except Error:
+        return None
+    # Berkeley format: "text data bss dec hex filename".
+    return int(lines[1].split()[0])
+
+
+def Translate(options, name, out_dir):
+    features = MODULES[name][0]
+    wat = os.path.join(SCRIPT_DIR, name + '.wat')
+    wasm = os.path.join(out_dir, 'bench.wasm')
+    Run(Exe(options.bindir, 'wat2wasm'), wat, '-o', wasm, *features)
+    Run(Exe(options.bindir, 'wasm2c'), '-n', 'bench', wasm, '-o',
+        os.path.join(out_dir, 'bench.c'), *features)
+
+
+def Build(options, out_dir, cflags):
+    """Compiles bench.c and the runtime, returning (exe, code size)."""
+    cflags = ['-I' + WASM2C_DIR,
+              '-I' + os.path.join(REPO_ROOT_DIR, 'third_party', 'simde'),
+              '-I' + out_dir] + options.cflags + cflags
+    bench_o = os.path.join(out_dir, 'bench.o')
+    Run(options.cc, *cflags, '-c', os.path.join(out_dir, 'bench.c'),
+        '-o', bench_o)
+    exe = os.path.join(out_dir, 'bench')
+    runtime = [os.path.join(WASM2C_DIR, f) for f in RUNTIME]
+    Run(options.cc, *cflags, '-o', exe, os.path.join(SCRIPT_DIR, 'main.c'),
+        bench_o, *runtime, '-lm')
+    return exe, TextSize(bench_o)
+
+
+def Measure(exe, iterations, repeat):
+    """Returns (checksum, best time) of `repeat` runs."""
+    best = None
+    checksum = None
+    for _ in range(repeat):
+        checksum, seconds = Run(exe, str(iterations)).split()
+        seconds = float(seconds)
+        if best is None or seconds < best:
+            best = seconds
+    return checksum, best
+
+
+def RunModule(options, name, out_dir):
+    _, iterations, units, unit = MODULES[name]
+    iterations = max(1, int(iterations * options.scale))
+    Translate(options, name, out_dir)
+    results = []
+    for config, cflags in CONFIGS:
+        if options.config and config not in options.config:
+            continue
+        try:
+            exe, code_size = Build(options, out_dir, cflags)
+        except Error as e:
+            # e.g. SIMD modules without simde, or guard pages on 32-bit hosts.
+            sys.stderr.write('%s/%s: skipped, build failed\n%s\n' %
+                             (name, config, e))
+            continue
+        checksum, seconds = Measure(exe, iterations, options.repeat)
+        results.append({
+            'module': name,
+            'config': config,
+            'iterations': iterations,
+            'seconds': seconds,
+            'throughput': iterations * units / seconds if seconds else None,
+            'unit': unit + '/s',
+            'code_size': code_size,
+            'checksum': checksum,
+        })
+        sys.stderr.write('%s/%s: %.3fs\n' % (name, config, seconds))
+    checksums = set(r['checksum'] for r in results)
+    if len(checksums) > 1:
+        raise Error('%s: checksums differ between configurations: %s' %
+                    (name, ', '.join(sorted(checksums))))
+    return results
+
+
+def Write(options, results, f):
+    if options.format == 'csv':
+        writer = csv.DictWriter(f, FIELDS, lineterminator='\n')
+        writer.writeheader()
+        writer.writerows(results)
+        return
+    json.dump({
+        'cc': options.cc,
+        'cflags': options.cflags,
+        'machine': platform.machine(),
+        'results': results,
+    }, f, indent=2)
+    f.write('\n')
+
+
+def main(args):
+    parser = argparse.ArgumentParser(description=__doc__,
+        formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument('--bindir', metavar='PATH',
+                        default=os.path.join(REPO_ROOT_DIR, 'bin'),
+                        help='directory to search for all executables.')
+    parser.add_argument('--cc', default=os.environ.get('CC', 'clang'),
+                        help='C compiler (default: $CC, or clang).')
+    parser.add_argument('--cflags', action='append', default=[],
+                        help='additional compiler flag; may be repeated. '
+                             'Defaults to -O2.')
+    parser.add_argument('--config', action='append',
+                        choices=[c for c, _ in CONFIGS],
+                        help='run only this configuration; may be repeated.')
+    parser.add_argument('--format', choices=['json', 'csv'], default='json')
+    parser.add_argument('-o', '--output', metavar='PATH',
+                        help='write results here rather than to stdout.')
+    parser.add_argument('--out-dir', metavar='PATH',
+                        help='directory for build files; a temporary '
+                             'directory is used by default.')
+    parser.add_argument('-r', '--repeat', type=int, default=3,
+                        help='number of times to run each build.')
+    parser.add_argument('--scale', type=float, default=1.0,
+                        help='multiply the iteration count of each module.')
+    parser.add_argument('-l', '--list', action='store_true',
+                        help='list all modules and configurations.')
+    parser.add_argument('modules', metavar='module', nargs='*',
+                        help='modules to run; all by default.')
+    options = parser.parse_args(args)
+    options.cflags = options.cflags or ['-O2']
+
+    if options.list:
+        for name in sorted(MODULES):
+            print('module  %s' % name)
+        for config, cflags in CONFIGS:
+            print('config  %-20s %s' % (config, ' '.join(cflags)))
+        return 0
+
+    names = options.modules or sorted(MODULES)
+    for name in names:
+        if name not in MODULES:
+            parser.error('unknown module: %s' % name)
+
+    out_dir = options.out_dir or tempfile.mkdtemp(prefix='wasm2c-bench-')
+    results = []
+    try:
+        for name in names:
+            module_dir = os.path.join(out_dir, name)
+            os.makedirs(module_dir, exist_ok=True)
+            results += RunModule(options, name, module_dir)
+    finally:
+        if not options.out_dir:
+            shutil.rmtree(out_dir)
+
+    if options.output:
+        with open(options.output, 'w') as f:
+            Write(options, results, f)
+    else:
+        Write(options, results, sys.stdout)
+    return 0
+
+
+if __name__ == '__main__':
+    try:
+        sys.exit(main(sys.argv[1:]))
+    except Error as e:
+        sys.stderr.write(str(e) + '\n')
+        sys.exit(1)
@@ -28,6 +28,8 @@ static WASM_RT_THREAD_LOCAL uint32_t g_active_exception_size;
 
 static WASM_RT_THREAD_LOCAL wasm_rt_jmp_buf* g_unwind_target;
 
+WASM_RT_THREAD_LOCAL bool wasm_rt_exception_pending;
+
 void wasm_rt_load_exception(const wasm_rt_tag_t tag,
                             uint32_t size,
                             const void* values) {
@@ -40,6 +40,14 @@ void wasm_rt_load_exception(const wasm_rt_tag_t tag,
  */
 WASM_RT_NO_RETURN void wasm_rt_throw(void);
 
+/**
+ * Whether the active exception is propagating through code generated with
+ * `wasm2c --exception-lowering=checked`. That code reports a throw it doesn't
+ * catch by setting this flag and returning, and tests it after every call.
+ * Exported functions turn a pending exception back into `wasm_rt_throw()`.
+ */
+extern WASM_RT_THREAD_LOCAL bool wasm_rt_exception_pending;
+
 /**
  * The type of an unwind target if an exception is thrown and caught.
  */
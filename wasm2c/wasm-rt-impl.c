@@ -14,6 +14,12 @@
  * limitations under the License.
  */
 
+/* pthread_getattr_np() is a GNU extension. */
+#if defined(WASM_RT_STACK_POINTER_CHECK) && WASM_RT_STACK_POINTER_CHECK && \
+    defined(__linux__) && !defined(_GNU_SOURCE)
+#define _GNU_SOURCE
+#endif
+
 #include "wasm-rt-impl.h"
 
 #include <assert.h>
@@ -36,6 +42,30 @@
 #include <sys/mman.h>
 #endif
 
+#if WASM_RT_STACK_POINTER_CHECK && !defined(_WIN32)
+#include <pthread.h>
+#endif
+
+#ifdef WASM_RT_C11_AVAILABLE
+#include <stdatomic.h>
+#include <time.h>
+#if WASM_RT_USE_PTHREADS
+#include <errno.h>
+#endif
+#ifndef WASM_RT_USE_FUTEX
+#ifdef __linux__
+#define WASM_RT_USE_FUTEX 1
+#else
+#define WASM_RT_USE_FUTEX 0
+#endif
+#endif
+#if WASM_RT_USE_FUTEX
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+#endif
+
 #ifndef NDEBUG
 #define DEBUG_PRINTF(...) fprintf(stderr, __VA_ARGS__);
 #else
@@ -75,6 +105,8 @@ WASM_RT_THREAD_LOCAL uint32_t wasm_rt_call_stack_depth;
 WASM_RT_THREAD_LOCAL uint32_t wasm_rt_saved_call_stack_depth;
 #elif WASM_RT_STACK_EXHAUSTION_HANDLER
 static WASM_RT_THREAD_LOCAL void* g_alt_stack = NULL;
+#elif WASM_RT_STACK_POINTER_CHECK
+WASM_RT_THREAD_LOCAL uintptr_t wasm_rt_stack_limit;
 #endif
 
 #ifndef WASM_RT_TRAP_HANDLER
@@ -236,8 +268,318 @@ static void os_disable_and_deallocate_altstack(void) {
 
 #endif
 
+#ifdef WASM_RT_C11_AVAILABLE
+
+/*
+ * Wait queues for memory.atomic.wait and memory.atomic.notify. Waiters are
+ * hashed by address into a fixed table of buckets, each with a lock and a
+ * FIFO list of the threads waiting on addresses in that bucket. The value
+ * check in wait and the dequeue in notify both happen under the bucket lock,
+ * so a notify that follows a store can't be lost.
+ *
+ * On Linux each waiter sleeps on a futex word of its own, so notify wakes
+ * exactly the threads it dequeues. Elsewhere waiters sleep on the bucket's
+ * condition variable.
+ */
+#define WAIT_QUEUE_BUCKETS 64
+
+typedef struct wasm_rt_waiter_t {
+  volatile void* addr;
+  struct wasm_rt_waiter_t* next;
+  _Atomic uint32_t woken;
+} wasm_rt_waiter_t;
+
+typedef struct {
+  WASM_RT_MUTEX lock;
+#if !WASM_RT_USE_FUTEX
+#if WASM_RT_USE_C11THREADS
+  cnd_t cond;
+#elif WASM_RT_USE_PTHREADS
+  pthread_cond_t cond;
+#elif WASM_RT_USE_CRITICALSECTION
+  CONDITION_VARIABLE cond;
+#endif
+#endif
+  wasm_rt_waiter_t* head;
+} wasm_rt_wait_queue_t;
+
+static wasm_rt_wait_queue_t g_wait_queues[WAIT_QUEUE_BUCKETS];
+static bool g_wait_queues_initialized = false;
+
+static wasm_rt_wait_queue_t* get_wait_queue(volatile void* addr) {
+  uintptr_t key = (uintptr_t)addr;
+  /* Waits are aligned to at least 4 bytes, so skip the low bits. */
+  key = (key >> 2) ^ (key >> 12);
+  return &g_wait_queues[key % WAIT_QUEUE_BUCKETS];
+}
+
+static void wait_queue_abort(const char* msg) {
+  fprintf(stderr, "%s\n", msg);
+  abort();
+}
+
+/* Current time in nanoseconds, on the clock the platform's timed wait uses. */
+static uint64_t wait_queue_now(void) {
+#if WASM_RT_USE_FUTEX
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000u + ts.tv_nsec;
+#elif WASM_RT_USE_C11THREADS
+  struct timespec ts;
+  timespec_get(&ts, TIME_UTC);
+  return (uint64_t)ts.tv_sec * 1000000000u + ts.tv_nsec;
+#elif WASM_RT_USE_PTHREADS
+  struct timespec ts;
+  clock_gettime(CLOCK_REALTIME, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000u + ts.tv_nsec;
+#elif WASM_RT_USE_CRITICALSECTION
+  return (uint64_t)GetTickCount64() * 1000000u;
+#endif
+}
+
+static void wait_queue_init(wasm_rt_wait_queue_t* queue) {
+  queue->head = NULL;
+#if WASM_RT_USE_C11THREADS
+  if (mtx_init(&queue->lock, mtx_plain) != thrd_success) {
+    wait_queue_abort("Lock init failed");
+  }
+#if !WASM_RT_USE_FUTEX
+  if (cnd_init(&queue->cond) != thrd_success) {
+    wait_queue_abort("Condition variable init failed");
+  }
+#endif
+#elif WASM_RT_USE_PTHREADS
+  if (pthread_mutex_init(&queue->lock, NULL) != 0) {
+    wait_queue_abort("Lock init failed");
+  }
+#if !WASM_RT_USE_FUTEX
+  if (pthread_cond_init(&queue->cond, NULL) != 0) {
+    wait_queue_abort("Condition variable init failed");
+  }
+#endif
+#elif WASM_RT_USE_CRITICALSECTION
+  InitializeCriticalSection(&queue->lock);
+  InitializeConditionVariable(&queue->cond);
+#endif
+}
+
+static void wait_queue_destroy(wasm_rt_wait_queue_t* queue) {
+  assert(!queue->head && "wasm-rt error: freed runtime with waiting threads");
+#if WASM_RT_USE_C11THREADS
+  mtx_destroy(&queue->lock);
+#if !WASM_RT_USE_FUTEX
+  cnd_destroy(&queue->cond);
+#endif
+#elif WASM_RT_USE_PTHREADS
+  pthread_mutex_destroy(&queue->lock);
+#if !WASM_RT_USE_FUTEX
+  pthread_cond_destroy(&queue->cond);
+#endif
+#elif WASM_RT_USE_CRITICALSECTION
+  DeleteCriticalSection(&queue->lock);
+#endif
+}
+
+static void wait_queue_lock(wasm_rt_wait_queue_t* queue) {
+#if WASM_RT_USE_C11THREADS
+  if (mtx_lock(&queue->lock) != thrd_success) {
+    wait_queue_abort("Lock acquire failed");
+  }
+#elif WASM_RT_USE_PTHREADS
+  if (pthread_mutex_lock(&queue->lock) != 0) {
+    wait_queue_abort("Lock acquire failed");
+  }
+#elif WASM_RT_USE_CRITICALSECTION
+  EnterCriticalSection(&queue->lock);
+#endif
+}
+
+static void wait_queue_unlock(wasm_rt_wait_queue_t* queue) {
+#if WASM_RT_USE_C11THREADS
+  if (mtx_unlock(&queue->lock) != thrd_success) {
+    wait_queue_abort("Lock release failed");
+  }
+#elif WASM_RT_USE_PTHREADS
+  if (pthread_mutex_unlock(&queue->lock) != 0) {
+    wait_queue_abort("Lock release failed");
+  }
+#elif WASM_RT_USE_CRITICALSECTION
+  LeaveCriticalSection(&queue->lock);
+#endif
+}
+
+/*
+ * Sleep until `waiter` is woken or `deadline` passes (never, if `forever`).
+ * On Linux this is called without the bucket lock held; elsewhere with it.
+ */
+static void wait_queue_sleep(wasm_rt_wait_queue_t* queue,
+                             wasm_rt_waiter_t* waiter,
+                             bool forever,
+                             uint64_t deadline) {
+  while (!atomic_load(&waiter->woken)) {
+    uint64_t remaining = 0;
+    if (!forever) {
+      uint64_t now = wait_queue_now();
+      if (now >= deadline) {
+        return;
+      }
+      remaining = deadline - now;
+    }
+#if WASM_RT_USE_FUTEX
+    (void)queue;
+    struct timespec ts;
+    ts.tv_sec = remaining / 1000000000u;
+    ts.tv_nsec = remaining % 1000000000u;
+    /* Returns early on a wake, a signal, or if `woken` is already set. */
+    syscall(SYS_futex, &waiter->woken, FUTEX_WAIT_PRIVATE, 0,
+            forever ? NULL : &ts, NULL, 0);
+#elif WASM_RT_USE_C11THREADS
+    if (forever) {
+      cnd_wait(&queue->cond, &queue->lock);
+    } else {
+      struct timespec ts;
+      ts.tv_sec = deadline / 1000000000u;
+      ts.tv_nsec = deadline % 1000000000u;
+      cnd_timedwait(&queue->cond, &queue->lock, &ts);
+    }
+#elif WASM_RT_USE_PTHREADS
+    if (forever) {
+      pthread_cond_wait(&queue->cond, &queue->lock);
+    } else {
+      struct timespec ts;
+      ts.tv_sec = deadline / 1000000000u;
+      ts.tv_nsec = deadline % 1000000000u;
+      pthread_cond_timedwait(&queue->cond, &queue->lock, &ts);
+    }
+#elif WASM_RT_USE_CRITICALSECTION
+    /* Round up, so we don't spin on a sub-millisecond remainder. */
+    DWORD ms = forever ? INFINITE
+                       : (DWORD)((remaining + 999999u) / 1000000u);
+    SleepConditionVariableCS(&queue->cond, &queue->lock, ms);
+#endif
+  }
+}
+
+/* Called with the bucket lock held, once the value has been checked. */
+static uint32_t wait_queue_wait(wasm_rt_wait_queue_t* queue,
+                                volatile void* addr,
+                                int64_t timeout) {
+  wasm_rt_waiter_t waiter;
+  waiter.addr = addr;
+  waiter.next = NULL;
+  atomic_init(&waiter.woken, 0);
+
+  wasm_rt_waiter_t** link = &queue->head;
+  while (*link) {
+    link = &(*link)->next;
+  }
+  *link = &waiter;
+
+  bool forever = timeout < 0;
+  uint64_t deadline = forever ? 0 : wait_queue_now() + (uint64_t)timeout;
+#if WASM_RT_USE_FUTEX
+  wait_queue_unlock(queue);
+  wait_queue_sleep(queue, &waiter, forever, deadline);
+  wait_queue_lock(queue);
+#else
+  wait_queue_sleep(queue, &waiter, forever, deadline);
+#endif
+
+  uint32_t result = 0;
+  if (!atomic_load(&waiter.woken)) {
+    /* Timed out, so no notify dequeued us; do it ourselves. */
+    for (link = &queue->head; *link != &waiter; link = &(*link)->next) {
+    }
+    *link = waiter.next;
+    result = 2;
+  }
+  wait_queue_unlock(queue);
+  return result;
+}
+
+uint32_t wasm_rt_atomic_wait32(_Atomic volatile uint32_t* addr,
+                               uint32_t expected,
+                               int64_t timeout) {
+  wasm_rt_wait_queue_t* queue = get_wait_queue(addr);
+  wait_queue_lock(queue);
+  if (atomic_load(addr) != expected) {
+    wait_queue_unlock(queue);
+    return 1;
+  }
+  return wait_queue_wait(queue, addr, timeout);
+}
+
+uint32_t wasm_rt_atomic_wait64(_Atomic volatile uint64_t* addr,
+                               uint64_t expected,
+                               int64_t timeout) {
+  wasm_rt_wait_queue_t* queue = get_wait_queue(addr);
+  wait_queue_lock(queue);
+  if (atomic_load(addr) != expected) {
+    wait_queue_unlock(queue);
+    return 1;
+  }
+  return wait_queue_wait(queue, addr, timeout);
+}
+
+uint32_t wasm_rt_atomic_notify(volatile void* addr, uint32_t count) {
+  wasm_rt_wait_queue_t* queue = get_wait_queue(addr);
+  uint32_t woken = 0;
+  wait_queue_lock(queue);
+  wasm_rt_waiter_t** link = &queue->head;
+  while (*link && woken < count) {
+    wasm_rt_waiter_t* waiter = *link;
+    if (waiter->addr != addr) {
+      link = &waiter->next;
+      continue;
+    }
+    *link = waiter->next;
+    /* The waiter can't return (and free `waiter`) until we drop the lock. */
+    atomic_store(&waiter->woken, 1);
+#if WASM_RT_USE_FUTEX
+    syscall(SYS_futex, &waiter->woken, FUTEX_WAKE_PRIVATE, 1, NULL, NULL, 0);
+#endif
+    woken++;
+  }
+#if !WASM_RT_USE_FUTEX
+  if (woken) {
+#if WASM_RT_USE_C11THREADS
+    cnd_broadcast(&queue->cond);
+#elif WASM_RT_USE_PTHREADS
+    pthread_cond_broadcast(&queue->cond);
+#elif WASM_RT_USE_CRITICALSECTION
+    WakeAllConditionVariable(&queue->cond);
+#endif
+  }
+#endif
+  wait_queue_unlock(queue);
+  return woken;
+}
+
+static void os_init_wait_queues(void) {
+  if (!g_wait_queues_initialized) {
+    g_wait_queues_initialized = true;
+    for (int i = 0; i < WAIT_QUEUE_BUCKETS; ++i) {
+      wait_queue_init(&g_wait_queues[i]);
+    }
+  }
+}
+
+static void os_free_wait_queues(void) {
+  if (g_wait_queues_initialized) {
+    g_wait_queues_initialized = false;
+    for (int i = 0; i < WAIT_QUEUE_BUCKETS; ++i) {
+      wait_queue_destroy(&g_wait_queues[i]);
+    }
+  }
+}
+
+#endif
+
 void wasm_rt_init(void) {
   wasm_rt_init_thread();
+#ifdef WASM_RT_C11_AVAILABLE
+  os_init_wait_queues();
+#endif
 #if WASM_RT_INSTALL_SIGNAL_HANDLER
   if (!g_signal_handler_installed) {
     g_signal_handler_installed = true;
@@ -274,13 +616,50 @@ void wasm_rt_free(void) {
 #if WASM_RT_INSTALL_SIGNAL_HANDLER
   os_cleanup_signal_handler();
   g_signal_handler_installed = false;
+#endif
+#ifdef WASM_RT_C11_AVAILABLE
+  os_free_wait_queues();
 #endif
   wasm_rt_free_thread();
 }
 
+#if WASM_RT_STACK_POINTER_CHECK
+/* Returns the lowest address of the current thread's stack. */
+static uintptr_t os_get_stack_low(void) {
+#if defined(_WIN32)
+  ULONG_PTR low, high;
+  GetCurrentThreadStackLimits(&low, &high);
+  return low;
+#elif defined(__APPLE__)
+  pthread_t self = pthread_self();
+  return (uintptr_t)pthread_get_stackaddr_np(self) -
+         pthread_get_stacksize_np(self);
+#elif defined(__linux__)
+  pthread_attr_t attr;
+  void* addr;
+  size_t size;
+  if (pthread_getattr_np(pthread_self(), &attr) != 0) {
+    perror("pthread_getattr_np failed");
+    abort();
+  }
+  if (pthread_attr_getstack(&attr, &addr, &size) != 0) {
+    perror("pthread_attr_getstack failed");
+    abort();
+  }
+  pthread_attr_destroy(&attr);
+  return (uintptr_t)addr;
+#else
+  /* Assume a small thread stack, starting near the current frame. */
+  return WASM_RT_STACK_POINTER() - 512 * 1024;
+#endif
+}
+#endif
+
 void wasm_rt_init_thread(void) {
 #if WASM_RT_STACK_EXHAUSTION_HANDLER
   os_allocate_and_install_altstack();
+#elif WASM_RT_STACK_POINTER_CHECK
+  wasm_rt_stack_limit = os_get_stack_low() + WASM_RT_STACK_RESERVE;
 #endif
 }
 
@@ -344,6 +723,8 @@ const char* wasm_rt_strerror(wasm_rt_trap_t trap) {
       return "Uncaught exception";
     case WASM_RT_TRAP_UNALIGNED:
       return "Unaligned atomic memory access";
+    case WASM_RT_TRAP_WAIT_UNSHARED:
+      return "Wait on unshared memory";
     case WASM_RT_TRAP_NULL_REF:
       return "Null reference";
   }
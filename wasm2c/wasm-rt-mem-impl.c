@@ -19,12 +19,28 @@
 #include <assert.h>
 #include <stdio.h>
 
+#ifdef WASM_RT_C11_AVAILABLE
+#include <stdatomic.h>
+#endif
+
 #ifdef _WIN32
 #include <windows.h>
 #else
 #include <sys/mman.h>
 #endif
 
+#if WASM_RT_USE_MEMORY_IMAGES && !defined(_WIN32)
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#ifdef __linux__
+#include <sys/syscall.h>
+#ifndef MFD_CLOEXEC
+#define MFD_CLOEXEC 1U
+#endif
+#endif
+#endif
+
 #define WASM_PAGE_SIZE 65536
 
 #ifdef WASM_RT_GROW_FAILED_HANDLER
@@ -136,8 +152,22 @@ static void os_print_last_error(const char* msg) {
 
 #endif
 
+/* The largest size a memory64 can grow to in place. */
+static uint64_t get_memory64_reservation(uint64_t max_pages) {
+  const uint64_t max_reserved_pages =
+      WASM_RT_MEMORY64_MAX_RESERVATION / WASM_PAGE_SIZE;
+  if (max_pages > max_reserved_pages) {
+    return max_reserved_pages * WASM_PAGE_SIZE;
+  }
+  return max_pages * WASM_PAGE_SIZE;
+}
+
 static uint64_t get_alloc_size_for_mmap(uint64_t max_pages, bool is64) {
-  assert(!is64 && "memory64 is not yet compatible with WASM_RT_USE_MMAP");
+  if (is64) {
+    /* memory64 accesses are only checked to start in bounds, so an access at
+     * the end of a fully grown memory must still hit inaccessible pages. */
+    return get_memory64_reservation(max_pages) + WASM_RT_MEMORY64_GUARD_SIZE;
+  }
 #if WASM_RT_MEMCHECK_GUARD_PAGES
   /* Reserve 8GiB. */
   const uint64_t max_size = 0x200000000ul;
@@ -156,11 +186,155 @@ static uint64_t get_alloc_size_for_mmap(uint64_t max_pages, bool is64) {
 
 #endif
 
+#ifdef WASM_RT_C11_AVAILABLE
+/* The number of pages a shared memory of `pages` pages, allocated without
+ * mmap, can grow to. */
+static uint64_t get_shared_memory_reserved_pages(uint64_t pages,
+                                                 uint64_t max_pages) {
+  uint64_t reserved_pages =
+      WASM_RT_SHARED_MEMORY_MAX_RESERVATION / WASM_PAGE_SIZE;
+  if (max_pages < reserved_pages) {
+    reserved_pages = max_pages;
+  }
+  return pages > reserved_pages ? pages : reserved_pages;
+}
+#endif
+
 // Include operations for memory
 #define WASM_RT_MEM_OPS
 #include "wasm-rt-mem-impl-helper.inc"
 #undef WASM_RT_MEM_OPS
 
+#if WASM_RT_USE_MEMORY_IMAGES
+
+#ifdef _WIN32
+static intptr_t os_create_image(const uint8_t* data, uint64_t size) {
+  /* Mapping a file view into a reserved range needs placeholder support, so
+   * just keep copying the data segments. */
+  (void)data;
+  (void)size;
+  return -1;
+}
+
+static bool os_map_image(uint8_t* addr, intptr_t image, uint64_t size) {
+  (void)addr;
+  (void)image;
+  (void)size;
+  return false;
+}
+
+static void os_close_image(intptr_t image) {
+  (void)image;
+}
+#else
+static bool is_zero(const uint8_t* data, size_t size) {
+  return size == 0 || (data[0] == 0 && memcmp(data, data + 1, size - 1) == 0);
+}
+
+/* Creates an anonymous file holding `size` bytes of `data`, and returns its
+ * descriptor, or -1. Pages of zeroes are left as holes, so the file only takes
+ * up as much memory as the data segments do. */
+static intptr_t os_create_image(const uint8_t* data, uint64_t size) {
+  int fd = -1;
+#if defined(__linux__) && defined(SYS_memfd_create)
+  fd = syscall(SYS_memfd_create, "wasm-rt-memory-image", MFD_CLOEXEC);
+#endif
+  if (fd < 0) {
+    char path[] = "/tmp/wasm-rt-memory-image-XXXXXX";
+    fd = mkstemp(path);
+    if (fd < 0) {
+      return -1;
+    }
+    unlink(path);
+  }
+  if (ftruncate(fd, size) != 0) {
+    close(fd);
+    return -1;
+  }
+  for (uint64_t offset = 0; offset < size; offset += WASM_PAGE_SIZE) {
+    const uint8_t* page = data + offset;
+    if (is_zero(page, WASM_PAGE_SIZE)) {
+      continue;
+    }
+    for (size_t written = 0; written < WASM_PAGE_SIZE;) {
+      ssize_t n = pwrite(fd, page + written, WASM_PAGE_SIZE - written,
+                         offset + written);
+      if (n <= 0) {
+        close(fd);
+        return -1;
+      }
+      written += n;
+    }
+  }
+  return fd;
+}
+
+/* Replaces the first `size` bytes of a memory with a private mapping of the
+ * image, so pages are only copied when they're written. */
+static bool os_map_image(uint8_t* addr, intptr_t image, uint64_t size) {
+  if (size == 0) {
+    return true;
+  }
+  void* ret = mmap(addr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_FIXED,
+                   (int)image, 0);
+  return ret == addr;
+}
+
+static void os_close_image(intptr_t image) {
+  close((int)image);
+}
+#endif
+
+static intptr_t load_image_handle(wasm_rt_memory_image_t* image) {
+#ifdef WASM_RT_C11_AVAILABLE
+  return atomic_load_explicit((_Atomic intptr_t*)&image->handle,
+                              memory_order_acquire);
+#else
+  return image->handle;
+#endif
+}
+
+bool wasm_rt_allocate_memory_from_image(wasm_rt_memory_t* memory,
+                                        wasm_rt_memory_image_t* image,
+                                        uint64_t initial_pages,
+                                        uint64_t max_pages,
+                                        bool is64) {
+  wasm_rt_allocate_memory(memory, initial_pages, max_pages, is64);
+  intptr_t handle = load_image_handle(image);
+  if (handle == 0) {
+    return false;
+  }
+  if (!os_map_image(memory->data, handle - 1, memory->size)) {
+    os_print_last_error("os_map_image failed.");
+    abort();
+  }
+  return true;
+}
+
+void wasm_rt_capture_memory_image(wasm_rt_memory_image_t* image,
+                                  const wasm_rt_memory_t* memory) {
+  if (load_image_handle(image) != 0) {
+    return;
+  }
+  intptr_t handle = os_create_image(memory->data, memory->size);
+  if (handle < 0) {
+    return;
+  }
+  /* Instances may be created on several threads at once; only the first
+   * image captured is kept. */
+#ifdef WASM_RT_C11_AVAILABLE
+  intptr_t expected = 0;
+  if (!atomic_compare_exchange_strong((_Atomic intptr_t*)&image->handle,
+                                      &expected, handle + 1)) {
+    os_close_image(handle);
+  }
+#else
+  image->handle = handle + 1;
+#endif
+}
+
+#endif
+
 // Include operations for shared memory
 #define WASM_RT_MEM_OPS_SHARED
 #include "wasm-rt-mem-impl-helper.inc"
@@ -124,9 +124,12 @@ extern "C" {
  * consumed only as needed, but may relocate the memory to handle memory
  * fragmentation.
  *
- * This defaults to malloc on 32-bit platforms or if memory64 support is needed.
- * It defaults to mmap on 64-bit platforms assuming memory64 support is not
- * needed (so we can use the guard based range checks below).
+ * This defaults to malloc on 32-bit platforms, and to mmap on 64-bit platforms
+ * (so we can use the guard based range checks below).
+ *
+ * Shared memories never move, so that other threads can keep accessing them
+ * while they grow: with malloc, they are allocated up front (see
+ * WASM_RT_SHARED_MEMORY_MAX_RESERVATION).
  */
 #ifndef WASM_RT_USE_MMAP
 #if UINTPTR_MAX > 0xffffffff
@@ -136,17 +139,92 @@ extern "C" {
 #endif
 #endif
 
+/**
+ * With WASM_RT_USE_MMAP, each memory64 is reserved up front at the smaller of
+ * its declared maximum and WASM_RT_MEMORY64_MAX_RESERVATION bytes, then
+ * committed in place as it grows; growing past the reservation fails. The
+ * reservation is followed by WASM_RT_MEMORY64_GUARD_SIZE bytes of inaccessible
+ * guard region, which must be at least as large as the widest access (16
+ * bytes) for the GUARD_PAGES checks below.
+ */
+#ifndef WASM_RT_MEMORY64_MAX_RESERVATION
+#if UINTPTR_MAX > 0xffffffff
+#define WASM_RT_MEMORY64_MAX_RESERVATION 0x1000000000ull /* 64GiB */
+#else
+#define WASM_RT_MEMORY64_MAX_RESERVATION 0x40000000ull /* 1GiB */
+#endif
+#endif
+
+#ifndef WASM_RT_MEMORY64_GUARD_SIZE
+#define WASM_RT_MEMORY64_GUARD_SIZE 0x10000ull /* 64KiB */
+#endif
+
+/**
+ * Without WASM_RT_USE_MMAP, each shared memory is allocated up front at the
+ * smaller of its declared maximum and WASM_RT_SHARED_MEMORY_MAX_RESERVATION
+ * bytes, or at its initial size if that is larger; growing past the
+ * allocation fails.
+ */
+#ifndef WASM_RT_SHARED_MEMORY_MAX_RESERVATION
+#if UINTPTR_MAX > 0xffffffff
+#define WASM_RT_SHARED_MEMORY_MAX_RESERVATION 0x40000000ull /* 1GiB */
+#else
+#define WASM_RT_SHARED_MEMORY_MAX_RESERVATION 0x10000000ull /* 256MiB */
+#endif
+#endif
+
+/**
+ * If enabled, tables reserve address space for their maximum size up front and
+ * are committed in place as they grow, rather than being reallocated. Their
+ * `data` pointer then never changes, so threads that share an instance can
+ * read a table while another thread grows it. Tables are reserved at the
+ * smaller of their declared maximum and WASM_RT_TABLE_MAX_RESERVATION
+ * elements; growing past the reservation fails. This requires
+ * WASM_RT_USE_MMAP.
+ */
+#ifndef WASM_RT_NONMOVING_TABLES
+#define WASM_RT_NONMOVING_TABLES 0
+#endif
+
+#ifndef WASM_RT_TABLE_MAX_RESERVATION
+#define WASM_RT_TABLE_MAX_RESERVATION 0x100000u /* 1Mi elements */
+#endif
+
+#if WASM_RT_NONMOVING_TABLES && !WASM_RT_USE_MMAP
+#error "WASM_RT_NONMOVING_TABLES requires WASM_RT_USE_MMAP"
+#endif
+
+/**
+ * If enabled, each memory whose active data segments are all at constant
+ * offsets within its initial size is initialized from an image: the first
+ * instance loads the data segments and captures the result (on Linux in a
+ * memfd), and later instances map the image copy-on-write rather than copying
+ * the data segments again. Creating an instance then costs time proportional
+ * to the pages it touches, not to the size of its data. This requires
+ * WASM_RT_USE_MMAP and a little-endian host. On Windows, images are never
+ * captured, so the data segments are always copied.
+ */
+#ifndef WASM_RT_USE_MEMORY_IMAGES
+#define WASM_RT_USE_MEMORY_IMAGES 0
+#endif
+
+#if WASM_RT_USE_MEMORY_IMAGES && (!WASM_RT_USE_MMAP || WABT_BIG_ENDIAN)
+#error "WASM_RT_USE_MEMORY_IMAGES requires WASM_RT_USE_MMAP and a little-endian host"
+#endif
+
 /**
  * Set the range checking strategy for Wasm memories.
  *
  * GUARD_PAGES:  memory accesses rely on unmapped pages/guard pages to trap
- * out-of-bound accesses.
+ * out-of-bound accesses. 32-bit memories need no checks at all; memory64
+ * accesses only check that the access starts in bounds, and rely on the guard
+ * region to trap if it runs past the end.
  *
  * BOUNDS_CHECK: memory accesses are checked with explicit bounds checks.
  *
  * This defaults to GUARD_PAGES as this is the fasest option, iff the
  * requirements of GUARD_PAGES --- 64-bit platforms, MMAP allocation strategy,
- * no 64-bit memories, no big-endian --- are met. This falls back to BOUNDS
+ * no big-endian --- are met. This falls back to BOUNDS
  * otherwise.
  */
 
@@ -270,9 +348,13 @@ extern "C" {
  * We need to detect and trap stack overflows. If we use a signal handler on
  * POSIX systems, this can detect call stack overflows. On windows, or platforms
  * without a signal handler, we use stack depth counting.
+ *
+ * Alternatively, WASM_RT_STACK_POINTER_CHECK compares the native stack pointer
+ * against a per-thread limit, only in functions that may recurse.
  */
 #if !defined(WASM_RT_STACK_DEPTH_COUNT) &&        \
     !defined(WASM_RT_STACK_EXHAUSTION_HANDLER) && \
+    !defined(WASM_RT_STACK_POINTER_CHECK) &&      \
     !WASM_RT_NONCONFORMING_UNCHECKED_STACK_EXHAUSTION
 
 #if WASM_RT_INSTALL_SIGNAL_HANDLER && !defined(_WIN32)
@@ -290,22 +372,28 @@ extern "C" {
 #ifndef WASM_RT_STACK_EXHAUSTION_HANDLER
 #define WASM_RT_STACK_EXHAUSTION_HANDLER 0
 #endif
+#ifndef WASM_RT_STACK_POINTER_CHECK
+#define WASM_RT_STACK_POINTER_CHECK 0
+#endif
 
 #if WASM_RT_NONCONFORMING_UNCHECKED_STACK_EXHAUSTION
 
-#if (WASM_RT_STACK_EXHAUSTION_HANDLER + WASM_RT_STACK_DEPTH_COUNT) != 0
+#if (WASM_RT_STACK_EXHAUSTION_HANDLER + WASM_RT_STACK_DEPTH_COUNT + \
+     WASM_RT_STACK_POINTER_CHECK) != 0
 #error \
-    "Cannot specify WASM_RT_NONCONFORMING_UNCHECKED_STACK_EXHAUSTION along with WASM_RT_STACK_EXHAUSTION_HANDLER or WASM_RT_STACK_DEPTH_COUNT"
+    "Cannot specify WASM_RT_NONCONFORMING_UNCHECKED_STACK_EXHAUSTION along with WASM_RT_STACK_EXHAUSTION_HANDLER, WASM_RT_STACK_DEPTH_COUNT or WASM_RT_STACK_POINTER_CHECK"
 #endif
 
 #else
 
-#if (WASM_RT_STACK_EXHAUSTION_HANDLER + WASM_RT_STACK_DEPTH_COUNT) > 1
+#if (WASM_RT_STACK_EXHAUSTION_HANDLER + WASM_RT_STACK_DEPTH_COUNT + \
+     WASM_RT_STACK_POINTER_CHECK) > 1
 #error \
-    "Cannot specify multiple options from WASM_RT_STACK_EXHAUSTION_HANDLER , WASM_RT_STACK_DEPTH_COUNT"
-#elif (WASM_RT_STACK_EXHAUSTION_HANDLER + WASM_RT_STACK_DEPTH_COUNT) == 0
+    "Cannot specify multiple options from WASM_RT_STACK_EXHAUSTION_HANDLER , WASM_RT_STACK_DEPTH_COUNT , WASM_RT_STACK_POINTER_CHECK"
+#elif (WASM_RT_STACK_EXHAUSTION_HANDLER + WASM_RT_STACK_DEPTH_COUNT + \
+       WASM_RT_STACK_POINTER_CHECK) == 0
 #error \
-    "Must specify one of WASM_RT_STACK_EXHAUSTION_HANDLER , WASM_RT_STACK_DEPTH_COUNT"
+    "Must specify one of WASM_RT_STACK_EXHAUSTION_HANDLER , WASM_RT_STACK_DEPTH_COUNT , WASM_RT_STACK_POINTER_CHECK"
 #endif
 
 #endif
@@ -335,6 +423,38 @@ extern WASM_RT_THREAD_LOCAL uint32_t wasm_rt_call_stack_depth;
 
 #endif
 
+#if WASM_RT_STACK_POINTER_CHECK
+/**
+ * Functions that may recurse trap once the native stack pointer drops below
+ * `wasm_rt_stack_limit`. `wasm_rt_init_thread` sets the limit this many bytes
+ * above the low end of the thread's stack, leaving room for the non-recursive
+ * calls between checks, host imports and trap handling. It can be configured
+ * when building the runtime, for example:
+ *
+ * ```
+ *   cc -c -DWASM_RT_STACK_RESERVE=65536 wasm-rt-impl.c -o wasm-rt-impl.o
+ * ```
+ */
+#ifndef WASM_RT_STACK_RESERVE
+#define WASM_RT_STACK_RESERVE (256 * 1024)
+#endif
+
+/**
+ * Lowest stack address recursive functions may use on this thread. Embedders
+ * that run wasm code on a stack they allocated themselves (e.g. a coroutine)
+ * should set this while that stack is in use.
+ */
+extern WASM_RT_THREAD_LOCAL uintptr_t wasm_rt_stack_limit;
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#define WASM_RT_STACK_POINTER() ((uintptr_t)_AddressOfReturnAddress())
+#else
+#define WASM_RT_STACK_POINTER() ((uintptr_t)__builtin_frame_address(0))
+#endif
+
+#endif
+
 #if WASM_RT_USE_SEGUE
 /**
  * The segue optimization uses x86 segments to point to a linear memory. If
@@ -388,6 +508,7 @@ typedef enum {
   WASM_RT_TRAP_NULL_REF,           /** Null reference. */
   WASM_RT_TRAP_UNCAUGHT_EXCEPTION, /** Exception thrown and not caught. */
   WASM_RT_TRAP_UNALIGNED,          /** Unaligned atomic instruction executed. */
+  WASM_RT_TRAP_WAIT_UNSHARED,      /** memory.atomic.wait on unshared memory. */
 #if WASM_RT_MERGED_OOB_AND_EXHAUSTION_TRAPS
   WASM_RT_TRAP_EXHAUSTION = WASM_RT_TRAP_OOB,
 #else
@@ -507,7 +628,12 @@ typedef struct {
   uint64_t size;
   /** Is this memory indexed by u64 (as opposed to default u32) */
   bool is64;
-  /** Lock used to ensure operations such as memory grow are threadsafe */
+  /**
+   * Lock used to ensure operations such as memory grow are threadsafe. Only
+   * threads growing the memory take it: `data` never moves, and `size` and
+   * then `pages` are published with release stores once the new pages are
+   * accessible.
+   */
   WASM_RT_MUTEX mem_lock;
 } wasm_rt_shared_memory_t;
 #endif
@@ -566,16 +692,33 @@ typedef struct {
   bool initialized;
   /** jmp_buf contents */
   jmp_buf buffer;
+#if WASM_RT_STACK_DEPTH_COUNT
+  /** Call stack depth at the setjmp, restored by the longjmp. */
+  uint32_t call_stack_depth;
+#endif
 } wasm_rt_jmp_buf;
 
+#if WASM_RT_STACK_DEPTH_COUNT
+// A longjmp skips the FUNC_EPILOGUE of every frame it unwinds, so the depth
+// saved at the setjmp has to be restored, e.g. when an exception is caught.
+#define WASM_RT_SAVE_JMP_STACK_DEPTH(buf) \
+  ((buf).call_stack_depth = wasm_rt_call_stack_depth)
+#define WASM_RT_RESTORE_JMP_STACK_DEPTH(buf) \
+  (wasm_rt_call_stack_depth = (buf).call_stack_depth)
+#else
+#define WASM_RT_SAVE_JMP_STACK_DEPTH(buf) (void)0
+#define WASM_RT_RESTORE_JMP_STACK_DEPTH(buf) (void)0
+#endif
+
 #ifndef _WIN32
 #define WASM_RT_SETJMP_SETBUF(buf) sigsetjmp(buf, 1)
 #else
 #define WASM_RT_SETJMP_SETBUF(buf) setjmp(buf)
 #endif
 
-#define WASM_RT_SETJMP(buf) \
-  ((buf).initialized = true, WASM_RT_SETJMP_SETBUF((buf).buffer))
+#define WASM_RT_SETJMP(buf)                                     \
+  ((buf).initialized = true, WASM_RT_SAVE_JMP_STACK_DEPTH(buf), \
+   WASM_RT_SETJMP_SETBUF((buf).buffer))
 
 #ifndef _WIN32
 #define WASM_RT_LONGJMP_UNCHECKED(buf, val) siglongjmp(buf, val)
@@ -588,6 +731,7 @@ typedef struct {
   if (!((buf).initialized))                                         \
     abort();                                                        \
   (buf).initialized = false;                                        \
+  WASM_RT_RESTORE_JMP_STACK_DEPTH(buf);                             \
   WASM_RT_LONGJMP_UNCHECKED((buf).buffer, val)
 
 /**
@@ -639,6 +783,36 @@ uint64_t wasm_rt_grow_memory(wasm_rt_memory_t*, uint64_t pages);
 /** Free a Memory object. */
 void wasm_rt_free_memory(wasm_rt_memory_t*);
 
+#if WASM_RT_USE_MEMORY_IMAGES
+/**
+ * An image of a memory's initial contents, which every instance of a module
+ * maps copy-on-write. It must be zero-initialized (e.g. a static variable),
+ * and is never freed.
+ */
+typedef struct {
+  /** The image's file descriptor plus one, or 0 until it's captured. */
+  intptr_t handle;
+} wasm_rt_memory_image_t;
+
+/**
+ * Initialize a Memory object as wasm_rt_allocate_memory does, then map the
+ * contents of `image` into it copy-on-write. Returns false, leaving the memory
+ * zeroed, if the image hasn't been captured.
+ */
+bool wasm_rt_allocate_memory_from_image(wasm_rt_memory_t*,
+                                        wasm_rt_memory_image_t*,
+                                        uint64_t initial_pages,
+                                        uint64_t max_pages,
+                                        bool is64);
+
+/**
+ * Capture the contents of a Memory object into `image`, unless it has been
+ * captured already. If the image can't be created, it stays uncaptured.
+ */
+void wasm_rt_capture_memory_image(wasm_rt_memory_image_t*,
+                                  const wasm_rt_memory_t*);
+#endif
+
 #ifdef WASM_RT_C11_AVAILABLE
 /** Shared memory version of wasm_rt_allocate_memory */
 void wasm_rt_allocate_memory_shared(wasm_rt_shared_memory_t*,
@@ -651,6 +825,29 @@ uint64_t wasm_rt_grow_memory_shared(wasm_rt_shared_memory_t*, uint64_t pages);
 
 /** Shared memory version of wasm_rt_free_memory */
 void wasm_rt_free_memory_shared(wasm_rt_shared_memory_t*);
+
+/**
+ * Implement memory.atomic.wait32 and memory.atomic.wait64 on shared memory.
+ * If the value at `addr` equals `expected`, block until another thread calls
+ * `wasm_rt_atomic_notify` for the same address, or until `timeout`
+ * nanoseconds have passed (a negative timeout never expires).
+ *
+ * Returns 0 if woken by a notify, 1 if the value did not match, and 2 if the
+ * timeout expired.
+ */
+uint32_t wasm_rt_atomic_wait32(_Atomic volatile uint32_t* addr,
+                               uint32_t expected,
+                               int64_t timeout);
+uint32_t wasm_rt_atomic_wait64(_Atomic volatile uint64_t* addr,
+                               uint64_t expected,
+                               int64_t timeout);
+
+/**
+ * Implement memory.atomic.notify on shared memory: wake up to `count` threads
+ * waiting on `addr`, in the order they started waiting, and return the number
+ * of threads woken.
+ */
+uint32_t wasm_rt_atomic_notify(volatile void* addr, uint32_t count);
 #endif
 
 /**